@@ -1,4 +1,4 @@
-#version 410
+#version 420
 
 
 layout(location = 0) in vec4 inColor;
@@ -11,7 +11,25 @@ layout(location = 1) out vec3 outNormal;
 
 uniform sampler2D s_Albedo;
 
-uniform vec3  a_CameraPos;
+// The camera we're drawing from, see UniformBlocks.h
+layout(std140, binding = 0) uniform CameraBlock {
+	mat4  a_View;
+	mat4  a_Projection;
+	mat4  a_ViewProjection;
+	mat4  a_ViewInv;
+	mat4  a_ProjectionInv;
+	mat4  a_ViewProjectionInv;
+	mat4  a_PrevView;
+	mat4  a_PrevProjection;
+	mat4  a_PrevViewProjection;
+	mat4  a_PrevProjectionInv;
+	mat4  a_PrevViewProjectionInv;
+	vec3  a_CameraPos;
+	float a_Time;
+	float a_NearPlane;
+	float a_FarPlane;
+	vec2  a_OutputResolution;
+};
 
 uniform vec3  a_AmbientColor;
 uniform float a_AmbientPower;
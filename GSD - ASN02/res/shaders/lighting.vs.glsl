@@ -1,4 +1,4 @@
-#version 410
+#version 420
 
 layout (location = 0) in vec3 inPosition;
 layout (location = 1) in vec4 inColor;
@@ -10,17 +10,39 @@ layout (location = 1) out vec3 outNormal;
 layout (location = 2) out vec3 outWorldPos;
 layout (location = 3) out vec2 outUV;
 
-uniform mat4 a_ModelViewProjection;
-uniform mat4 a_Model;
-uniform mat4 a_ModelView;
-uniform mat3 a_NormalMatrix;
+// The camera we're drawing from, see UniformBlocks.h
+layout(std140, binding = 0) uniform CameraBlock {
+	mat4  a_View;
+	mat4  a_Projection;
+	mat4  a_ViewProjection;
+	mat4  a_ViewInv;
+	mat4  a_ProjectionInv;
+	mat4  a_ViewProjectionInv;
+	mat4  a_PrevView;
+	mat4  a_PrevProjection;
+	mat4  a_PrevViewProjection;
+	mat4  a_PrevProjectionInv;
+	mat4  a_PrevViewProjectionInv;
+	vec3  a_CameraPos;
+	float a_Time;
+	float a_NearPlane;
+	float a_FarPlane;
+	vec2  a_OutputResolution;
+};
+
+// The object being drawn, see UniformBlocks.h
+layout(std140, binding = 1) uniform ObjectBlock {
+	mat4 a_Model;
+	mat3 a_NormalMatrix;
+};
 
 void main() {
 	outColor = inColor;
 	outNormal = a_NormalMatrix * inNormal;
 	outColor = inColor;
-	outWorldPos =  (a_Model * vec4(inPosition, 1)).xyz;
-	gl_Position = a_ModelViewProjection * vec4(inPosition, 1);
+	vec4 worldPos = a_Model * vec4(inPosition, 1);
+	outWorldPos = worldPos.xyz;
+	gl_Position = a_ViewProjection * worldPos;
 
 	// New in tutorial 06
 	outUV = inUV;
@@ -0,0 +1,46 @@
+#version 420
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec4 inColor;
+layout (location = 2) in vec3 inNormal;
+layout (location = 5) in vec2 inUV;
+
+// Per-instance, see InstanceBuffer
+layout (location = 8) in mat4 inModel;
+layout (location = 12) in mat3 inNormalMatrix;
+
+layout (location = 0) out vec4 outColor;
+layout (location = 1) out vec3 outNormal;
+layout (location = 2) out vec3 outWorldPos;
+layout (location = 3) out vec2 outUV;
+
+// The camera we're drawing from, see UniformBlocks.h
+layout(std140, binding = 0) uniform CameraBlock {
+	mat4  a_View;
+	mat4  a_Projection;
+	mat4  a_ViewProjection;
+	mat4  a_ViewInv;
+	mat4  a_ProjectionInv;
+	mat4  a_ViewProjectionInv;
+	mat4  a_PrevView;
+	mat4  a_PrevProjection;
+	mat4  a_PrevViewProjection;
+	mat4  a_PrevProjectionInv;
+	mat4  a_PrevViewProjectionInv;
+	vec3  a_CameraPos;
+	float a_Time;
+	float a_NearPlane;
+	float a_FarPlane;
+	vec2  a_OutputResolution;
+};
+
+void main() {
+	vec4 worldPos = inModel * vec4(inPosition, 1);
+
+	outColor = inColor;
+	outNormal = inNormalMatrix * inNormal;
+	outWorldPos = worldPos.xyz;
+	gl_Position = a_ViewProjection * worldPos;
+
+	outUV = inUV;
+}
\ No newline at end of file
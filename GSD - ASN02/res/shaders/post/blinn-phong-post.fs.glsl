@@ -8,17 +8,44 @@ layout(location = 0) out vec4 outColor;
 layout(binding = 1) uniform sampler2D s_CameraDepth; // Camera's depth buffer
 layout(binding = 2) uniform sampler2D s_GNormal;     // The normal buffer
 
-// The inverse of the camera's view-project matrix (clip->world)
-uniform mat4 a_ViewProjectionInv;
-// The position of the camera, in world space
-uniform vec3 a_CameraPos;
-
-// The light's position, in world space
-uniform vec3  a_LightPos;
-// The light's color
-uniform vec3  a_LightColor;
-// The attenuation factor for the light (1/dist)
-uniform float a_LightAttenuation;
+// The camera the scene was drawn from, see UniformBlocks.h
+layout(std140, binding = 0) uniform CameraBlock {
+	mat4  a_View;
+	mat4  a_Projection;
+	mat4  a_ViewProjection;
+	mat4  a_ViewInv;
+	mat4  a_ProjectionInv;
+	mat4  a_ViewProjectionInv;
+	mat4  a_PrevView;
+	mat4  a_PrevProjection;
+	mat4  a_PrevViewProjection;
+	mat4  a_PrevProjectionInv;
+	mat4  a_PrevViewProjectionInv;
+	vec3  a_CameraPos;
+	float a_Time;
+	float a_NearPlane;
+	float a_FarPlane;
+	vec2  a_OutputResolution;
+};
+
+// The light we're compositing, see UniformBlocks.h
+layout(std140, binding = 2) uniform LightBlock {
+	// A matrix going from the world to the light space (world->light) basically the inverse of the light's transform
+	mat4  a_LightView;
+	// The light's position, in world space
+	vec3  a_LightPos;
+	// The attenuation factor for the light (1/dist)
+	float a_LightAttenuation;
+	// The light's direction, in world space
+	vec3  a_LightDir;
+	// The intensity of the projector image
+	float a_ProjectorIntensity;
+	// The light's color
+	vec3  a_LightColor;
+	// Allows us to toggle between shadows and projectors
+	bool  b_IsProjector;
+};
+
 // This should really be a GBuffer parameter
 uniform float a_MatShininess;
 
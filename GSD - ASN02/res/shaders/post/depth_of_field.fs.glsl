@@ -20,8 +20,25 @@ uniform float a_LenseDistance;
 // The aperture of the camera (default is 20) This can be thought of as the inverse of your camera's F-Stop
 uniform float a_Aperture;
 
-// The inverse of the camera's projection matrix
-uniform mat4 a_ProjectionInv;
+// The camera the scene was drawn from, see UniformBlocks.h
+layout(std140, binding = 0) uniform CameraBlock {
+	mat4  a_View;
+	mat4  a_Projection;
+	mat4  a_ViewProjection;
+	mat4  a_ViewInv;
+	mat4  a_ProjectionInv;
+	mat4  a_ViewProjectionInv;
+	mat4  a_PrevView;
+	mat4  a_PrevProjection;
+	mat4  a_PrevViewProjection;
+	mat4  a_PrevProjectionInv;
+	mat4  a_PrevViewProjectionInv;
+	vec3  a_CameraPos;
+	float a_Time;
+	float a_NearPlane;
+	float a_FarPlane;
+	vec2  a_OutputResolution;
+};
 
 const float GOLDEN_ANGLE = 2.39996323;
 const float MAX_BLUR_RADIUS = 20; // We impose a hard limit on blurring to avoid killing the GPU
@@ -7,8 +7,25 @@ layout (location = 0) out vec4 outColor;
 
 uniform sampler2D xImage;
 
-uniform mat4 a_ViewProjectionInv;
-uniform mat4 a_PrevViewProjection;
+// The camera the scene was drawn from, see UniformBlocks.h
+layout(std140, binding = 0) uniform CameraBlock {
+	mat4  a_View;
+	mat4  a_Projection;
+	mat4  a_ViewProjection;
+	mat4  a_ViewInv;
+	mat4  a_ProjectionInv;
+	mat4  a_ViewProjectionInv;
+	mat4  a_PrevView;
+	mat4  a_PrevProjection;
+	mat4  a_PrevViewProjection;
+	mat4  a_PrevProjectionInv;
+	mat4  a_PrevViewProjectionInv;
+	vec3  a_CameraPos;
+	float a_Time;
+	float a_NearPlane;
+	float a_FarPlane;
+	vec2  a_OutputResolution;
+};
 
 const int c_NumSamples = 5;
 
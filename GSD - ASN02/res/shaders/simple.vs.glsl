@@ -1,8 +1,32 @@
-#version 410
+#version 420
 layout(location = 0) in vec3 inPosition;
 
-uniform mat4 a_ModelViewProjection;
+// The camera we're drawing from, see UniformBlocks.h
+layout(std140, binding = 0) uniform CameraBlock {
+	mat4  a_View;
+	mat4  a_Projection;
+	mat4  a_ViewProjection;
+	mat4  a_ViewInv;
+	mat4  a_ProjectionInv;
+	mat4  a_ViewProjectionInv;
+	mat4  a_PrevView;
+	mat4  a_PrevProjection;
+	mat4  a_PrevViewProjection;
+	mat4  a_PrevProjectionInv;
+	mat4  a_PrevViewProjectionInv;
+	vec3  a_CameraPos;
+	float a_Time;
+	float a_NearPlane;
+	float a_FarPlane;
+	vec2  a_OutputResolution;
+};
+
+// The object being drawn, see UniformBlocks.h
+layout(std140, binding = 1) uniform ObjectBlock {
+	mat4 a_Model;
+	mat3 a_NormalMatrix;
+};
 
 void main() {
-	gl_Position = a_ModelViewProjection * vec4(inPosition, 1);
+	gl_Position = a_ViewProjection * a_Model * vec4(inPosition, 1);
 }
\ No newline at end of file
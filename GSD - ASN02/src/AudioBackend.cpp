@@ -0,0 +1,31 @@
+#include "AudioBackend.h"
+#include "FMODAudioBackend.h"
+#include "HeadlessAudioBackend.h"
+
+#include <iostream>
+
+std::unique_ptr<AudioBackend> AudioBackend::Create(AudioBackendType eType, const std::string& strOutputFile)
+{
+	switch (eType)
+	{
+	case AudioBackendType::FMOD:
+	case AudioBackendType::Offline:
+#ifndef AUDIO_NO_FMOD
+		if (eType == AudioBackendType::Offline)
+			return std::unique_ptr<AudioBackend>(new FMODAudioBackend(strOutputFile.empty() ? "audio_render.wav" : strOutputFile.c_str()));
+		return std::unique_ptr<AudioBackend>(new FMODAudioBackend());
+#else
+		std::cout << "Audio Engine: built without FMOD (AUDIO_NO_FMOD)" << std::endl;
+		return NULL;
+#endif
+	case AudioBackendType::Headless:
+	{
+		HeadlessAudioBackend* pBackend = new HeadlessAudioBackend();
+		if (!strOutputFile.empty())
+			pBackend->OpenOutputFile(strOutputFile.c_str());
+		return std::unique_ptr<AudioBackend>(pBackend);
+	}
+	}
+
+	return NULL;
+}
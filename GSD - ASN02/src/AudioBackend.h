@@ -0,0 +1,112 @@
+#pragma once
+
+// FMOD
+// Only the plain C types and enums are used here, so the headless backend doesn't need the FMOD libraries
+#include "fmod_studio.hpp"
+
+// Standard Library
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+/*
+ * Opaque handles to objects owned by a backend. Each backend casts these to its own types, for the FMOD
+ * backend they are FMOD::Studio objects and for the headless backend they are its simulated ones.
+ */
+struct BackendBank;
+struct BackendEventDescription;
+struct BackendEventInstance;
+struct BackendSound;
+struct BackendChannel;
+
+enum class AudioBackendType
+{
+	FMOD,     // FMOD Studio, this is what the game uses
+	Headless, // In process stand in for tests and benchmarks, nothing is played and nothing is loaded from disk
+	Offline   // FMOD Studio mixing into a WAV file instead of a device, one block per update as fast as it is called
+};
+
+/*
+ * Everything the AudioEngine needs from FMOD Studio. The functions mirror the FMOD calls they replace
+ * and return FMOD_RESULTs, so they can still be passed to AudioEngine::ErrorCheck.
+ */
+class AudioBackend
+{
+public:
+	virtual ~AudioBackend() { }
+
+	// Creates and initializes a backend, returns NULL if the backend isn't available in this build. The offline
+	// backend renders into strOutputFile, and so does the headless one if it is given.
+	static std::unique_ptr<AudioBackend> Create(AudioBackendType eType, const std::string& strOutputFile = "");
+
+	virtual AudioBackendType GetType() const = 0;
+
+	// How much time passes between updates if the backend runs on a fixed step, 0 if it follows the real clock
+	virtual float GetUpdateStep() const { return 0.0f; }
+
+	// System
+	virtual FMOD_RESULT Update() = 0;
+	virtual FMOD_RESULT UnloadAll() = 0;
+	virtual FMOD_RESULT SetNumListeners(int nListeners) = 0;
+	virtual FMOD_RESULT SetListenerAttributes(int nListener, const FMOD_3D_ATTRIBUTES& attributes) = 0;
+	virtual FMOD_RESULT SetParameterByName(const char* strName, float fValue) = 0;
+	virtual FMOD_RESULT GetParameterDescriptionByName(const char* strName, FMOD_STUDIO_PARAMETER_DESCRIPTION* pParameter) = 0;
+	virtual FMOD_RESULT SetParametersByIDs(const FMOD_STUDIO_PARAMETER_ID* pIDs, float* pValues, int nCount) = 0;
+
+	// Banks
+	virtual FMOD_RESULT LoadBankFile(const char* strFileName, FMOD_STUDIO_LOAD_BANK_FLAGS flags, BackendBank** ppBank) = 0;
+	virtual FMOD_RESULT GetLoadingState(BackendBank* pBank, FMOD_STUDIO_LOADING_STATE* pState) = 0;
+	virtual FMOD_RESULT GetEventCount(BackendBank* pBank, int* pCount) = 0;
+	virtual FMOD_RESULT GetEventList(BackendBank* pBank, BackendEventDescription** ppDescriptions, int nCapacity, int* pCount) = 0;
+
+	// Event descriptions
+	virtual FMOD_RESULT GetEventByID(const FMOD_GUID* pGUID, BackendEventDescription** ppDescription) = 0;
+	virtual FMOD_RESULT Is3D(BackendEventDescription* pDescription, bool* pIs3D) = 0;
+	virtual FMOD_RESULT GetMinimumDistance(BackendEventDescription* pDescription, float* pDistance) = 0;
+	virtual FMOD_RESULT GetMaximumDistance(BackendEventDescription* pDescription, float* pDistance) = 0;
+	virtual FMOD_RESULT GetLength(BackendEventDescription* pDescription, int* pLength) = 0; // in milliseconds, 0 if it has no fixed end
+	virtual FMOD_RESULT IsStream(BackendEventDescription* pDescription, bool* pIsStream) = 0; // true if any of its assets stream
+	virtual FMOD_RESULT LoadSampleData(BackendEventDescription* pDescription) = 0;
+	virtual FMOD_RESULT UnloadSampleData(BackendEventDescription* pDescription) = 0;
+	virtual FMOD_RESULT GetSampleLoadingState(BackendEventDescription* pDescription, FMOD_STUDIO_LOADING_STATE* pState) = 0;
+	virtual FMOD_RESULT CreateInstance(BackendEventDescription* pDescription, BackendEventInstance** ppInstance) = 0;
+	virtual FMOD_RESULT GetParameterDescriptionByName(BackendEventDescription* pDescription, const char* strName, FMOD_STUDIO_PARAMETER_DESCRIPTION* pParameter) = 0;
+
+	// Event instances
+	virtual FMOD_RESULT Start(BackendEventInstance* pInstance) = 0;
+	virtual FMOD_RESULT Stop(BackendEventInstance* pInstance, FMOD_STUDIO_STOP_MODE eMode) = 0;
+	virtual FMOD_RESULT Release(BackendEventInstance* pInstance) = 0;
+	virtual FMOD_RESULT SetPaused(BackendEventInstance* pInstance, bool bPaused) = 0;
+	virtual FMOD_RESULT GetPlaybackState(BackendEventInstance* pInstance, FMOD_STUDIO_PLAYBACK_STATE* pState) = 0;
+	virtual FMOD_RESULT GetTimelinePosition(BackendEventInstance* pInstance, int* pPosition) = 0; // in milliseconds
+	virtual FMOD_RESULT Set3DAttributes(BackendEventInstance* pInstance, const FMOD_3D_ATTRIBUTES& attributes) = 0;
+	virtual FMOD_RESULT GetAudibility(BackendEventInstance* pInstance, float* pAudibility) = 0;
+	// FMOD only fills this in for its logging builds, release builds report 0 for everything
+	virtual FMOD_RESULT GetMemoryUsage(BackendEventInstance* pInstance, FMOD_STUDIO_MEMORY_USAGE* pUsage) = 0;
+	virtual FMOD_RESULT GetParameterByName(BackendEventInstance* pInstance, const char* strName, float* pValue) = 0;
+	virtual FMOD_RESULT SetParameterByName(BackendEventInstance* pInstance, const char* strName, float fValue) = 0;
+	virtual FMOD_RESULT SetParametersByIDs(BackendEventInstance* pInstance, const FMOD_STUDIO_PARAMETER_ID* pIDs, float* pValues, int nCount) = 0;
+
+	// Sounds and channels, played on the core system without going through Studio
+	virtual FMOD_RESULT CreateSound(const char* strFileName, FMOD_MODE mode, BackendSound** ppSound) = 0;
+	virtual FMOD_RESULT ReleaseSound(BackendSound* pSound) = 0;
+	// nChannelId is handed back through GetEndedChannels once the channel has finished, for whatever reason
+	virtual FMOD_RESULT PlaySound(BackendSound* pSound, uint32_t nChannelId, bool bPaused, BackendChannel** ppChannel) = 0;
+	virtual FMOD_RESULT StopChannel(BackendChannel* pChannel) = 0;
+	virtual FMOD_RESULT SetChannelPaused(BackendChannel* pChannel, bool bPaused) = 0;
+	virtual FMOD_RESULT SetChannel3DAttributes(BackendChannel* pChannel, const FMOD_VECTOR& position, const FMOD_VECTOR& velocity) = 0;
+	virtual FMOD_RESULT SetChannelVolume(BackendChannel* pChannel, float fVolume) = 0;
+
+	// Ids of the channels that have ended since ClearEndedChannels was last called. Space for every playing
+	// channel is reserved when it is played, so collecting these never allocates.
+	virtual const std::vector<uint32_t>& GetEndedChannels() const = 0;
+	virtual void ClearEndedChannels() = 0;
+
+	// Profiling
+	// Every call made through this interface so far, not counting the profiling calls themselves
+	virtual size_t GetCallCount() const = 0;
+	virtual FMOD_RESULT GetCPUUsage(FMOD_STUDIO_CPU_USAGE* pUsage) = 0;
+	// Bytes currently allocated by FMOD, and the most it has had allocated at once
+	virtual FMOD_RESULT GetMemoryUsage(int* pCurrent, int* pMax) = 0;
+};
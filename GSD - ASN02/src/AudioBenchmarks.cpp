@@ -0,0 +1,683 @@
+#include "AudioBenchmarks.h"
+#include "AudioEngine.h"
+#include "HeadlessAudioBackend.h"
+#include "Easing.h"
+#include "MotionPath.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <algorithm>
+
+typedef std::chrono::high_resolution_clock BenchClock;
+
+// Returns the time between two points in microseconds
+static double ElapsedMicroseconds(BenchClock::time_point start, BenchClock::time_point end)
+{
+	return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+void AudioBenchmarks::RunAll(bool bHeadless)
+{
+	EngineUpdate();
+	ChannelUpdates();
+	ParameterUpdates();
+	EmitterUpdates();
+	EasingCurves();
+	MotionPaths();
+	Occlusion();
+	if (bHeadless)
+		return;
+
+	StartupTime();
+
+	AudioEngine& audioEngine = AudioEngine::GetInstance();
+	audioEngine.Init();
+	audioEngine.LoadBank("Master");
+
+	EventPositionUpdates();
+
+	audioEngine.Shutdown();
+}
+
+void AudioBenchmarks::StartupTime()
+{
+	AudioEngine& audioEngine = AudioEngine::GetInstance();
+
+	// Blocking, this is how long the first frame used to wait for
+	audioEngine.Init();
+	BenchClock::time_point start = BenchClock::now();
+	audioEngine.LoadBank("Master");
+	audioEngine.LoadEvent("Car Crash");
+	double blockingTime = ElapsedMicroseconds(start, BenchClock::now());
+	audioEngine.Shutdown();
+
+	// Background, the first frame only waits for LoadBankAsync to return
+	audioEngine.Init();
+	start = BenchClock::now();
+	AudioLoadTicket ticket = audioEngine.LoadBankAsync("Master", { "Car Crash" });
+	double firstFrameTime = ElapsedMicroseconds(start, BenchClock::now());
+
+	// Then keep updating like the game loop would until it's done
+	while (!audioEngine.IsLoadComplete(ticket) && !audioEngine.HasLoadFailed(ticket))
+	{
+		audioEngine.Update();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	audioEngine.LoadEvent("Car Crash");
+	double readyTime = ElapsedMicroseconds(start, BenchClock::now());
+	audioEngine.Shutdown();
+
+	std::cout << "Audio Benchmark: startup" << std::endl;
+	std::cout << "\tblocking load:        " << blockingTime << "us before the first frame" << std::endl;
+	std::cout << "\tbackground load:      " << firstFrameTime << "us before the first frame" << std::endl;
+	std::cout << "\t                      " << readyTime << "us until the event was ready (samples preloaded)" << std::endl;
+}
+
+void AudioBenchmarks::EventPositionUpdates()
+{
+	const int NUM_UPDATES = 10000;
+
+	AudioEngine& audioEngine = AudioEngine::GetInstance();
+	EventHandle hEvent = audioEngine.LoadEvent("Car Crash");
+	if (hEvent == INVALID_EVENT_HANDLE)
+	{
+		std::cout << "Audio Benchmark: could not load \"Car Crash\", skipping position updates" << std::endl;
+		return;
+	}
+
+	// Name path, the literal becomes a std::string temporary on every call just like in the layers
+	BenchClock::time_point start = BenchClock::now();
+	for (int i = 0; i < NUM_UPDATES; i++)
+	{
+		audioEngine.SetEventPosition("Car Crash", glm::vec3((float)i, 0.0f, 0.0f));
+	}
+	double nameTime = ElapsedMicroseconds(start, BenchClock::now());
+
+	// Handle path
+	start = BenchClock::now();
+	for (int i = 0; i < NUM_UPDATES; i++)
+	{
+		audioEngine.SetEventPosition(hEvent, glm::vec3((float)i, 0.0f, 0.0f));
+	}
+	double handleTime = ElapsedMicroseconds(start, BenchClock::now());
+
+	std::cout << "Audio Benchmark: " << NUM_UPDATES << " position updates" << std::endl;
+	std::cout << "\tby name:   " << nameTime << "us (" << nameTime / NUM_UPDATES << "us per call)" << std::endl;
+	std::cout << "\tby handle: " << handleTime << "us (" << handleTime / NUM_UPDATES << "us per call)" << std::endl;
+}
+
+void AudioBenchmarks::EngineUpdate()
+{
+	const int NUM_EVENTS = 64;
+	const int VOICES_PER_EVENT = 8;
+	const int NUM_FRAMES = 600;
+
+	AudioEngine& audioEngine = AudioEngine::GetInstance();
+	audioEngine.Init(AudioBackendType::Headless);
+	HeadlessAudioBackend* pBackend = (HeadlessAudioBackend*)audioEngine.GetBackend();
+	audioEngine.LoadBank("Master");
+
+	// Made up events, spread out so some of them are always out of range of the listener
+	HeadlessEventInfo info;
+	info.fLength = 1.5f;
+	info.fMaxDistance = 40.0f;
+
+	std::vector<EventHandle> events;
+	for (int i = 0; i < NUM_EVENTS; i++)
+	{
+		FMOD_GUID guid = { (unsigned int)i + 1 };
+		std::string strName = "Bench " + std::to_string(i);
+		audioEngine.AddGUID("event:/" + strName, guid);
+		pBackend->AddEvent(guid, info);
+		events.push_back(audioEngine.LoadEvent(strName, VOICES_PER_EVENT, VoiceStealMode::Farthest));
+	}
+	audioEngine.SetVirtualVoiceSettings(-40.0f, 128);
+
+	size_t nStartCalls = pBackend->GetCallCount();
+	BenchClock::time_point start = BenchClock::now();
+	for (int nFrame = 0; nFrame < NUM_FRAMES; nFrame++)
+	{
+		audioEngine.SetListenerPosition(glm::vec3(sinf(nFrame * 0.01f) * 50.0f, 0.0f, 0.0f));
+
+		for (int i = 0; i < NUM_EVENTS; i++)
+		{
+			// Every event retriggers a few times a second, so the pools fill up and start stealing
+			if ((nFrame + i) % 10 == 0)
+				audioEngine.PlayEvent(events[i]);
+
+			float fAngle = nFrame * 0.02f + i;
+			audioEngine.SetEventPosition(events[i], glm::vec3(cosf(fAngle) * 5.0f + i * 2.0f, 0.0f, sinf(fAngle) * 5.0f));
+		}
+
+		audioEngine.Update();
+	}
+	double totalTime = ElapsedMicroseconds(start, BenchClock::now());
+	size_t nCalls = pBackend->GetCallCount() - nStartCalls;
+	VoiceStats voiceStats = audioEngine.GetVoiceStats();
+
+	audioEngine.Shutdown();
+
+	std::cout << "Audio Benchmark: " << NUM_FRAMES << " headless frames, " << NUM_EVENTS << " events with " << VOICES_PER_EVENT << " voices each" << std::endl;
+	std::cout << "	engine update: " << totalTime / NUM_FRAMES << "us per frame" << std::endl;
+	std::cout << "	backend calls: " << (double)nCalls / NUM_FRAMES << " per frame" << std::endl;
+	std::cout << "	last frame:    " << voiceStats.nReal << " real voices, " << voiceStats.nVirtual << " virtual" << std::endl;
+}
+
+void AudioBenchmarks::ChannelUpdates()
+{
+	const int SOUNDS_PER_FRAME = 64;
+	const int NUM_FRAMES = 600;
+
+	AudioEngine& audioEngine = AudioEngine::GetInstance();
+	audioEngine.Init(AudioBackendType::Headless);
+	HeadlessAudioBackend* pBackend = (HeadlessAudioBackend*)audioEngine.GetBackend();
+
+	// At 60 updates a second, 64 new one second sounds a frame settles at around 3840 playing channels
+	pBackend->SetSoundLength(1.0f);
+	audioEngine.LoadSound("Bench Sound");
+
+	double updateTime = 0.0;
+	int nPeakChannels = 0;
+	for (int nFrame = 0; nFrame < NUM_FRAMES; nFrame++)
+	{
+		for (int i = 0; i < SOUNDS_PER_FRAME; i++)
+		{
+			audioEngine.PlaySound("Bench Sound", glm::vec3((float)i, 0.0f, 0.0f));
+		}
+		nPeakChannels = std::max(nPeakChannels, audioEngine.GetActiveChannelCount());
+
+		BenchClock::time_point start = BenchClock::now();
+		audioEngine.Update();
+		updateTime += ElapsedMicroseconds(start, BenchClock::now());
+	}
+
+	audioEngine.Shutdown();
+
+	std::cout << "Audio Benchmark: " << NUM_FRAMES << " headless frames, " << SOUNDS_PER_FRAME << " one shot sounds started per frame" << std::endl;
+	std::cout << "	update:        " << updateTime / NUM_FRAMES << "us per frame" << std::endl;
+	std::cout << "	peak channels: " << nPeakChannels << std::endl;
+}
+
+void AudioBenchmarks::ParameterUpdates()
+{
+	const int NUM_EVENTS = 32;
+	const int VOICES_PER_EVENT = 4;
+	const int NUM_FRAMES = 600;
+	const char* PARAMETER_NAMES[] = { "RPM", "Load", "Speed", "Surface" };
+	const int NUM_PARAMETERS = sizeof(PARAMETER_NAMES) / sizeof(PARAMETER_NAMES[0]);
+
+	AudioEngine& audioEngine = AudioEngine::GetInstance();
+	audioEngine.Init(AudioBackendType::Headless);
+	HeadlessAudioBackend* pBackend = (HeadlessAudioBackend*)audioEngine.GetBackend();
+	audioEngine.LoadBank("Master");
+
+	// Long enough that every voice plays for the whole benchmark
+	HeadlessEventInfo info;
+	info.fLength = 1000.0f;
+	for (int i = 0; i < NUM_PARAMETERS; i++)
+		info.Parameters[PARAMETER_NAMES[i]] = 0.0f;
+
+	std::vector<EventHandle> voices;
+	std::vector<ParameterHandle> parameters;
+	for (int i = 0; i < NUM_EVENTS; i++)
+	{
+		FMOD_GUID guid = { (unsigned int)i + 1 };
+		std::string strName = "Bench " + std::to_string(i);
+		audioEngine.AddGUID("event:/" + strName, guid);
+		pBackend->AddEvent(guid, info);
+
+		EventHandle hEvent = audioEngine.LoadEvent(strName, VOICES_PER_EVENT, VoiceStealMode::Oldest);
+		for (int j = 0; j < VOICES_PER_EVENT; j++)
+		{
+			EventHandle hVoice = audioEngine.PlayEvent(hEvent);
+			voices.push_back(hVoice);
+			for (int k = 0; k < NUM_PARAMETERS; k++)
+				parameters.push_back(audioEngine.GetParameterHandle(hVoice, PARAMETER_NAMES[k]));
+		}
+	}
+	audioEngine.Update();
+
+	// Every parameter on every voice changes every frame, like an engine sound following the car
+	double nameTime = 0.0;
+	size_t nStartCalls = pBackend->GetCallCount();
+	for (int nFrame = 0; nFrame < NUM_FRAMES; nFrame++)
+	{
+		BenchClock::time_point start = BenchClock::now();
+		for (size_t i = 0; i < voices.size(); i++)
+		{
+			for (int k = 0; k < NUM_PARAMETERS; k++)
+				audioEngine.SetEventParameter(voices[i], PARAMETER_NAMES[k], (float)(nFrame + k));
+		}
+		audioEngine.Update();
+		nameTime += ElapsedMicroseconds(start, BenchClock::now());
+	}
+	size_t nNameCalls = pBackend->GetCallCount() - nStartCalls;
+
+	double handleTime = 0.0;
+	nStartCalls = pBackend->GetCallCount();
+	for (int nFrame = 0; nFrame < NUM_FRAMES; nFrame++)
+	{
+		BenchClock::time_point start = BenchClock::now();
+		for (size_t i = 0; i < voices.size(); i++)
+		{
+			for (int k = 0; k < NUM_PARAMETERS; k++)
+				audioEngine.SetEventParameter(voices[i], parameters[i * NUM_PARAMETERS + k], (float)(nFrame + k));
+		}
+		audioEngine.Update();
+		handleTime += ElapsedMicroseconds(start, BenchClock::now());
+	}
+	size_t nHandleCalls = pBackend->GetCallCount() - nStartCalls;
+
+	audioEngine.Shutdown();
+
+	std::cout << "Audio Benchmark: " << NUM_FRAMES << " headless frames, " << NUM_PARAMETERS << " parameters set on " << voices.size() << " voices per frame" << std::endl;
+	std::cout << "	by name:   " << nameTime / NUM_FRAMES << "us per frame, " << (double)nNameCalls / NUM_FRAMES << " backend calls per frame" << std::endl;
+	std::cout << "	by handle: " << handleTime / NUM_FRAMES << "us per frame, " << (double)nHandleCalls / NUM_FRAMES << " backend calls per frame" << std::endl;
+}
+
+void AudioBenchmarks::EmitterUpdates()
+{
+	const int NUM_EVENTS = 64;
+	const int VOICES_PER_EVENT = 64;
+	const int NUM_FRAMES = 300;
+
+	AudioEngine& audioEngine = AudioEngine::GetInstance();
+	audioEngine.Init(AudioBackendType::Headless);
+	HeadlessAudioBackend* pBackend = (HeadlessAudioBackend*)audioEngine.GetBackend();
+	audioEngine.LoadBank("Master");
+
+	// Long enough that every voice plays for the whole benchmark
+	HeadlessEventInfo info;
+	info.fLength = 1000.0f;
+	info.fMaxDistance = 40.0f;
+
+	std::vector<EventHandle> voices;
+	for (int i = 0; i < NUM_EVENTS; i++)
+	{
+		FMOD_GUID guid = { (unsigned int)i + 1 };
+		std::string strName = "Bench " + std::to_string(i);
+		audioEngine.AddGUID("event:/" + strName, guid);
+		pBackend->AddEvent(guid, info);
+
+		EventHandle hEvent = audioEngine.LoadEvent(strName, VOICES_PER_EVENT, VoiceStealMode::Oldest);
+		for (int j = 0; j < VOICES_PER_EVENT; j++)
+			voices.push_back(audioEngine.PlayEvent(hEvent));
+	}
+	audioEngine.Update();
+
+	// Emitters on a grid drifting past the listener, a lot of them out of range at any time
+	std::vector<glm::vec3> positions(voices.size());
+	std::vector<float> cullDistances(voices.size(), 30.0f);
+	auto moveEmitters = [&](int nFrame)
+	{
+		for (size_t i = 0; i < voices.size(); i++)
+			positions[i] = glm::vec3((float)(i % 64) * 2.0f - 64.0f + sinf(nFrame * 0.01f) * 10.0f, 0.0f, (float)(i / 64) * 2.0f - 64.0f);
+	};
+
+	double callTime = 0.0;
+	for (int nFrame = 0; nFrame < NUM_FRAMES; nFrame++)
+	{
+		moveEmitters(nFrame);
+		BenchClock::time_point start = BenchClock::now();
+		for (size_t i = 0; i < voices.size(); i++)
+			audioEngine.SetEventPosition(voices[i], positions[i]);
+		audioEngine.Update();
+		callTime += ElapsedMicroseconds(start, BenchClock::now());
+	}
+
+	double batchTime = 0.0;
+	for (int nFrame = 0; nFrame < NUM_FRAMES; nFrame++)
+	{
+		moveEmitters(nFrame);
+		BenchClock::time_point start = BenchClock::now();
+		audioEngine.SetEventPositions(voices.data(), positions.data(), (int)voices.size(), NULL, cullDistances.data());
+		audioEngine.Update();
+		batchTime += ElapsedMicroseconds(start, BenchClock::now());
+	}
+	VoiceStats voiceStats = audioEngine.GetVoiceStats();
+
+	// Only the game thread's side is timed here, the audio thread stages the batch on its own tick
+	audioEngine.StartUpdateThread();
+	double threadedTime = 0.0;
+	for (int nFrame = 0; nFrame < NUM_FRAMES; nFrame++)
+	{
+		moveEmitters(nFrame);
+		BenchClock::time_point start = BenchClock::now();
+		audioEngine.SetEventPositions(voices.data(), positions.data(), (int)voices.size(), NULL, cullDistances.data());
+		audioEngine.Update();
+		threadedTime += ElapsedMicroseconds(start, BenchClock::now());
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	audioEngine.StopUpdateThread();
+
+	audioEngine.Shutdown();
+
+	std::cout << "Audio Benchmark: " << NUM_FRAMES << " headless frames, " << voices.size() << " emitters moved per frame" << std::endl;
+	std::cout << "	call per emitter: " << callTime / NUM_FRAMES << "us per frame" << std::endl;
+	std::cout << "	one batch:        " << batchTime / NUM_FRAMES << "us per frame (" << voiceStats.nReal << " real voices, " << voiceStats.nVirtual << " culled)" << std::endl;
+	std::cout << "	threaded batch:   " << threadedTime / NUM_FRAMES << "us per frame on the game thread" << std::endl;
+}
+
+void AudioBenchmarks::CarCrashRender(bool bHeadless, const std::string& strOutputFile)
+{
+	// The same fly-by as AudioLayer, the car eases in from just left of the listener until it hits the wall
+	const MotionPath PATH({
+		{ 0.0f, glm::vec3(-1.0f, 0.0f, 0.0f), Easing::Curve::EaseIn },
+		{ 11.0f, glm::vec3(15.0f, 0.0f, 0.0f) }
+	});
+	const float MAX_LENGTH = 60.0f; // seconds of audio, in case the event never stops
+
+	AudioEngine& audioEngine = AudioEngine::GetInstance();
+	audioEngine.Init(bHeadless ? AudioBackendType::Headless : AudioBackendType::Offline, strOutputFile);
+	if (audioEngine.GetBackend()->GetType() == AudioBackendType::Headless)
+	{
+		// Block sized steps like FMOD's mixer, and an event about as long as the real one
+		HeadlessAudioBackend* pBackend = (HeadlessAudioBackend*)audioEngine.GetBackend();
+		pBackend->SetUpdateStep(1024.0f / 48000.0f);
+		HeadlessEventInfo info;
+		info.fLength = 14.0f;
+		info.fMaxDistance = 40.0f;
+		pBackend->SetDefaultEventInfo(info);
+	}
+	audioEngine.LoadBank("Master");
+
+	EventHandle hEvent = audioEngine.LoadEvent("Car Crash");
+	if (hEvent == INVALID_EVENT_HANDLE)
+	{
+		std::cout << "Audio Benchmark: couldn't load Car Crash, nothing rendered" << std::endl;
+		audioEngine.Shutdown();
+		return;
+	}
+
+	// The camera starts at the origin looking down -z
+	audioEngine.SetListenerPosition(glm::vec3(0.0f));
+	audioEngine.SetListenerOrientation(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+	audioEngine.SetEventPosition(hEvent, PATH.Sample(0.0f));
+	EventHandle hVoice = audioEngine.PlayEvent(hEvent);
+	audioEngine.TrackTimelinePosition(hVoice);
+
+	float fStep = audioEngine.GetBackend()->GetUpdateStep();
+	int nUpdates = 0;
+	double updateTime = 0.0;
+	double peakUpdateTime = 0.0;
+	size_t nStartCalls = audioEngine.GetBackend()->GetCallCount();
+	BenchClock::time_point start = BenchClock::now();
+	do
+	{
+		audioEngine.SetEventPosition(hVoice, PATH.Sample(audioEngine.GetTimelinePosition(hVoice)));
+
+		BenchClock::time_point updateStart = BenchClock::now();
+		audioEngine.Update();
+		double thisUpdate = ElapsedMicroseconds(updateStart, BenchClock::now());
+		updateTime += thisUpdate;
+		peakUpdateTime = std::max(peakUpdateTime, thisUpdate);
+		nUpdates++;
+	} while (audioEngine.isEventPlaying(hVoice) && nUpdates * fStep < MAX_LENGTH);
+	double totalTime = ElapsedMicroseconds(start, BenchClock::now());
+	size_t nCalls = audioEngine.GetBackend()->GetCallCount() - nStartCalls;
+
+	bool bTones = audioEngine.GetBackend()->GetType() == AudioBackendType::Headless;
+
+	// The file is only finished once the backend is released
+	audioEngine.Shutdown();
+
+	float fAudioLength = nUpdates * fStep;
+	std::cout << "Audio Benchmark: rendered " << fAudioLength << "s of Car Crash to " << strOutputFile
+		<< (bTones ? " (headless tones)" : "") << std::endl;
+	std::cout << "	wall time:     " << totalTime / 1000.0 << "ms, " << fAudioLength * 1000000.0 / totalTime << "x real time" << std::endl;
+	std::cout << "	updates:       " << nUpdates << " of " << fStep * 1000.0f << "ms, " << updateTime / nUpdates << "us average, " << peakUpdateTime << "us peak" << std::endl;
+	std::cout << "	backend calls: " << (double)nCalls / nUpdates << " per update" << std::endl;
+}
+
+// The curves as AudioLayer had them before Easing, for comparison
+static float PowfEaseIn(float u) { return powf(u, 5); }
+static float PowfEaseOut(float u) { return 1.0f - powf(1.0f - u, 8); }
+static float PowfEaseInOut(float u)
+{
+	return (u < 0.5f) ? 128.0f * (float)(pow(u, 8)) : 0.5f + (1.0f - powf((2.0f * (1.0f - u)), 8)) / 2.0f;
+}
+
+void AudioBenchmarks::EasingCurves()
+{
+	const int NUM_VALUES = 4096;
+	const int NUM_PASSES = 1000;
+	const int NUM_ERROR_SAMPLES = 1 << 20;
+	const Easing::Curve CURVES[] = { Easing::Curve::EaseIn, Easing::Curve::EaseOut, Easing::Curve::EaseInOut };
+	const char* CURVE_NAMES[] = { "ease in", "ease out", "ease in out" };
+	float (*POWF_CURVES[])(float) = { PowfEaseIn, PowfEaseOut, PowfEaseInOut };
+
+	std::vector<float> values(NUM_VALUES);
+	std::vector<float> results(NUM_VALUES);
+	for (int i = 0; i < NUM_VALUES; i++)
+		values[i] = (float)i / (NUM_VALUES - 1);
+
+	std::cout << "Audio Benchmark: " << NUM_PASSES << " passes over " << NUM_VALUES << " eased values" << std::endl;
+	for (int nCurve = 0; nCurve < 3; nCurve++)
+	{
+		Easing::Curve eCurve = CURVES[nCurve];
+
+		// Each pass feeds the last result back in a little, so the compiler can't hoist the work out of the loop
+		float fSum = 0.0f;
+		BenchClock::time_point start = BenchClock::now();
+		for (int nPass = 0; nPass < NUM_PASSES; nPass++)
+		{
+			for (int i = 0; i < NUM_VALUES; i++)
+				results[i] = POWF_CURVES[nCurve](values[i]);
+			fSum += results[nPass % NUM_VALUES];
+		}
+		double powfTime = ElapsedMicroseconds(start, BenchClock::now());
+
+		start = BenchClock::now();
+		for (int nPass = 0; nPass < NUM_PASSES; nPass++)
+		{
+			for (int i = 0; i < NUM_VALUES; i++)
+				results[i] = Easing::Evaluate(eCurve, values[i]);
+			fSum += results[nPass % NUM_VALUES];
+		}
+		double scalarTime = ElapsedMicroseconds(start, BenchClock::now());
+
+		start = BenchClock::now();
+		for (int nPass = 0; nPass < NUM_PASSES; nPass++)
+		{
+			Easing::Evaluate(eCurve, values.data(), results.data(), NUM_VALUES);
+			fSum += results[nPass % NUM_VALUES];
+		}
+		double batchTime = ElapsedMicroseconds(start, BenchClock::now());
+
+		// Worst error of each version against the exact curve
+		double powfError = 0.0;
+		double easingError = 0.0;
+		double batchError = 0.0;
+		for (int i = 0; i < NUM_ERROR_SAMPLES; i += NUM_VALUES)
+		{
+			for (int j = 0; j < NUM_VALUES; j++)
+				values[j] = (float)(i + j) / (NUM_ERROR_SAMPLES - 1);
+			Easing::Evaluate(eCurve, values.data(), results.data(), NUM_VALUES);
+
+			for (int j = 0; j < NUM_VALUES; j++)
+			{
+				double u = values[j];
+				double exact = eCurve == Easing::Curve::EaseIn ? pow(u, 5) :
+					eCurve == Easing::Curve::EaseOut ? 1.0 - pow(1.0 - u, 8) :
+					(u < 0.5 ? 0.5 * pow(2.0 * u, 8) : 1.0 - 0.5 * pow(2.0 * (1.0 - u), 8));
+				powfError = std::max(powfError, fabs(POWF_CURVES[nCurve](values[j]) - exact));
+				easingError = std::max(easingError, fabs(Easing::Evaluate(eCurve, values[j]) - exact));
+				batchError = std::max(batchError, fabs(results[j] - exact));
+			}
+		}
+		for (int i = 0; i < NUM_VALUES; i++)
+			values[i] = (float)i / (NUM_VALUES - 1);
+
+		double nEvaluations = (double)NUM_PASSES * NUM_VALUES;
+		std::cout << "	" << CURVE_NAMES[nCurve] << " (checksum " << fSum << ")" << std::endl;
+		std::cout << "		powf:   " << powfTime * 1000.0 / nEvaluations << "ns each, worst error " << powfError << std::endl;
+		std::cout << "		easing: " << scalarTime * 1000.0 / nEvaluations << "ns each, worst error " << easingError << std::endl;
+		std::cout << "		batch:  " << batchTime * 1000.0 / nEvaluations << "ns each, worst error " << batchError << std::endl;
+		if (easingError > 5e-7 || batchError > 5e-7)
+			std::cout << "		over the 5e-7 error bound!" << std::endl;
+	}
+}
+
+void AudioBenchmarks::MotionPaths()
+{
+	const int NUM_PATHS = 8;
+	const int NUM_EMITTERS = 512;
+	const int NUM_FRAMES = 600;
+	const float FRAME_TIME = 1.0f / 60.0f;
+
+	// A handful of looping spline paths, each one shared by a lot of emitters at different offsets along it
+	std::vector<MotionPath> paths;
+	for (int i = 0; i < NUM_PATHS; i++)
+	{
+		std::vector<PathKeyframe> keyframes;
+		for (int k = 0; k <= 8; k++)
+		{
+			float fAngle = k * 0.785398f + i;
+			PathKeyframe keyframe = { k * 1.5f, glm::vec3(cosf(fAngle) * (10.0f + i), (float)(k % 2), sinf(fAngle) * (10.0f + i)), Easing::Curve::EaseInOut };
+			keyframes.push_back(keyframe);
+		}
+		keyframes.back().vPosition = keyframes.front().vPosition;
+		paths.push_back(MotionPath(keyframes, MotionPath::Shape::Spline));
+	}
+
+	AudioEngine& audioEngine = AudioEngine::GetInstance();
+	audioEngine.Init(AudioBackendType::Headless);
+	HeadlessAudioBackend* pBackend = (HeadlessAudioBackend*)audioEngine.GetBackend();
+	audioEngine.LoadBank("Master");
+
+	HeadlessEventInfo info;
+	info.fLength = 1000.0f;
+	FMOD_GUID guid = { 1 };
+	audioEngine.AddGUID("event:/Bench Path", guid);
+	pBackend->AddEvent(guid, info);
+	EventHandle hEvent = audioEngine.LoadEvent("Bench Path", NUM_EMITTERS);
+
+	std::vector<EventHandle> voices;
+	std::vector<float> times;
+	for (int i = 0; i < NUM_EMITTERS; i++)
+	{
+		voices.push_back(audioEngine.PlayEvent(hEvent));
+		times.push_back(i * 0.01f);
+	}
+	std::vector<glm::vec3> positions(NUM_EMITTERS);
+
+	// Emitters are sorted by path, so each path samples its own run of them in one call
+	const int EMITTERS_PER_PATH = NUM_EMITTERS / NUM_PATHS;
+	double sampleTime = 0.0;
+	double updateTime = 0.0;
+	for (int nFrame = 0; nFrame < NUM_FRAMES; nFrame++)
+	{
+		BenchClock::time_point start = BenchClock::now();
+		for (float& fTime : times)
+			fTime += FRAME_TIME;
+		for (int i = 0; i < NUM_PATHS; i++)
+			paths[i].Sample(&times[i * EMITTERS_PER_PATH], &positions[i * EMITTERS_PER_PATH], EMITTERS_PER_PATH, true);
+		sampleTime += ElapsedMicroseconds(start, BenchClock::now());
+
+		start = BenchClock::now();
+		audioEngine.SetEventPositions(voices.data(), positions.data(), NUM_EMITTERS);
+		audioEngine.Update();
+		updateTime += ElapsedMicroseconds(start, BenchClock::now());
+	}
+
+	audioEngine.Shutdown();
+
+	std::cout << "Audio Benchmark: " << NUM_FRAMES << " headless frames, " << NUM_EMITTERS << " emitters on " << NUM_PATHS << " shared paths ("
+		<< paths[0].GetSampleCount() << " samples each)" << std::endl;
+	std::cout << "	path sampling: " << sampleTime / NUM_FRAMES << "us per frame" << std::endl;
+	std::cout << "	submit+update: " << updateTime / NUM_FRAMES << "us per frame" << std::endl;
+}
+
+void AudioBenchmarks::Occlusion()
+{
+	const int TOWN_SIZE = 32; // buildings along each side
+	const int NUM_EMITTERS = 512;
+	const int NUM_FRAMES = 300;
+	const int RAY_BUDGET = 32;
+
+	// Buildings of different heights on a grid, with streets between them
+	std::vector<OccluderBox> buildings;
+	for (int x = 0; x < TOWN_SIZE; x++)
+	{
+		for (int z = 0; z < TOWN_SIZE; z++)
+		{
+			OccluderBox box;
+			box.vMin = glm::vec3(x * 10.0f - TOWN_SIZE * 5.0f, 0.0f, z * 10.0f - TOWN_SIZE * 5.0f);
+			box.vMax = box.vMin + glm::vec3(6.0f, 4.0f + (float)((x * 7 + z * 3) % 10), 6.0f);
+			box.fStrength = 0.5f;
+			buildings.push_back(box);
+		}
+	}
+
+	BenchClock::time_point start = BenchClock::now();
+	OcclusionBVH bvh;
+	bvh.Build(buildings.data(), (int)buildings.size());
+	double buildTime = ElapsedMicroseconds(start, BenchClock::now());
+
+	// Emitters scattered around the streets at head height, so some are in the open and some behind a few buildings
+	std::vector<glm::vec3> positions;
+	for (int i = 0; i < NUM_EMITTERS; i++)
+	{
+		float fAngle = i * 2.39996f;
+		float fRadius = 8.0f + (float)(i % 64) * 2.0f;
+		positions.push_back(glm::vec3(cosf(fAngle) * fRadius, 1.7f, sinf(fAngle) * fRadius));
+	}
+	const glm::vec3 LISTENER = glm::vec3(2.0f, 1.7f, 2.0f);
+
+	start = BenchClock::now();
+	float fTotal = 0.0f;
+	for (const glm::vec3& vPosition : positions)
+		fTotal += bvh.Trace(LISTENER, vPosition);
+	double traceTime = ElapsedMicroseconds(start, BenchClock::now());
+
+	AudioEngine& audioEngine = AudioEngine::GetInstance();
+	audioEngine.Init(AudioBackendType::Headless);
+	HeadlessAudioBackend* pBackend = (HeadlessAudioBackend*)audioEngine.GetBackend();
+	audioEngine.LoadBank("Master");
+
+	HeadlessEventInfo info;
+	info.fLength = 1000.0f;
+	info.fMaxDistance = 200.0f;
+	info.Parameters["Occlusion"] = 0.0f;
+	FMOD_GUID guid = { 1 };
+	audioEngine.AddGUID("event:/Bench Occlusion", guid);
+	pBackend->AddEvent(guid, info);
+	EventHandle hEvent = audioEngine.LoadEvent("Bench Occlusion", NUM_EMITTERS);
+
+	std::vector<EventHandle> voices;
+	for (int i = 0; i < NUM_EMITTERS; i++)
+		voices.push_back(audioEngine.PlayEvent(hEvent));
+	audioEngine.SetListenerPosition(LISTENER);
+	audioEngine.SetEventPositions(voices.data(), positions.data(), NUM_EMITTERS);
+	audioEngine.SetOcclusionGeometry(buildings.data(), (int)buildings.size());
+
+	auto timeUpdates = [&](int nRaysPerUpdate)
+	{
+		audioEngine.SetOcclusionSettings(nRaysPerUpdate);
+		double updateTime = 0.0;
+		for (int nFrame = 0; nFrame < NUM_FRAMES; nFrame++)
+		{
+			BenchClock::time_point start = BenchClock::now();
+			audioEngine.Update();
+			updateTime += ElapsedMicroseconds(start, BenchClock::now());
+		}
+		return updateTime / NUM_FRAMES;
+	};
+	double everyTime = timeUpdates(NUM_EMITTERS);
+	double budgetTime = timeUpdates(RAY_BUDGET);
+
+	int nOccluded = 0;
+	for (EventHandle hVoice : voices)
+		nOccluded += audioEngine.GetOcclusion(hVoice) > 0.0f ? 1 : 0;
+
+	audioEngine.Shutdown();
+
+	std::cout << "Audio Benchmark: " << NUM_EMITTERS << " voices traced through " << buildings.size() << " buildings ("
+		<< bvh.GetNodeCount() << " tree nodes)" << std::endl;
+	std::cout << "	build:            " << buildTime << "us" << std::endl;
+	std::cout << "	trace:            " << traceTime / NUM_EMITTERS << "us per voice, average occlusion " << fTotal / NUM_EMITTERS << std::endl;
+	std::cout << "	every voice:      " << everyTime << "us per update" << std::endl;
+	std::cout << "	" << RAY_BUDGET << " per update:   " << budgetTime << "us per update, whole scene every "
+		<< (NUM_EMITTERS + RAY_BUDGET - 1) / RAY_BUDGET << " updates (" << nOccluded << " voices occluded)" << std::endl;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+
+/*
+ * Micro benchmarks for the audio engine. These are run from the command line with --audio-bench,
+ * from the resource directory so that GUIDs.txt and the banks can be found. Adding --headless only
+ * runs the benchmarks that use the headless backend, so they work on machines without FMOD.
+ */
+namespace AudioBenchmarks
+{
+	// Runs every audio benchmark, printing the results to the console
+	void RunAll(bool bHeadless = false);
+
+	// Compares how long startup is held up by loading the master bank normally and in the background
+	void StartupTime();
+
+	// Compares per frame position updates through the name and handle versions of SetEventPosition
+	void EventPositionUpdates();
+
+	// Runs the engine's per frame bookkeeping (pools, culling, staged attributes) against the headless
+	// backend, so the time measured is the engine's own and the results are the same on every run
+	void EngineUpdate();
+
+	// Keeps a few thousand one shot channels playing on the headless backend and times Update, which only
+	// has to reclaim the channels that ended that frame
+	void ChannelUpdates();
+
+	// Sets a handful of parameters on every playing voice each frame, by name and by handle. Either way
+	// the changes reach the backend as one setParametersByIDs call per voice.
+	void ParameterUpdates();
+
+	// Moves a few thousand playing voices every frame, one SetEventPosition call each and then all of them in
+	// one SetEventPositions batch, like AudioLayer does for emitters. The batch is also timed on the game thread
+	// with the update thread running, where a call per voice would overflow the command queue.
+	void EmitterUpdates();
+
+	// Times the easing curves against the powf versions AudioLayer used to have, one value at a time and in
+	// batches, and checks the worst error of each curve against a double precision reference
+	void EasingCurves();
+
+	// Moves a few hundred emitters along a handful of shared MotionPaths every frame, and sends their positions
+	// to the headless backend in one batch
+	void MotionPaths();
+
+	// Traces a few hundred voices through a town of box buildings, timing the tree build and each trace, then
+	// compares Update with every voice traced each frame against a small budget that spreads them over frames
+	void Occlusion();
+
+	// Renders AudioLayer's Car Crash fly-by to a WAV file as fast as the engine can update, with FMOD's offline
+	// backend or a tone stand in on the headless one, and prints how long it took. Run with --audio-render.
+	// Every render of the same scene comes out the same, so the file can be compared against a golden copy.
+	void CarCrashRender(bool bHeadless = false, const std::string& strOutputFile = "car_crash.wav");
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <GLM/glm.hpp>
+#include "AudioEngine.h"
+
+/*
+ * Makes a voice follow an entity around. AudioLayer gathers the world position of every emitter and sends
+ * them to the AudioEngine in one batch each frame, so there is no behaviour (or virtual call) per emitter.
+ */
+struct AudioEmitterComponent {
+	// The voice to move, as returned by AudioEngine::LoadEvent or PlayEvent
+	EventHandle Event = INVALID_EVENT_HANDLE;
+	// Where the sound comes from, in the entity's local space
+	glm::vec3   Offset = glm::vec3(0.0f);
+	// True to work the velocity (for doppler) out from how far the emitter moved, otherwise Velocity is used
+	bool        AutoVelocity = true;
+	glm::vec3   Velocity = glm::vec3(0.0f);
+	// The voice goes virtual when it is further than this from every listener, 0 to only use the event's max distance
+	float       CullingRadius = 0.0f;
+};
@@ -1,99 +1,575 @@
 #include "AudioEngine.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 
-//////// FMOD Implementation ////////
+//////// Implementation ////////
 
 Implementation* implementation = nullptr;
 
-Implementation::Implementation()
+// Set on the update thread, so calls made while running commands aren't queued again
+static thread_local bool sbIsAudioThread = false;
+
+// Sample memory estimates, used until FMOD can measure an event (it only does in its logging builds).
+// Roughly what FMOD Studio's default Vorbis quality comes out to for stereo, and its default stream buffer.
+static const float ESTIMATED_SAMPLE_BYTES_PER_SECOND = 16000.0f;
+static const size_t STREAM_BUFFER_BYTES = 16 * 1024;
+
+Implementation::Implementation(std::unique_ptr<AudioBackend> pBackend)
 {
-	mpStudioSystem = NULL;
-	AudioEngine::ErrorCheck(FMOD::Studio::System::create(&mpStudioSystem));
-	AudioEngine::ErrorCheck(mpStudioSystem->initialize(32, FMOD_STUDIO_INIT_NORMAL, FMOD_INIT_3D_RIGHTHANDED, NULL));
+	mpBackend = std::move(pBackend);
+
+	mnNextStartOrder = 0;
+	mnParameterNamesVersion = 0;
+	for (StagedAttributes& listener : mListeners)
+	{
+		listener.Reset();
+	}
+	mnListeners = 1;
+	mbListenerCountDirty = false;
+	mLastUpdateTime = std::chrono::steady_clock::now();
+
+	mfVirtualThreshold = AudioEngine::GetInstance().dbToVolume(-60.0f);
+	mnMaxRealVoices = 0;
+
+	mnOcclusionRaysPerUpdate = 16;
+	mfOcclusionRampTime = 0.25f;
+	mstrOcclusionParameter = "Occlusion";
+	mnOcclusionCursor = 0;
+	mnOcclusionRays = 0;
+
+	mbThreaded = false;
+	mbThreadRunning = false;
+	mnDroppedCommands = 0;
+	mnPlaysQueued = 0;
+	mnPlaysStarted = 0;
+	mnPositionBatchSequence = 0;
+	mnAppliedPositionBatch = 0;
 
-	mpSystem = NULL;
-	AudioEngine::ErrorCheck(mpStudioSystem->getCoreSystem(&mpSystem));
+	mnFirstPendingLoad = 0;
 
-	mnNextChannelId = 0;
+	mbProfiling = false;
+	mnFrame = 0;
+	mnLastCallCount = 0;
+
+	mnSampleBudget = 0;
+	mfShortEventLength = 2.0f;
+	mnResidentSampleBytes = 0;
 } 
 
 Implementation::~Implementation()
 {
-	AudioEngine::ErrorCheck(mpStudioSystem->unloadAll());
-	AudioEngine::ErrorCheck(mpStudioSystem->release());
+	for (auto& sound : mSounds)
+	{
+		AudioEngine::ErrorCheck(mpBackend->ReleaseSound(sound.second.pSound));
+	}
+	AudioEngine::ErrorCheck(mpBackend->UnloadAll());
+	mpBackend.reset();
 }
 
 void Implementation::Update()
 {
-	std::vector<ChannelMap::iterator> pStoppedChannels;
-	for (auto it = mChannels.begin(), itEnd = mChannels.end(); it != itEnd; ++it)
+	// Work out how long it has been since the last update, for velocities. Backends on a fixed
+	// step (headless) use that instead, so their results don't depend on how fast they run
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	float fDeltaTime = std::chrono::duration<float>(now - mLastUpdateTime).count();
+	mLastUpdateTime = now;
+	if (mpBackend->GetUpdateStep() > 0.0f)
+		fDeltaTime = mpBackend->GetUpdateStep();
+
+	UpdateLoadRequests();
+	RecycleStoppedVoices();
+	UpdateResidency();
+	CullVirtualVoices();
+	UpdateOcclusion(fDeltaTime);
+	FlushAttributes(fDeltaTime);
+	FlushParameters();
+
+	AudioEngine::ErrorCheck(mpBackend->Update());
+	ReclaimEndedChannels();
+
+	mnFrame++;
+	if (mbProfiling)
+		RecordFrameStats(std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - now).count());
+	mnLastCallCount = mpBackend->GetCallCount();
+}
+
+void Implementation::CullVirtualVoices()
+{
+	// A virtual voice has to get this much louder before it becomes real again, so voices
+	// right on the edge don't flip between real and virtual every frame
+	const float REALIZE_MARGIN = 1.1f;
+
+	mVoiceAudibility.clear();
+	mVoiceStats = VoiceStats();
+
+	for (EventHandle hVoice : mActiveVoices)
+	{
+		EventSlot* pSlot = GetEventSlot(hVoice);
+		if (!pSlot)
+			continue;
+
+		// 2D events are always heard
+		const EventPool& pool = mEventPools[pSlot->nPool];
+		if (!pool.b3D)
+		{
+			mVoiceStats.nReal++;
+			continue;
+		}
+
+		// Estimate the gain using FMOD's default inverse rolloff
+		float fDistance = GetNearestListenerDistance(pSlot->attributes.vPosition);
+		float fGain = fDistance <= pool.fMinDistance ? 1.0f : pool.fMinDistance / fDistance;
+		float fMaxDistance = pool.fMaxDistance;
+		if (pSlot->fCullDistance > 0.0f)
+			fMaxDistance = std::min(fMaxDistance, pSlot->fCullDistance);
+		float fThreshold = mfVirtualThreshold;
+		if (pSlot->bVirtual)
+		{
+			fMaxDistance /= REALIZE_MARGIN;
+			fThreshold *= REALIZE_MARGIN;
+		}
+
+		if (fDistance > fMaxDistance || fGain < fThreshold)
+		{
+			SetVoiceVirtual(hVoice, true);
+			mVoiceStats.nVirtual++;
+		}
+		else
+		{
+			mVoiceAudibility.push_back({ hVoice, fGain });
+		}
+	}
+
+	// Only keep the loudest voices if there are too many audible ones
+	if (mnMaxRealVoices > 0 && (int)mVoiceAudibility.size() > mnMaxRealVoices)
 	{
-		bool bIsPlaying = false;
-		it->second->isPlaying(&bIsPlaying);
-		if (!bIsPlaying)
+		std::nth_element(mVoiceAudibility.begin(), mVoiceAudibility.begin() + mnMaxRealVoices, mVoiceAudibility.end(),
+			[](const VoiceAudibility& lhs, const VoiceAudibility& rhs) { return lhs.fGain > rhs.fGain; });
+
+		for (size_t i = mnMaxRealVoices; i < mVoiceAudibility.size(); i++)
 		{
-			pStoppedChannels.push_back(it);
+			SetVoiceVirtual(mVoiceAudibility[i].hVoice, true);
+			mVoiceStats.nVirtual++;
 		}
+		mVoiceAudibility.resize(mnMaxRealVoices);
 	}
 
-	for (auto& it : pStoppedChannels)
+	for (const VoiceAudibility& voice : mVoiceAudibility)
 	{
-		mChannels.erase(it);
+		SetVoiceVirtual(voice.hVoice, false);
+		mVoiceStats.nReal++;
 	}
+}
+
+void Implementation::SetVoiceVirtual(EventHandle hVoice, bool bVirtual)
+{
+	EventSlot* pSlot = GetEventSlot(hVoice);
+	if (!pSlot || pSlot->bVirtual == bVirtual)
+		return;
 
-	AudioEngine::ErrorCheck(mpStudioSystem->update());
+	EventSlot& slot = *pSlot;
+	slot.bVirtual = bVirtual;
+	if (slot.pInstance)
+		AudioEngine::ErrorCheck(mpBackend->SetPaused(slot.pInstance, bVirtual));
+
+	// Positions weren't sent while the voice was virtual, so catch it up on the next flush
+	// without a velocity spike from wherever it was when it went virtual
+	if (!bVirtual)
+	{
+		slot.attributes.bHasLastPosition = false;
+		MarkAttributesDirty(hVoice, slot);
+	}
 }
 
-//////// Logistics ////////
+void Implementation::MarkAttributesDirty(EventHandle hVoice, EventSlot& slot)
+{
+	if (slot.attributes.bDirty)
+		return;
 
-void AudioEngine::Init()
+	slot.attributes.bDirty = true;
+	mDirtyVoices.push_back(hVoice);
+}
+
+void Implementation::FlushAttributes(float fDeltaTime)
 {
-	implementation = new Implementation;
-	LoadGUIDs();
+	size_t nStillDirty = 0;
+	for (size_t i = 0; i < mDirtyVoices.size(); i++)
+	{
+		EventHandle hVoice = mDirtyVoices[i];
+		EventSlot* pSlot = GetEventSlot(hVoice);
+		if (!pSlot)
+			continue;
+
+		// Virtual voices are marked dirty again when they become real, and evicted ones when they are resident again
+		if (pSlot->bVirtual || !pSlot->pInstance)
+		{
+			pSlot->attributes.bDirty = false;
+			continue;
+		}
+
+		FMOD_3D_ATTRIBUTES attributes;
+		bool bMoving = pSlot->attributes.Resolve(fDeltaTime, attributes);
+		AudioEngine::ErrorCheck(mpBackend->Set3DAttributes(pSlot->pInstance, attributes));
+
+		// Moving voices are flushed again next update, so their velocity drops back to zero if they stop
+		if (bMoving)
+			mDirtyVoices[nStillDirty++] = hVoice;
+		else
+			pSlot->attributes.bDirty = false;
+	}
+	mDirtyVoices.resize(nStillDirty);
+
+	if (mbListenerCountDirty)
+	{
+		AudioEngine::ErrorCheck(mpBackend->SetNumListeners(mnListeners));
+		mbListenerCountDirty = false;
+	}
+
+	for (int i = 0; i < mnListeners; i++)
+	{
+		StagedAttributes& listener = mListeners[i];
+		if (!listener.bDirty)
+			continue;
+
+		FMOD_3D_ATTRIBUTES attributes;
+		listener.bDirty = listener.Resolve(fDeltaTime, attributes);
+		AudioEngine::ErrorCheck(mpBackend->SetListenerAttributes(i, attributes));
+	}
+}
+
+//////// Update Thread ////////
+
+const Implementation::VoiceSnapshot* Implementation::Snapshot::Find(EventHandle hVoice) const
+{
+	uint32_t nIndex = hVoice & 0xFFFF;
+	if (nIndex >= Voices.size() || Voices[nIndex].hVoice != hVoice)
+		return NULL;
+
+	return &Voices[nIndex];
+}
+
+bool Implementation::ShouldQueue() const
+{
+	return mbThreaded && !sbIsAudioThread;
+}
+
+bool Implementation::Enqueue(const AudioCommand& command)
+{
+	if (!mCommands.Push(command))
+	{
+		// The audio thread has fallen a whole queue behind, there isn't much we can do but drop it
+		if (mnDroppedCommands++ == 0)
+			std::cout << "Audio Engine: command queue is full, dropping commands" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void Implementation::ExecuteCommand(const AudioCommand& command)
+{
+	AudioEngine& audioEngine = AudioEngine::GetInstance();
+	switch (command.eType)
+	{
+	case AudioCommand::Type::PlayEvent:
+		// Counted even if it fails to start, so the game thread stops waiting on the voice either way
+		mnPlaysStarted++;
+		StartVoice(command.hEvent, command.hVoice);
+		break;
+	case AudioCommand::Type::StopEvent:
+		audioEngine.StopEvent(command.hEvent, command.bFlag);
+		break;
+	case AudioCommand::Type::StopAllVoices:
+		audioEngine.StopAllVoices(command.hEvent, command.bFlag);
+		break;
+	case AudioCommand::Type::SetEventPosition:
+		audioEngine.SetEventPosition(command.hEvent, command.vA);
+		break;
+	case AudioCommand::Type::SetEventOrientation:
+		audioEngine.SetEventOrientation(command.hEvent, command.vA, command.vB);
+		break;
+	case AudioCommand::Type::SetEventParameter:
+		audioEngine.SetEventParameter(command.hEvent, command.strName, command.fValue);
+		break;
+	case AudioCommand::Type::SetGlobalParameter:
+		audioEngine.SetGlobalParameter(command.strName, command.fValue);
+		break;
+	case AudioCommand::Type::SetEventParameterByHandle:
+		audioEngine.SetEventParameter(command.hEvent, command.hParameter, command.fValue);
+		break;
+	case AudioCommand::Type::SetGlobalParameterByHandle:
+		audioEngine.SetGlobalParameter(command.hParameter, command.fValue);
+		break;
+	case AudioCommand::Type::SetListenerPosition:
+		audioEngine.SetListenerPosition(command.vA, command.nIndex);
+		break;
+	case AudioCommand::Type::SetListenerOrientation:
+		audioEngine.SetListenerOrientation(command.vA, command.vB, command.nIndex);
+		break;
+	case AudioCommand::Type::SetNumListeners:
+		audioEngine.SetNumListeners(command.nIndex);
+		break;
+	case AudioCommand::Type::TrackTimelinePosition:
+		audioEngine.TrackTimelinePosition(command.hEvent, command.bFlag);
+		break;
+	}
 }
 
-void AudioEngine::LoadGUIDs()
+void Implementation::PublishSnapshot()
 {
-	// Open the file
-	std::ifstream guidFile;
-	guidFile.open("GUIDs.txt");
+	Snapshot& snapshot = mSnapshot.GetBack();
 
-	// Loop for each line
-	if (guidFile.is_open())
+	snapshot.Voices.resize(mEventSlots.size());
+	for (size_t i = 0; i < mEventSlots.size(); i++)
 	{
-		std::string currentLine;
-		std::string guid;
-		std::string key;
-		
-		while (!guidFile.eof())
-		{	
-			// Get Line
-			getline(guidFile, currentLine); // Format: "{bb98735b-7f42-4b9a-a178-7fe3140e7ea5} event:/Glide"
-		
-			// Parse GUID
-			guid = currentLine.substr(0, currentLine.find(" "));
+		const EventSlot& slot = mEventSlots[i];
+		VoiceSnapshot& voice = snapshot.Voices[i];
+		voice.hVoice = slot.bInUse ? (((EventHandle)slot.nGeneration << 16) | (EventHandle)i) : INVALID_EVENT_HANDLE;
+		voice.bActive = slot.bActive;
+		voice.eState = slot.eState;
+		voice.nStartCount = slot.nStartCount;
+		voice.nStopCount = slot.nStopCount;
+		voice.nTimelinePosition = slot.nTimelinePosition;
+		voice.fOcclusion = slot.fOcclusion;
+		voice.fStealScore = 0.0f;
+		voice.nPool = slot.nPool;
+		voice.ParameterValues = slot.ParameterValues;
+	}
 
-			// Parse Key
-			key = currentLine.substr(currentLine.find(" ") + 1, currentLine.length() - guid.length() - 1);
-			
-			// Add to bank
-			implementation->mGUIDs[key] = guid;
+	// Parameter names are only copied when they change, which is hardly ever once the game is running
+	snapshot.Pools.resize(mEventPools.size());
+	for (size_t i = 0; i < mEventPools.size(); i++)
+	{
+		const EventPool& pool = mEventPools[i];
+		PoolSnapshot& poolSnapshot = snapshot.Pools[i];
+		if (poolSnapshot.nParameterNamesVersion != pool.nParameterNamesVersion)
+		{
+			poolSnapshot.ParameterNames = pool.ParameterNames;
+			poolSnapshot.nParameterNamesVersion = pool.nParameterNamesVersion;
 		}
-		guidFile.close();
 	}
-	else
+
+	// The game thread only needs to steal once every voice is busy, and the quietest asks the backend, so the
+	// scores are only worked out for full events
+	for (const EventPool& pool : mEventPools)
+	{
+		bool bFull = !pool.Voices.empty();
+		for (EventHandle hVoice : pool.Voices)
+		{
+			EventSlot* pSlot = GetEventSlot(hVoice);
+			bFull &= pSlot && pSlot->bActive;
+		}
+		if (!bFull)
+			continue;
+
+		for (EventHandle hVoice : pool.Voices)
+		{
+			snapshot.Voices[hVoice & 0xFFFF].fStealScore = GetStealScore(pool, *GetEventSlot(hVoice));
+		}
+	}
+	snapshot.nPlaysStarted = mnPlaysStarted;
+	snapshot.voiceStats = mVoiceStats;
+	snapshot.nListeners = mnListeners;
+
+	mSnapshot.Publish();
+}
+
+void Implementation::UpdateThreadMain(int nTickRate)
+{
+	sbIsAudioThread = true;
+
+	std::chrono::steady_clock::duration tickLength = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(1.0 / nTickRate));
+	std::chrono::steady_clock::time_point nextTick = std::chrono::steady_clock::now();
+
+	while (mbThreadRunning.load())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mStructureMutex);
+
+			AudioCommand command;
+			while (mCommands.Pop(command))
+			{
+				ExecuteCommand(command);
+			}
+			ApplyPositionBatch();
+
+			Update();
+			PublishSnapshot();
+		}
+
+		// Fixed tick, if we fall behind we skip ahead instead of trying to catch up
+		nextTick += tickLength;
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (nextTick < now)
+			nextTick = now;
+		std::this_thread::sleep_until(nextTick);
+	}
+
+	sbIsAudioThread = false;
+}
+
+void AudioEngine::StartUpdateThread(int nTickRate)
+{
+	if (implementation->mbThreaded || nTickRate <= 0)
+		return;
+
+	// Publish once so queries have something to read before the first tick
+	implementation->PublishSnapshot();
+
+	implementation->mbThreaded = true;
+	implementation->mbThreadRunning = true;
+	implementation->mUpdateThread = std::thread(&Implementation::UpdateThreadMain, implementation, nTickRate);
+}
+
+void AudioEngine::StopUpdateThread()
+{
+	if (!implementation->mbThreaded)
+		return;
+
+	implementation->mbThreadRunning = false;
+	implementation->mUpdateThread.join();
+	implementation->mbThreaded = false;
+
+	// Run anything that was queued after the last tick
+	AudioCommand command;
+	while (implementation->mCommands.Pop(command))
+	{
+		implementation->ExecuteCommand(command);
+	}
+	implementation->PublishPositionBatch();
+	implementation->ApplyPositionBatch();
+}
+
+bool AudioEngine::IsThreaded() const
+{
+	return implementation->mbThreaded;
+}
+
+
+//////// Playback State ////////
+
+void Implementation::RefreshPlaybackCache()
+{
+	// In threaded mode the slots belong to the audio thread, so work from its last snapshot instead
+	const bool bThreaded = ShouldQueue();
+	const std::vector<VoiceSnapshot>* pVoices = bThreaded ? &mSnapshot.GetFront().Voices : NULL;
+	size_t nSlots = bThreaded ? pVoices->size() : mEventSlots.size();
+
+	if (mPlaybackCache.size() < nSlots)
+	{
+		PlaybackCacheEntry empty = { INVALID_EVENT_HANDLE, FMOD_STUDIO_PLAYBACK_STOPPED, 0, 0, 0, 0.0f, false, false };
+		mPlaybackCache.resize(nSlots, empty);
+	}
+
+	for (size_t i = 0; i < nSlots; i++)
+	{
+		EventHandle hVoice;
+		FMOD_STUDIO_PLAYBACK_STATE eState;
+		uint32_t nStartCount, nStopCount;
+		int nTimelinePosition;
+		float fOcclusion;
+		if (bThreaded)
+		{
+			const VoiceSnapshot& voice = (*pVoices)[i];
+			hVoice = voice.hVoice;
+			eState = voice.eState;
+			nStartCount = voice.nStartCount;
+			nStopCount = voice.nStopCount;
+			nTimelinePosition = voice.nTimelinePosition;
+			fOcclusion = voice.fOcclusion;
+		}
+		else
+		{
+			const EventSlot& slot = mEventSlots[i];
+			hVoice = slot.bInUse ? (((EventHandle)slot.nGeneration << 16) | (EventHandle)i) : INVALID_EVENT_HANDLE;
+			eState = slot.eState;
+			nStartCount = slot.nStartCount;
+			nStopCount = slot.nStopCount;
+			nTimelinePosition = slot.nTimelinePosition;
+			fOcclusion = slot.fOcclusion;
+		}
+
+		// A slot that was reused for another event starts over, rather than reporting the old one's counts as edges
+		PlaybackCacheEntry& entry = mPlaybackCache[i];
+		if (entry.hVoice != hVoice)
+		{
+			entry.hVoice = hVoice;
+			entry.nStartCount = 0;
+			entry.nStopCount = 0;
+		}
+
+		entry.eState = hVoice != INVALID_EVENT_HANDLE ? eState : FMOD_STUDIO_PLAYBACK_STOPPED;
+		entry.nTimelinePosition = nTimelinePosition;
+		entry.fOcclusion = fOcclusion;
+		entry.bJustStarted = nStartCount != entry.nStartCount;
+		entry.bJustStopped = nStopCount != entry.nStopCount;
+		entry.nStartCount = nStartCount;
+		entry.nStopCount = nStopCount;
+	}
+}
+
+const Implementation::PlaybackCacheEntry* Implementation::FindPlaybackState(EventHandle hVoice) const
+{
+	uint32_t nIndex = hVoice & 0xFFFF;
+	if (hVoice == INVALID_EVENT_HANDLE || nIndex >= mPlaybackCache.size() || mPlaybackCache[nIndex].hVoice != hVoice)
+		return NULL;
+
+	return &mPlaybackCache[nIndex];
+}
+
+
+//////// Logistics ////////
+
+void AudioEngine::Init(AudioBackendType eBackend, const std::string& strOutputFile)
+{
+	std::unique_ptr<AudioBackend> pBackend = AudioBackend::Create(eBackend, strOutputFile);
+	if (!pBackend)
+	{
+		std::cout << "Audio Engine: backend not available, running headless" << std::endl;
+		pBackend = AudioBackend::Create(AudioBackendType::Headless, strOutputFile);
+	}
+
+	implementation = new Implementation(std::move(pBackend));
+	LoadGUIDs();
+}
+
+void AudioEngine::LoadGUIDs(bool bUseCache)
+{
+	// The binary cache skips parsing entirely, as long as it's newer than the text file
+	if (bUseCache && implementation->mGUIDs.LoadCache("GUIDs.cache", "GUIDs.txt"))
+		return;
+
+	if (!implementation->mGUIDs.LoadText("GUIDs.txt"))
 	{
 		std::cout << "Audio Engine: GUID.txt not found" << std::endl;
+		return;
 	}
+
+	if (bUseCache && !implementation->mGUIDs.SaveCache("GUIDs.cache", "GUIDs.txt"))
+		std::cout << "Audio Engine: could not write GUIDs.cache" << std::endl;
+}
+
+void AudioEngine::AddGUID(const std::string& strPath, const FMOD_GUID& guid)
+{
+	implementation->mGUIDs.Add(guid, strPath.c_str(), strPath.length());
 }
 
 void AudioEngine::Shutdown()
 {
+	StopUpdateThread();
 	delete implementation;
 }
 
 void AudioEngine::Update()
 {
-	implementation->Update();
+	// The update thread does this on its own tick, we just hand it this frame's positions and pick up what it has seen
+	if (!implementation->ShouldQueue())
+		implementation->Update();
+	else
+		implementation->PublishPositionBatch();
+
+	implementation->RefreshPlaybackCache();
 }
 
 int AudioEngine::ErrorCheck(FMOD_RESULT result)
@@ -108,17 +584,24 @@ int AudioEngine::ErrorCheck(FMOD_RESULT result)
 	return 0;
 }
 
+AudioBackend* AudioEngine::GetBackend() const
+{
+	return implementation->mpBackend.get();
+}
+
 
 //////// Banks ////////
 
 void AudioEngine::LoadBank(const std::string& strBankName)
 {
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+
 	auto tFoundIt = implementation->mBanks.find(strBankName);
 	if (tFoundIt != implementation->mBanks.end())
 		return;
 
-	FMOD::Studio::Bank* pBank;
-	AudioEngine::ErrorCheck(implementation->mpStudioSystem->loadBankFile(("Desktop/" + strBankName + ".bank").c_str(), FMOD_STUDIO_LOAD_BANK_NORMAL, &pBank));
+	BackendBank* pBank = NULL;
+	AudioEngine::ErrorCheck(implementation->mpBackend->LoadBankFile(("Desktop/" + strBankName + ".bank").c_str(), FMOD_STUDIO_LOAD_BANK_NORMAL, &pBank));
 
 	if (pBank)
 	{
@@ -126,156 +609,1996 @@ void AudioEngine::LoadBank(const std::string& strBankName)
 	}
 }
 
-void AudioEngine::UnloadAllBanks()
-{
-	AudioEngine::ErrorCheck(implementation->mpStudioSystem->unloadAll());
-}
-
-
-//////// Events ////////
-
-void AudioEngine::LoadEvent(const std::string& strEventName)
+AudioLoadTicket AudioEngine::LoadBankAsync(const std::string& strBankName, const std::vector<std::string>& preloadEvents)
 {
-	// Return if the event is already loaded
-	auto tFoundEvent = implementation->mEvents.find(strEventName);
-	if (tFoundEvent != implementation->mEvents.end())
-		return;
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
 
-	// Return if the GUID does not exist
-	auto tFoundGUID = implementation->mGUIDs.find("event:/" + strEventName);
-	if (tFoundGUID == implementation->mGUIDs.end())
-		return;
-	
-	// Get GUID
-	std::string newEventGUID = implementation->mGUIDs["event:/" + strEventName];
+	std::unique_ptr<Implementation::LoadRequest> request(new Implementation::LoadRequest());
+	request->pBank = NULL;
+	request->PreloadEvents = preloadEvents;
+	request->bMetadataLoaded = false;
+	request->fProgress = 0.0f;
+	request->bDone = false;
+	request->bFailed = false;
 
-	// Load event using the GUID
-	FMOD::Studio::EventDescription* pEventDescription = NULL;
-	AudioEngine::ErrorCheck(implementation->mpStudioSystem->getEvent(newEventGUID.c_str(), &pEventDescription));
-	if (pEventDescription)
+	// The bank might already be loaded (or loading), in which case we just wait on it again
+	auto tFoundIt = implementation->mBanks.find(strBankName);
+	if (tFoundIt != implementation->mBanks.end())
+	{
+		request->pBank = tFoundIt->second;
+	}
+	else
 	{
-		// Create event instance
-		FMOD::Studio::EventInstance* pEventInstance = NULL;
-		AudioEngine::ErrorCheck(pEventDescription->createInstance(&pEventInstance));
-		if (pEventInstance)
+		AudioEngine::ErrorCheck(implementation->mpBackend->LoadBankFile(("Desktop/" + strBankName + ".bank").c_str(), FMOD_STUDIO_LOAD_BANK_NONBLOCKING, &request->pBank));
+		if (request->pBank)
 		{
-			implementation->mEvents[strEventName] = pEventInstance;
+			implementation->mBanks[strBankName] = request->pBank;
 		}
 	}
+
+	if (!request->pBank)
+	{
+		request->bFailed = true;
+		request->bDone = true;
+	}
+
+	implementation->mLoadRequests.push_back(std::move(request));
+	return (AudioLoadTicket)implementation->mLoadRequests.size();
 }
 
-void AudioEngine::PlayEvent(const std::string& strEventName)
+float AudioEngine::GetLoadProgress(AudioLoadTicket ticket) const
 {
-	// If event not found, load the event
-	auto tFoundIt = implementation->mEvents.find(strEventName);
-	if (tFoundIt == implementation->mEvents.end())
-		return;
+	if (ticket == INVALID_LOAD_TICKET || ticket > implementation->mLoadRequests.size())
+		return 0.0f;
 
-	tFoundIt->second->start();
+	return implementation->mLoadRequests[ticket - 1]->fProgress;
 }
 
-void AudioEngine::StopEvent(const std::string& strEventName, bool bFadeOut)
+bool AudioEngine::IsLoadComplete(AudioLoadTicket ticket) const
 {
-	auto tFoundIt = implementation->mEvents.find(strEventName);
-	if (tFoundIt == implementation->mEvents.end())
-		return;
+	if (ticket == INVALID_LOAD_TICKET || ticket > implementation->mLoadRequests.size())
+		return false;
 
-	FMOD_STUDIO_STOP_MODE eMode;
-	eMode = bFadeOut ? FMOD_STUDIO_STOP_ALLOWFADEOUT : FMOD_STUDIO_STOP_IMMEDIATE;
-	AudioEngine::ErrorCheck(tFoundIt->second->stop(eMode));
+	const Implementation::LoadRequest& request = *implementation->mLoadRequests[ticket - 1];
+	return request.bDone && !request.bFailed;
 }
 
-void AudioEngine::SetEventPosition(const std::string& strEventName, const glm::vec3 vPosition)
+bool AudioEngine::HasLoadFailed(AudioLoadTicket ticket) const
 {
-	// Get instance from map
-	auto tFoundIt = implementation->mEvents.find(strEventName);
-	if (tFoundIt == implementation->mEvents.end())
-		return;
+	if (ticket == INVALID_LOAD_TICKET || ticket > implementation->mLoadRequests.size())
+		return true;
 
-	// Temp Object
-	FMOD_3D_ATTRIBUTES newAttributes;
+	return implementation->mLoadRequests[ticket - 1]->bFailed;
+}
 
-	// Get attribute from event
-	AudioEngine::ErrorCheck(tFoundIt->second->get3DAttributes(&newAttributes));
+void AudioEngine::UnloadAllBanks()
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+	AudioEngine::ErrorCheck(implementation->mpBackend->UnloadAll());
+}
 
-	// Set the new position
-	newAttributes.position = VectorToFmod(vPosition);
 
-	// Set new attribute on event
-	AudioEngine::ErrorCheck(tFoundIt->second->set3DAttributes(&newAttributes));
-}
+//////// Async Loading ////////
 
-bool AudioEngine::isEventPlaying(const std::string& strEventName) const
+void Implementation::UpdateLoadRequests()
 {
-	auto tFoundIt = implementation->mEvents.find(strEventName);
-	if (tFoundIt == implementation->mEvents.end())
-		return false;
-
-	FMOD_STUDIO_PLAYBACK_STATE* state = NULL;
-	if (tFoundIt->second->getPlaybackState(state) == FMOD_STUDIO_PLAYBACK_PLAYING) //help
+	// Progress is split evenly between loading the bank and loading the preloaded sample data
+	for (size_t i = mnFirstPendingLoad; i < mLoadRequests.size(); i++)
 	{
-		return true;
+		LoadRequest& request = *mLoadRequests[i];
+		if (request.bDone)
+			continue;
+
+		if (!request.bMetadataLoaded)
+		{
+			FMOD_STUDIO_LOADING_STATE eState = FMOD_STUDIO_LOADING_STATE_ERROR;
+			mpBackend->GetLoadingState(request.pBank, &eState);
+
+			if (eState == FMOD_STUDIO_LOADING_STATE_ERROR)
+			{
+				std::cout << "Audio Engine: bank failed to load" << std::endl;
+				request.bFailed = true;
+				request.bDone = true;
+				continue;
+			}
+			if (eState != FMOD_STUDIO_LOADING_STATE_LOADED)
+				continue;
+
+			// The bank is in, now we can look up the events and ask for their samples
+			request.bMetadataLoaded = true;
+			for (const std::string& strEventName : request.PreloadEvents)
+			{
+				const FMOD_GUID* pGUID = mGUIDs.Find("event:/", strEventName);
+				if (!pGUID)
+					continue;
+
+				BackendEventDescription* pEventDescription = NULL;
+				AudioEngine::ErrorCheck(mpBackend->GetEventByID(pGUID, &pEventDescription));
+				if (pEventDescription)
+				{
+					AudioEngine::ErrorCheck(mpBackend->LoadSampleData(pEventDescription));
+					request.PreloadDescriptions.push_back(pEventDescription);
+				}
+			}
+		}
+
+		size_t nSamplesLoaded = 0;
+		for (BackendEventDescription* pEventDescription : request.PreloadDescriptions)
+		{
+			FMOD_STUDIO_LOADING_STATE eState = FMOD_STUDIO_LOADING_STATE_ERROR;
+			mpBackend->GetSampleLoadingState(pEventDescription, &eState);
+
+			// Count errors as done, the event will still play, it just has to load its samples first
+			if (eState == FMOD_STUDIO_LOADING_STATE_LOADED || eState == FMOD_STUDIO_LOADING_STATE_ERROR)
+				nSamplesLoaded++;
+		}
+
+		if (nSamplesLoaded == request.PreloadDescriptions.size())
+		{
+			request.fProgress = 1.0f;
+			request.bDone = true;
+		}
+		else
+		{
+			request.fProgress = 0.5f + 0.5f * (float)nSamplesLoaded / (float)request.PreloadDescriptions.size();
+		}
 	}
 
-	return false;
+	// Skip over finished requests next time
+	while (mnFirstPendingLoad < mLoadRequests.size() && mLoadRequests[mnFirstPendingLoad]->bDone)
+		mnFirstPendingLoad++;
 }
 
-//////// FMOD Parameters ////////
 
-void AudioEngine::GetEventParameter(const std::string& strEventName, const std::string& strParameterName, float* parameter)
-{
-	auto tFoundIt = implementation->mEvents.find(strEventName);
-	if (tFoundIt == implementation->mEvents.end())
-		return;
+//////// Staged Attributes ////////
 
-	AudioEngine::ErrorCheck(tFoundIt->second->getParameterByName(strParameterName.c_str(), parameter));
+void Implementation::StagedAttributes::Reset()
+{
+	vPosition = glm::vec3(0.0f);
+	vLastPosition = glm::vec3(0.0f);
+	vForward = glm::vec3(0.0f, 0.0f, 1.0f);
+	vUp = glm::vec3(0.0f, 1.0f, 0.0f);
+	vVelocity = glm::vec3(0.0f);
+	bDirty = false;
+	bHasLastPosition = false;
+	bAutoVelocity = true;
 }
 
-void AudioEngine::SetEventParameter(const std::string& strEventName, const std::string& strParameterName, float fValue)
+bool Implementation::StagedAttributes::Resolve(float fDeltaTime, FMOD_3D_ATTRIBUTES& attributes)
 {
-	auto tFoundIt = implementation->mEvents.find(strEventName);
-	if (tFoundIt == implementation->mEvents.end())
-		return;
+	// Velocity comes from how far we moved since the last flush, so doppler works without the caller doing anything
+	glm::vec3 vAutoVelocity = glm::vec3(0.0f);
+	if (bAutoVelocity && bHasLastPosition && fDeltaTime > 0.0f)
+		vAutoVelocity = (vPosition - vLastPosition) / fDeltaTime;
 
-	AudioEngine::ErrorCheck(tFoundIt->second->setParameterByName(strParameterName.c_str(), fValue));
-}
+	vLastPosition = vPosition;
+	bHasLastPosition = true;
 
-void AudioEngine::SetGlobalParameter(const std::string& strParameterName, float fValue)
-{
-	AudioEngine::ErrorCheck(implementation->mpStudioSystem->setParameterByName(strParameterName.c_str(), fValue));
+	AudioEngine& audioEngine = AudioEngine::GetInstance();
+	attributes.position = audioEngine.VectorToFmod(vPosition);
+	attributes.velocity = audioEngine.VectorToFmod(bAutoVelocity ? vAutoVelocity : vVelocity);
+	attributes.forward = audioEngine.VectorToFmod(vForward);
+	attributes.up = audioEngine.VectorToFmod(vUp);
 
+	return vAutoVelocity != glm::vec3(0.0f);
 }
 
 
-//////// Listeners ////////
+//////// Emitters ////////
 
-void AudioEngine::SetListenerPosition(const glm::vec3& vPosition)
+void Implementation::PositionBatch::Clear()
 {
-	// Temp Object
-	FMOD_3D_ATTRIBUTES tempAttributes;
+	Events.clear();
+	Positions.clear();
+	Velocities.clear();
+	AutoVelocity.clear();
+	CullDistances.clear();
+}
 
-	// Get attribute from event
-	AudioEngine::ErrorCheck(implementation->mpStudioSystem->getListenerAttributes(0, &tempAttributes));
+void Implementation::StageEventPositions(const EventHandle* phEvents, const glm::vec3* pPositions, int nCount,
+	const glm::vec3* pVelocities, const float* pCullDistances)
+{
+	for (int i = 0; i < nCount; i++)
+	{
+		EventHandle hVoice = phEvents[i];
+		EventSlot* pSlot = GetEventSlot(hVoice);
+		if (!pSlot)
+			continue;
 
-	// Set the new position
-	tempAttributes.position = VectorToFmod(vPosition);
-	AudioEngine::ErrorCheck(implementation->mpStudioSystem->setListenerAttributes(0, &tempAttributes));
+		StagedAttributes& attributes = pSlot->attributes;
+		attributes.vPosition = pPositions[i];
+		attributes.bAutoVelocity = !pVelocities;
+		if (pVelocities)
+			attributes.vVelocity = pVelocities[i];
+		// A negative cull distance keeps the one the voice already has
+		if (pCullDistances && pCullDistances[i] >= 0.0f)
+			pSlot->fCullDistance = pCullDistances[i];
 
+		MarkAttributesDirty(hVoice, *pSlot);
+	}
 }
 
-void AudioEngine::SetListenerOrientation(const glm::vec3& vUp, const glm::vec3& vForward)
+void Implementation::PublishPositionBatch()
 {
-	// Temp Object
-	FMOD_3D_ATTRIBUTES tempAttributes;
+	PositionBatch& batch = mPositionBatches.GetBack();
+	if (batch.Events.empty())
+		return;
 
-	// Get attribute from event
-	AudioEngine::ErrorCheck(implementation->mpStudioSystem->getListenerAttributes(0, &tempAttributes));
+	batch.nSequence = ++mnPositionBatchSequence;
+	mPositionBatches.Publish();
 
-	// Set the new position
-	tempAttributes.forward = VectorToFmod(vForward);
-	tempAttributes.up = VectorToFmod(vUp);
-	AudioEngine::ErrorCheck(implementation->mpStudioSystem->setListenerAttributes(0, &tempAttributes));
+	// We get back whichever batch the audio thread isn't holding, it has either been applied or was never going to be
+	mPositionBatches.GetBack().Clear();
+}
 
+void Implementation::ApplyPositionBatch()
+{
+	const PositionBatch& batch = mPositionBatches.GetFront();
+	if (batch.Events.empty() || batch.nSequence == mnAppliedPositionBatch)
+		return;
+
+	mnAppliedPositionBatch = batch.nSequence;
+
+	// Each entry keeps its own velocity mode, so runs of entries that share one are staged together
+	int nCount = (int)batch.Events.size();
+	int nStart = 0;
+	while (nStart < nCount)
+	{
+		bool bAuto = batch.AutoVelocity[nStart] != 0;
+		int nEnd = nStart + 1;
+		while (nEnd < nCount && (batch.AutoVelocity[nEnd] != 0) == bAuto)
+			nEnd++;
+
+		StageEventPositions(&batch.Events[nStart], &batch.Positions[nStart], nEnd - nStart,
+			bAuto ? NULL : &batch.Velocities[nStart], &batch.CullDistances[nStart]);
+		nStart = nEnd;
+	}
+}
+
+
+//////// Event Slots ////////
+
+EventHandle Implementation::CreateEventSlot(BackendEventInstance* pInstance, uint16_t nPool)
+{
+	uint16_t nIndex;
+
+	// Reuse a released slot if we have one, otherwise grow the array
+	if (!mFreeEventSlots.empty())
+	{
+		nIndex = mFreeEventSlots.back();
+		mFreeEventSlots.pop_back();
+	}
+	else
+	{
+		if (mEventSlots.size() > 0xFFFF)
+			return INVALID_EVENT_HANDLE;
+
+		nIndex = (uint16_t)mEventSlots.size();
+		mEventSlots.push_back(EventSlot());
+		mEventSlots.back().nGeneration = 1;
+	}
+
+	EventSlot& slot = mEventSlots[nIndex];
+	slot.pInstance = pInstance;
+	slot.bInUse = true;
+	slot.nPool = nPool;
+	slot.bActive = false;
+	slot.nStartOrder = 0;
+	slot.attributes.Reset();
+	slot.bVirtual = false;
+	slot.fCullDistance = 0.0f;
+	slot.eState = FMOD_STUDIO_PLAYBACK_STOPPED;
+	slot.nStartCount = 0;
+	slot.nStopCount = 0;
+	slot.bTrackTimeline = false;
+	slot.nTimelinePosition = 0;
+	slot.fOcclusion = 0.0f;
+	slot.fOcclusionTarget = 0.0f;
+	slot.ParameterValues.clear();
+	slot.ParameterDirty.clear();
+	slot.DirtyParameters.clear();
+
+	return ((EventHandle)slot.nGeneration << 16) | nIndex;
+}
+
+void Implementation::ReleaseEventSlot(EventHandle hEvent)
+{
+	EventSlot* pSlot = GetEventSlot(hEvent);
+	if (!pSlot)
+		return;
+
+	pSlot->pInstance = NULL;
+	pSlot->bInUse = false;
+
+	// Generation 0 is never handed out, so INVALID_EVENT_HANDLE can never match a slot
+	if (++pSlot->nGeneration == 0)
+		pSlot->nGeneration = 1;
+
+	mFreeEventSlots.push_back((uint16_t)(hEvent & 0xFFFF));
+}
+
+Implementation::EventSlot* Implementation::GetEventSlot(EventHandle hEvent)
+{
+	uint32_t nIndex = hEvent & 0xFFFF;
+	uint16_t nGeneration = (uint16_t)(hEvent >> 16);
+
+	if (nIndex >= mEventSlots.size())
+		return NULL;
+
+	EventSlot& slot = mEventSlots[nIndex];
+	if (slot.nGeneration != nGeneration || !slot.bInUse)
+		return NULL;
+
+	return &slot;
+}
+
+float Implementation::GetStealScore(const EventPool& pool, const EventSlot& slot)
+{
+	// Virtual voices can't be heard, so they always go first
+	if (slot.bVirtual)
+		return FLT_MAX;
+
+	switch (pool.eStealMode)
+	{
+	case VoiceStealMode::Oldest:
+		return (float)(mnNextStartOrder - slot.nStartOrder);
+	case VoiceStealMode::Quietest:
+	{
+		float fAudibility = 1.0f;
+		mpBackend->GetAudibility(slot.pInstance, &fAudibility);
+		return -fAudibility;
+	}
+	case VoiceStealMode::Farthest:
+		return GetNearestListenerDistance(slot.attributes.vPosition);
+	}
+
+	return 0.0f;
+}
+
+EventHandle Implementation::AcquireVoice(EventPool& pool)
+{
+	// Use an idle voice if there is one
+	for (EventHandle hVoice : pool.Voices)
+	{
+		EventSlot* pSlot = GetEventSlot(hVoice);
+		if (pSlot && !pSlot->bActive)
+			return hVoice;
+	}
+
+	// Otherwise steal the busy voice with the best score
+	EventHandle hStolen = INVALID_EVENT_HANDLE;
+	float fBestScore = 0.0f;
+	for (EventHandle hVoice : pool.Voices)
+	{
+		EventSlot* pSlot = GetEventSlot(hVoice);
+		if (!pSlot)
+			continue;
+
+		float fScore = GetStealScore(pool, *pSlot);
+		if (hStolen == INVALID_EVENT_HANDLE || fScore > fBestScore)
+		{
+			hStolen = hVoice;
+			fBestScore = fScore;
+		}
+	}
+
+	// The stolen voice is stopped by StartVoice
+	return hStolen;
+}
+
+EventHandle Implementation::SelectVoice(EventHandle hEvent)
+{
+	EventSlot* pSlot = GetEventSlot(hEvent);
+	if (!pSlot)
+		return INVALID_EVENT_HANDLE;
+
+	// Use the requested voice if it is free, otherwise take one from the pool
+	if (!pSlot->bActive)
+		return hEvent;
+	return AcquireVoice(mEventPools[pSlot->nPool]);
+}
+
+EventHandle Implementation::SelectQueuedVoice(EventHandle hEvent)
+{
+	// Slots and pools only change when the game thread loads or unloads an event, so those are safe to read here.
+	// Whether each voice is busy comes from the snapshot, and from the plays we queued that it hasn't seen yet
+	EventSlot* pSlot = GetEventSlot(hEvent);
+	if (!pSlot)
+		return INVALID_EVENT_HANDLE;
+
+	const Snapshot& snapshot = mSnapshot.GetFront();
+	if (mQueuedPlays.size() < mEventSlots.size())
+		mQueuedPlays.resize(mEventSlots.size(), snapshot.nPlaysStarted);
+
+	auto IsPending = [&](EventHandle hVoice)
+	{
+		return (int32_t)(mQueuedPlays[hVoice & 0xFFFF] - snapshot.nPlaysStarted) > 0;
+	};
+	// Voices loaded since the last tick aren't in the snapshot yet, and can't be playing
+	auto IsFree = [&](EventHandle hVoice)
+	{
+		const VoiceSnapshot* pVoice = snapshot.Find(hVoice);
+		return !IsPending(hVoice) && !(pVoice && pVoice->bActive);
+	};
+
+	if (IsFree(hEvent))
+		return hEvent;
+
+	const EventPool& pool = mEventPools[pSlot->nPool];
+	for (EventHandle hVoice : pool.Voices)
+	{
+		if (IsFree(hVoice))
+			return hVoice;
+	}
+
+	// Steal by the scores from the last tick, voices that are still waiting to start are left alone
+	EventHandle hStolen = INVALID_EVENT_HANDLE;
+	float fBestScore = 0.0f;
+	for (EventHandle hVoice : pool.Voices)
+	{
+		const VoiceSnapshot* pVoice = snapshot.Find(hVoice);
+		if (IsPending(hVoice) || !pVoice)
+			continue;
+
+		if (hStolen == INVALID_EVENT_HANDLE || pVoice->fStealScore > fBestScore)
+		{
+			hStolen = hVoice;
+			fBestScore = pVoice->fStealScore;
+		}
+	}
+
+	// Every voice is already waiting to start, so this one starts over once it has, like playing it twice in a row
+	if (hStolen == INVALID_EVENT_HANDLE)
+		hStolen = hEvent;
+	return hStolen;
+}
+
+EventHandle Implementation::StartVoice(EventHandle hEvent, EventHandle hVoice)
+{
+	EventSlot* pSlot = GetEventSlot(hEvent);
+	EventSlot* pVoice = GetEventSlot(hVoice);
+	if (!pSlot || !pVoice)
+		return INVALID_EVENT_HANDLE;
+
+	// Evicted and on demand events get their instances back first
+	if (!MakeResident(pSlot->nPool))
+		return INVALID_EVENT_HANDLE;
+	mEventPools[pSlot->nPool].nLastPlayed = mnFrame;
+
+	if (!pVoice->pInstance)
+		return INVALID_EVENT_HANDLE;
+
+	// A busy voice is being stolen, so it starts over from the beginning
+	if (pVoice->bActive)
+	{
+		AudioEngine::ErrorCheck(mpBackend->Stop(pVoice->pInstance, FMOD_STUDIO_STOP_IMMEDIATE));
+		pVoice->nStopCount++;
+	}
+
+	// A stolen voice may have been paused by culling, it gets culled again next update if needed
+	SetVoiceVirtual(hVoice, false);
+
+	// A different voice starts where the requested one was placed
+	if (hVoice != hEvent)
+	{
+		pVoice->attributes.vPosition = pSlot->attributes.vPosition;
+		pVoice->attributes.vForward = pSlot->attributes.vForward;
+		pVoice->attributes.vUp = pSlot->attributes.vUp;
+	}
+
+	// Don't work out a velocity from wherever the voice was last played
+	pVoice->attributes.bHasLastPosition = false;
+	MarkAttributesDirty(hVoice, *pVoice);
+
+	AudioEngine::ErrorCheck(mpBackend->Start(pVoice->pInstance));
+
+	if (!pVoice->bActive)
+	{
+		pVoice->bActive = true;
+		mActiveVoices.push_back(hVoice);
+	}
+	pVoice->nStartOrder = mnNextStartOrder++;
+	pVoice->eState = FMOD_STUDIO_PLAYBACK_STARTING;
+	pVoice->nStartCount++;
+
+	return hVoice;
+}
+
+void Implementation::RecycleStoppedVoices()
+{
+	// Walk backwards so we can swap-remove without skipping anything
+	for (size_t i = mActiveVoices.size(); i-- > 0;)
+	{
+		EventSlot* pSlot = GetEventSlot(mActiveVoices[i]);
+
+		// This is the only place playback state is read from the backend, the cache is built from it
+		bool bStopped = true;
+		if (pSlot)
+		{
+			FMOD_STUDIO_PLAYBACK_STATE eState = FMOD_STUDIO_PLAYBACK_STOPPED;
+			mpBackend->GetPlaybackState(pSlot->pInstance, &eState);
+			pSlot->eState = eState;
+			bStopped = eState == FMOD_STUDIO_PLAYBACK_STOPPED;
+
+			if (pSlot->bTrackTimeline && !bStopped)
+				mpBackend->GetTimelinePosition(pSlot->pInstance, &pSlot->nTimelinePosition);
+		}
+
+		if (bStopped)
+		{
+			if (pSlot)
+			{
+				pSlot->nTimelinePosition = 0;
+				pSlot->bActive = false;
+
+				// The next play starts from wherever it is played, so don't ramp in from this one's occlusion
+				if (pSlot->fOcclusion != 0.0f)
+				{
+					pSlot->fOcclusion = 0.0f;
+					StageParameter(mActiveVoices[i], mEventPools[pSlot->nPool].hOcclusionParameter, 0.0f);
+				}
+				pSlot->fOcclusionTarget = 0.0f;
+				pSlot->nStopCount++;
+				SetVoiceVirtual(mActiveVoices[i], false);
+			}
+
+			mActiveVoices[i] = mActiveVoices.back();
+			mActiveVoices.pop_back();
+		}
+	}
+}
+
+
+//////// Sample Residency ////////
+
+bool Implementation::MakeResident(uint16_t nPool)
+{
+	EventPool& pool = mEventPools[nPool];
+	if (pool.bResident)
+		return true;
+	if (!pool.pDescription)
+		return false;
+
+	// Creating the instances is what makes FMOD load the sample data
+	bool bAnyInstances = false;
+	for (EventHandle hVoice : pool.Voices)
+	{
+		EventSlot* pSlot = GetEventSlot(hVoice);
+		if (!pSlot)
+			continue;
+
+		if (!pSlot->pInstance)
+		{
+			AudioEngine::ErrorCheck(mpBackend->CreateInstance(pool.pDescription, &pSlot->pInstance));
+			if (!pSlot->pInstance)
+				continue;
+
+			// Catch the new instance up with the position and parameters the old one had
+			pSlot->attributes.bHasLastPosition = false;
+			MarkAttributesDirty(hVoice, *pSlot);
+			for (size_t i = 0; i < pSlot->ParameterValues.size(); i++)
+			{
+				if (std::isnan(pSlot->ParameterValues[i]) || pSlot->ParameterDirty[i])
+					continue;
+
+				pSlot->ParameterDirty[i] = 1;
+				pSlot->DirtyParameters.push_back((uint16_t)i);
+			}
+			if (!pSlot->DirtyParameters.empty())
+				mParameterVoices.push_back(hVoice);
+		}
+		bAnyInstances = true;
+	}
+
+	if (!bAnyInstances)
+		return false;
+
+	pool.bResident = true;
+	mnResidentSampleBytes += pool.nSampleBytes;
+	return true;
+}
+
+void Implementation::Evict(uint16_t nPool)
+{
+	EventPool& pool = mEventPools[nPool];
+	if (!pool.bResident)
+		return;
+
+	// FMOD unloads the sample data once the last instance is released
+	for (EventHandle hVoice : pool.Voices)
+	{
+		EventSlot* pSlot = GetEventSlot(hVoice);
+		if (!pSlot || !pSlot->pInstance)
+			continue;
+
+		AudioEngine::ErrorCheck(mpBackend->Release(pSlot->pInstance));
+		pSlot->pInstance = NULL;
+	}
+
+	pool.bResident = false;
+	mnResidentSampleBytes -= pool.nSampleBytes;
+}
+
+bool Implementation::IsPoolIdle(const EventPool& pool)
+{
+	for (EventHandle hVoice : pool.Voices)
+	{
+		EventSlot* pSlot = GetEventSlot(hVoice);
+		if (pSlot && pSlot->bActive)
+			return false;
+	}
+
+	return true;
+}
+
+void Implementation::MeasureSampleBytes(EventPool& pool)
+{
+	FMOD_STUDIO_LOADING_STATE eState = FMOD_STUDIO_LOADING_STATE_ERROR;
+	mpBackend->GetSampleLoadingState(pool.pDescription, &eState);
+	if (eState == FMOD_STUDIO_LOADING_STATE_LOADING || eState == FMOD_STUDIO_LOADING_STATE_UNLOADED)
+		return;
+
+	// Only asked once, a release build of FMOD reports 0 and we keep the estimate
+	pool.bSampleBytesMeasured = true;
+	EventSlot* pSlot = GetEventSlot(pool.Voices[0]);
+	FMOD_STUDIO_MEMORY_USAGE usage = {};
+	if (eState != FMOD_STUDIO_LOADING_STATE_LOADED || !pSlot || !pSlot->pInstance ||
+		mpBackend->GetMemoryUsage(pSlot->pInstance, &usage) != FMOD_OK || usage.sampledata <= 0)
+		return;
+
+	mnResidentSampleBytes = mnResidentSampleBytes - pool.nSampleBytes + (size_t)usage.sampledata;
+	pool.nSampleBytes = (size_t)usage.sampledata;
+}
+
+void Implementation::UpdateResidency()
+{
+	for (size_t i = 0; i < mEventPools.size(); i++)
+	{
+		EventPool& pool = mEventPools[i];
+		if (!pool.bResident)
+			continue;
+
+		// Streamed events let go as soon as they are done, keeping them around saves nothing
+		if (pool.ePolicy == SamplePolicy::Stream && IsPoolIdle(pool))
+		{
+			Evict((uint16_t)i);
+			continue;
+		}
+
+		if (!pool.bSampleBytesMeasured)
+			MeasureSampleBytes(pool);
+	}
+
+	if (mnSampleBudget == 0 || mnResidentSampleBytes <= mnSampleBudget)
+		return;
+
+	// Over budget, evict the least recently played Auto events that aren't playing until we fit
+	mEvictionCandidates.clear();
+	for (size_t i = 0; i < mEventPools.size(); i++)
+	{
+		const EventPool& pool = mEventPools[i];
+		if (pool.bResident && pool.ePolicy == SamplePolicy::Auto && IsPoolIdle(pool))
+			mEvictionCandidates.push_back((uint16_t)i);
+	}
+	std::sort(mEvictionCandidates.begin(), mEvictionCandidates.end(), [this](uint16_t nA, uint16_t nB)
+	{
+		return mEventPools[nA].nLastPlayed < mEventPools[nB].nLastPlayed;
+	});
+
+	for (uint16_t nPool : mEvictionCandidates)
+	{
+		if (mnResidentSampleBytes <= mnSampleBudget)
+			break;
+
+		Evict(nPool);
+	}
+}
+
+const std::string& Implementation::FindEventBank(BackendEventDescription* pDescription)
+{
+	static const std::string strNoBank;
+
+	// Banks are asked for their event list once, the first time an event is loaded after they finish loading
+	std::vector<BackendEventDescription*> descriptions;
+	for (auto& bank : mBanks)
+	{
+		if (std::find(mIndexedBanks.begin(), mIndexedBanks.end(), bank.second) != mIndexedBanks.end())
+			continue;
+
+		FMOD_STUDIO_LOADING_STATE eState = FMOD_STUDIO_LOADING_STATE_ERROR;
+		mpBackend->GetLoadingState(bank.second, &eState);
+		if (eState != FMOD_STUDIO_LOADING_STATE_LOADED)
+			continue;
+
+		int nCount = 0;
+		if (mpBackend->GetEventCount(bank.second, &nCount) != FMOD_OK)
+			continue;
+
+		descriptions.resize(nCount);
+		if (nCount > 0 && mpBackend->GetEventList(bank.second, descriptions.data(), nCount, &nCount) != FMOD_OK)
+			continue;
+
+		for (int i = 0; i < nCount; i++)
+		{
+			mEventBanks[descriptions[i]] = bank.first;
+		}
+		mIndexedBanks.push_back(bank.second);
+	}
+
+	auto tFoundIt = mEventBanks.find(pDescription);
+	return tFoundIt != mEventBanks.end() ? tFoundIt->second : strNoBank;
+}
+
+void AudioEngine::SetSampleResidencySettings(size_t nBudgetBytes, float fShortEventLength)
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+	implementation->mnSampleBudget = nBudgetBytes;
+	implementation->mfShortEventLength = fShortEventLength;
+}
+
+size_t AudioEngine::GetResidentSampleBytes() const
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+	return implementation->mnResidentSampleBytes;
+}
+
+size_t AudioEngine::GetResidentSampleBytes(const std::string& strBankName) const
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+
+	size_t nBytes = 0;
+	for (const Implementation::EventPool& pool : implementation->mEventPools)
+	{
+		if (pool.bResident && pool.strBank == strBankName)
+			nBytes += pool.nSampleBytes;
+	}
+
+	return nBytes;
+}
+
+void AudioEngine::GetSampleMemory(std::vector<EventSampleMemory>& events) const
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+
+	events.clear();
+	for (const Implementation::EventPool& pool : implementation->mEventPools)
+	{
+		// Pools of unloaded events sit empty until LoadEvent reuses them
+		if (!pool.pDescription)
+			continue;
+
+		EventSampleMemory event;
+		event.strEvent = pool.strName;
+		event.strBank = pool.strBank;
+		event.ePolicy = pool.ePolicy;
+		event.bResident = pool.bResident;
+		event.nBytes = pool.nSampleBytes;
+		event.bEstimated = !pool.bSampleBytesMeasured;
+		event.nLastPlayed = pool.nLastPlayed;
+		events.push_back(event);
+	}
+}
+
+void AudioEngine::PrintSampleMemory() const
+{
+	static const char* POLICY_NAMES[] = { "auto", "preload", "stream" };
+
+	std::vector<EventSampleMemory> events;
+	GetSampleMemory(events);
+
+	std::map<std::string, size_t> banks;
+	size_t nTotal = 0;
+	for (const EventSampleMemory& event : events)
+	{
+		if (!event.bResident)
+			continue;
+
+		banks[event.strBank.empty() ? "(no bank)" : event.strBank] += event.nBytes;
+		nTotal += event.nBytes;
+	}
+
+	std::cout << "Audio Engine: " << nTotal / 1024 << "KB of sample data resident";
+	if (implementation->mnSampleBudget > 0)
+		std::cout << " (budget " << implementation->mnSampleBudget / 1024 << "KB)";
+	std::cout << std::endl;
+
+	for (auto& bank : banks)
+	{
+		std::cout << "\tbank " << bank.first << ": " << bank.second / 1024 << "KB" << std::endl;
+	}
+	for (const EventSampleMemory& event : events)
+	{
+		std::cout << "\tevent " << event.strEvent << " (" << POLICY_NAMES[(int)event.ePolicy] << "): "
+			<< (event.bResident ? "resident, " : "evicted, ") << event.nBytes / 1024 << "KB"
+			<< (event.bEstimated ? " estimated" : "") << std::endl;
+	}
+}
+
+
+//////// Events ////////
+
+EventHandle AudioEngine::LoadEvent(const std::string& strEventName, int nMaxVoices, VoiceStealMode eStealMode, SamplePolicy ePolicy)
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+
+	// Return the existing handle if the event is already loaded
+	auto tFoundEvent = implementation->mEvents.find(strEventName);
+	if (tFoundEvent != implementation->mEvents.end())
+		return tFoundEvent->second;
+
+	// Return if the GUID does not exist
+	const FMOD_GUID* pEventGUID = implementation->mGUIDs.Find("event:/", strEventName);
+	if (!pEventGUID)
+		return INVALID_EVENT_HANDLE;
+
+	// Load event using the GUID
+	AudioBackend& backend = *implementation->mpBackend;
+	BackendEventDescription* pEventDescription = NULL;
+	AudioEngine::ErrorCheck(backend.GetEventByID(pEventGUID, &pEventDescription));
+	if (!pEventDescription)
+		return INVALID_EVENT_HANDLE;
+
+	Implementation::EventPool pool;
+	pool.pDescription = pEventDescription;
+	pool.strName = strEventName;
+	pool.eStealMode = eStealMode;
+	pool.b3D = false;
+	pool.fMinDistance = 1.0f;
+	pool.fMaxDistance = 20.0f;
+	AudioEngine::ErrorCheck(backend.Is3D(pEventDescription, &pool.b3D));
+	AudioEngine::ErrorCheck(backend.GetMinimumDistance(pEventDescription, &pool.fMinDistance));
+	AudioEngine::ErrorCheck(backend.GetMaximumDistance(pEventDescription, &pool.fMaxDistance));
+
+	// Reuse the pool of an unloaded event if there is one, so loading and unloading doesn't grow the array
+	uint16_t nPool;
+	if (!implementation->mFreeEventPools.empty())
+	{
+		nPool = implementation->mFreeEventPools.back();
+	}
+	else
+	{
+		if (implementation->mEventPools.size() > 0xFFFF)
+			return INVALID_EVENT_HANDLE;
+		nPool = (uint16_t)implementation->mEventPools.size();
+	}
+
+	// Until FMOD can tell us how much memory the samples take, go by how long the event is
+	int nLength = 0;
+	bool bStream = false;
+	AudioEngine::ErrorCheck(backend.GetLength(pEventDescription, &nLength));
+	AudioEngine::ErrorCheck(backend.IsStream(pEventDescription, &bStream));
+	float fLength = nLength / 1000.0f;
+
+	pool.ePolicy = (ePolicy == SamplePolicy::Auto && bStream) ? SamplePolicy::Stream : ePolicy;
+	pool.strBank = implementation->FindEventBank(pEventDescription);
+	pool.bResident = false;
+	pool.nSampleBytes = bStream ? STREAM_BUFFER_BYTES : (size_t)(std::max(fLength, 1.0f) * ESTIMATED_SAMPLE_BYTES_PER_SECOND);
+	pool.bSampleBytesMeasured = false;
+	pool.nLastPlayed = implementation->mnFrame;
+	pool.hOcclusionParameter = INVALID_PARAMETER_HANDLE;
+	pool.bOcclusionResolved = false;
+	pool.nParameterNamesVersion = ++implementation->mnParameterNamesVersion;
+
+	// The voices get their instances once the event is resident
+	for (int i = 0; i < std::max(nMaxVoices, 1); i++)
+	{
+		EventHandle hVoice = implementation->CreateEventSlot(NULL, nPool);
+		if (hVoice == INVALID_EVENT_HANDLE)
+			break;
+
+		pool.Voices.push_back(hVoice);
+	}
+
+	if (pool.Voices.empty())
+		return INVALID_EVENT_HANDLE;
+
+	if (nPool < implementation->mEventPools.size())
+	{
+		implementation->mEventPools[nPool] = pool;
+		implementation->mFreeEventPools.pop_back();
+	}
+	else
+	{
+		implementation->mEventPools.push_back(pool);
+	}
+
+	// Short events are loaded now so they play straight away, the rest wait until they are played
+	bool bShort = nLength > 0 && fLength <= implementation->mfShortEventLength;
+	if (pool.ePolicy == SamplePolicy::Preload || (pool.ePolicy == SamplePolicy::Auto && bShort))
+	{
+		if (pool.ePolicy == SamplePolicy::Preload)
+			AudioEngine::ErrorCheck(backend.LoadSampleData(pEventDescription));
+		implementation->MakeResident(nPool);
+	}
+
+	implementation->mEvents[strEventName] = pool.Voices[0];
+	return pool.Voices[0];
+}
+
+void AudioEngine::UnloadEvent(EventHandle hEvent)
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+
+	Implementation::EventSlot* pSlot = implementation->GetEventSlot(hEvent);
+	if (!pSlot)
+		return;
+
+	// Unloading any voice unloads the whole event
+	uint16_t nPool = pSlot->nPool;
+	Implementation::EventPool& pool = implementation->mEventPools[nPool];
+	for (EventHandle hVoice : pool.Voices)
+	{
+		Implementation::EventSlot* pVoice = implementation->GetEventSlot(hVoice);
+		if (!pVoice)
+			continue;
+
+		if (pVoice->pInstance)
+		{
+			AudioEngine::ErrorCheck(implementation->mpBackend->Stop(pVoice->pInstance, FMOD_STUDIO_STOP_IMMEDIATE));
+			AudioEngine::ErrorCheck(implementation->mpBackend->Release(pVoice->pInstance));
+		}
+		implementation->ReleaseEventSlot(hVoice);
+	}
+
+	if (pool.ePolicy == SamplePolicy::Preload)
+		AudioEngine::ErrorCheck(implementation->mpBackend->UnloadSampleData(pool.pDescription));
+	if (pool.bResident)
+	{
+		implementation->mnResidentSampleBytes -= pool.nSampleBytes;
+		pool.bResident = false;
+	}
+
+	// Forget the name so the event can be loaded again later
+	for (auto it = implementation->mEvents.begin(); it != implementation->mEvents.end(); ++it)
+	{
+		if (it->second == pool.Voices[0])
+		{
+			implementation->mEvents.erase(it);
+			break;
+		}
+	}
+
+	// Released voices are dropped from mActiveVoices on the next update. The pool is emptied out (a new version
+	// so the snapshot drops its parameter names too) and handed to the next LoadEvent
+	pool = Implementation::EventPool();
+	pool.nParameterNamesVersion = ++implementation->mnParameterNamesVersion;
+	implementation->mFreeEventPools.push_back(nPool);
+}
+
+EventHandle AudioEngine::GetEventHandle(const std::string& strEventName) const
+{
+	auto tFoundIt = implementation->mEvents.find(strEventName);
+	if (tFoundIt == implementation->mEvents.end())
+		return INVALID_EVENT_HANDLE;
+
+	return tFoundIt->second;
+}
+
+void AudioEngine::StopAllVoices(EventHandle hEvent, bool bFadeOut)
+{
+	if (implementation->ShouldQueue())
+	{
+		AudioCommand command = { AudioCommand::Type::StopAllVoices, hEvent, bFadeOut };
+		implementation->Enqueue(command);
+		return;
+	}
+
+	Implementation::EventSlot* pSlot = implementation->GetEventSlot(hEvent);
+	if (!pSlot)
+		return;
+
+	for (EventHandle hVoice : implementation->mEventPools[pSlot->nPool].Voices)
+	{
+		StopEvent(hVoice, bFadeOut);
+	}
+}
+
+int AudioEngine::GetActiveVoiceCount(EventHandle hEvent) const
+{
+	Implementation::EventSlot* pSlot = implementation->GetEventSlot(hEvent);
+	if (!pSlot)
+		return 0;
+
+	int nCount = 0;
+	if (implementation->ShouldQueue())
+	{
+		const Implementation::Snapshot& snapshot = implementation->mSnapshot.GetFront();
+		for (EventHandle hVoice : implementation->mEventPools[pSlot->nPool].Voices)
+		{
+			const Implementation::VoiceSnapshot* pVoice = snapshot.Find(hVoice);
+			if (pVoice && pVoice->bActive)
+				nCount++;
+		}
+	}
+	else
+	{
+		for (EventHandle hVoice : implementation->mEventPools[pSlot->nPool].Voices)
+		{
+			Implementation::EventSlot* pVoice = implementation->GetEventSlot(hVoice);
+			if (pVoice && pVoice->bActive)
+				nCount++;
+		}
+	}
+
+	return nCount;
+}
+
+EventHandle AudioEngine::PlayEvent(EventHandle hEvent)
+{
+	if (implementation->ShouldQueue())
+	{
+		// Pick the voice now so the caller gets back the one that will actually play, without waiting on the tick
+		EventHandle hVoice = implementation->SelectQueuedVoice(hEvent);
+		if (hVoice == INVALID_EVENT_HANDLE)
+			return INVALID_EVENT_HANDLE;
+
+		AudioCommand command = { AudioCommand::Type::PlayEvent, hEvent };
+		command.hVoice = hVoice;
+		if (!implementation->Enqueue(command))
+			return INVALID_EVENT_HANDLE;
+		implementation->mQueuedPlays[hVoice & 0xFFFF] = ++implementation->mnPlaysQueued;
+		return hVoice;
+	}
+
+	return implementation->StartVoice(hEvent, implementation->SelectVoice(hEvent));
+}
+
+void AudioEngine::StopEvent(EventHandle hEvent, bool bFadeOut)
+{
+	if (implementation->ShouldQueue())
+	{
+		AudioCommand command = { AudioCommand::Type::StopEvent, hEvent, bFadeOut };
+		implementation->Enqueue(command);
+		return;
+	}
+
+	Implementation::EventSlot* pSlot = implementation->GetEventSlot(hEvent);
+	if (!pSlot || !pSlot->pInstance)
+		return;
+
+	FMOD_STUDIO_STOP_MODE eMode;
+	eMode = bFadeOut ? FMOD_STUDIO_STOP_ALLOWFADEOUT : FMOD_STUDIO_STOP_IMMEDIATE;
+	AudioEngine::ErrorCheck(implementation->mpBackend->Stop(pSlot->pInstance, eMode));
+}
+
+void AudioEngine::SetEventPosition(EventHandle hEvent, const glm::vec3& vPosition)
+{
+	if (implementation->ShouldQueue())
+	{
+		AudioCommand command = { AudioCommand::Type::SetEventPosition, hEvent };
+		command.vA = vPosition;
+		implementation->Enqueue(command);
+		return;
+	}
+
+	Implementation::EventSlot* pSlot = implementation->GetEventSlot(hEvent);
+	if (!pSlot)
+		return;
+
+	// Stage the position, it is sent to FMOD on the next update
+	pSlot->attributes.vPosition = vPosition;
+	pSlot->attributes.bAutoVelocity = true;
+	implementation->MarkAttributesDirty(hEvent, *pSlot);
+}
+
+void AudioEngine::SetEventPositions(const EventHandle* phEvents, const glm::vec3* pPositions, int nCount,
+	const glm::vec3* pVelocities, const float* pCullDistances)
+{
+	if (nCount <= 0)
+		return;
+
+	if (!implementation->ShouldQueue())
+	{
+		implementation->StageEventPositions(phEvents, pPositions, nCount, pVelocities, pCullDistances);
+		return;
+	}
+
+	// One copy into the frame's batch instead of a command per voice, so thousands of emitters can't fill the queue.
+	// Entries without a cull distance keep the one they were last given.
+	Implementation::PositionBatch& batch = implementation->mPositionBatches.GetBack();
+	batch.Events.insert(batch.Events.end(), phEvents, phEvents + nCount);
+	batch.Positions.insert(batch.Positions.end(), pPositions, pPositions + nCount);
+	if (pVelocities)
+		batch.Velocities.insert(batch.Velocities.end(), pVelocities, pVelocities + nCount);
+	else
+		batch.Velocities.resize(batch.Velocities.size() + nCount, glm::vec3(0.0f));
+	batch.AutoVelocity.resize(batch.AutoVelocity.size() + nCount, pVelocities ? 0 : 1);
+	if (pCullDistances)
+		batch.CullDistances.insert(batch.CullDistances.end(), pCullDistances, pCullDistances + nCount);
+	else
+		batch.CullDistances.resize(batch.CullDistances.size() + nCount, -1.0f);
+}
+
+void AudioEngine::SetEventOrientation(EventHandle hEvent, const glm::vec3& vUp, const glm::vec3& vForward)
+{
+	if (implementation->ShouldQueue())
+	{
+		AudioCommand command = { AudioCommand::Type::SetEventOrientation, hEvent };
+		command.vA = vUp;
+		command.vB = vForward;
+		implementation->Enqueue(command);
+		return;
+	}
+
+	Implementation::EventSlot* pSlot = implementation->GetEventSlot(hEvent);
+	if (!pSlot)
+		return;
+
+	pSlot->attributes.vForward = vForward;
+	pSlot->attributes.vUp = vUp;
+	implementation->MarkAttributesDirty(hEvent, *pSlot);
+}
+
+FMOD_STUDIO_PLAYBACK_STATE AudioEngine::GetPlaybackState(EventHandle hEvent) const
+{
+	const Implementation::PlaybackCacheEntry* pEntry = implementation->FindPlaybackState(hEvent);
+	return pEntry ? pEntry->eState : FMOD_STUDIO_PLAYBACK_STOPPED;
+}
+
+bool AudioEngine::isEventPlaying(EventHandle hEvent) const
+{
+	return GetPlaybackState(hEvent) != FMOD_STUDIO_PLAYBACK_STOPPED;
+}
+
+bool AudioEngine::EventJustStarted(EventHandle hEvent) const
+{
+	const Implementation::PlaybackCacheEntry* pEntry = implementation->FindPlaybackState(hEvent);
+	return pEntry && pEntry->bJustStarted;
+}
+
+bool AudioEngine::EventJustStopped(EventHandle hEvent) const
+{
+	const Implementation::PlaybackCacheEntry* pEntry = implementation->FindPlaybackState(hEvent);
+	return pEntry && pEntry->bJustStopped;
+}
+
+void AudioEngine::TrackTimelinePosition(EventHandle hEvent, bool bTrack)
+{
+	if (implementation->ShouldQueue())
+	{
+		AudioCommand command = { AudioCommand::Type::TrackTimelinePosition, hEvent, bTrack };
+		implementation->Enqueue(command);
+		return;
+	}
+
+	Implementation::EventSlot* pSlot = implementation->GetEventSlot(hEvent);
+	if (!pSlot)
+		return;
+
+	pSlot->bTrackTimeline = bTrack;
+	if (!bTrack)
+		pSlot->nTimelinePosition = 0;
+}
+
+float AudioEngine::GetTimelinePosition(EventHandle hEvent) const
+{
+	const Implementation::PlaybackCacheEntry* pEntry = implementation->FindPlaybackState(hEvent);
+	return pEntry ? pEntry->nTimelinePosition / 1000.0f : 0.0f;
+}
+
+EventHandle AudioEngine::PlayEvent(const std::string& strEventName)
+{
+	return PlayEvent(GetEventHandle(strEventName));
+}
+
+void AudioEngine::StopEvent(const std::string& strEventName, bool bFadeOut)
+{
+	StopEvent(GetEventHandle(strEventName), bFadeOut);
+}
+
+void AudioEngine::SetEventPosition(const std::string& strEventName, const glm::vec3 vPosition)
+{
+	SetEventPosition(GetEventHandle(strEventName), vPosition);
+}
+
+bool AudioEngine::isEventPlaying(const std::string& strEventName) const
+{
+	return isEventPlaying(GetEventHandle(strEventName));
+}
+
+//////// Channel Slots ////////
+
+ChannelHandle Implementation::CreateChannelSlot(bool b3D)
+{
+	uint16_t nIndex;
+
+	if (!mFreeChannelSlots.empty())
+	{
+		nIndex = mFreeChannelSlots.back();
+		mFreeChannelSlots.pop_back();
+	}
+	else
+	{
+		if (mChannelSlots.size() > 0xFFFF)
+			return INVALID_CHANNEL_HANDLE;
+
+		nIndex = (uint16_t)mChannelSlots.size();
+		mChannelSlots.push_back(ChannelSlot());
+		mChannelSlots.back().nGeneration = 1;
+
+		// Grow these alongside the slots, so releasing a slot never has to allocate
+		mFreeChannelSlots.reserve(mChannelSlots.capacity());
+		mActiveChannels.reserve(mChannelSlots.capacity());
+	}
+
+	ChannelSlot& slot = mChannelSlots[nIndex];
+	slot.pChannel = NULL;
+	slot.nActiveIndex = (uint16_t)mActiveChannels.size();
+	slot.b3D = b3D;
+
+	ChannelHandle hChannel = ((ChannelHandle)slot.nGeneration << 16) | nIndex;
+	mActiveChannels.push_back(hChannel);
+	return hChannel;
+}
+
+void Implementation::ReleaseChannelSlot(ChannelHandle hChannel)
+{
+	uint32_t nIndex = hChannel & 0xFFFF;
+	if (nIndex >= mChannelSlots.size() || mChannelSlots[nIndex].nGeneration != (uint16_t)(hChannel >> 16))
+		return;
+
+	ChannelSlot& slot = mChannelSlots[nIndex];
+	slot.pChannel = NULL;
+
+	// Swap remove from the active list
+	ChannelHandle hLast = mActiveChannels.back();
+	mActiveChannels[slot.nActiveIndex] = hLast;
+	mChannelSlots[hLast & 0xFFFF].nActiveIndex = slot.nActiveIndex;
+	mActiveChannels.pop_back();
+
+	if (++slot.nGeneration == 0)
+		slot.nGeneration = 1;
+
+	mFreeChannelSlots.push_back((uint16_t)nIndex);
+}
+
+Implementation::ChannelSlot* Implementation::GetChannelSlot(ChannelHandle hChannel)
+{
+	uint32_t nIndex = hChannel & 0xFFFF;
+	uint16_t nGeneration = (uint16_t)(hChannel >> 16);
+
+	if (nIndex >= mChannelSlots.size())
+		return NULL;
+
+	ChannelSlot& slot = mChannelSlots[nIndex];
+	if (slot.nGeneration != nGeneration || slot.pChannel == NULL)
+		return NULL;
+
+	return &slot;
+}
+
+void Implementation::ReclaimEndedChannels()
+{
+	// Only channels that actually ended are touched, the generation check skips any that were already released
+	for (uint32_t nChannelId : mpBackend->GetEndedChannels())
+	{
+		ReleaseChannelSlot((ChannelHandle)nChannelId);
+	}
+	mpBackend->ClearEndedChannels();
+}
+
+
+//////// Sounds ////////
+
+void AudioEngine::LoadSound(const std::string& strSoundName, bool b3D, bool bLooping, bool bStream)
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+
+	auto tFoundIt = implementation->mSounds.find(strSoundName);
+	if (tFoundIt != implementation->mSounds.end())
+		return;
+
+	FMOD_MODE eMode = FMOD_DEFAULT;
+	eMode |= b3D ? FMOD_3D : FMOD_2D;
+	eMode |= bLooping ? FMOD_LOOP_NORMAL : FMOD_LOOP_OFF;
+	eMode |= bStream ? FMOD_CREATESTREAM : FMOD_CREATECOMPRESSEDSAMPLE;
+
+	BackendSound* pSound = NULL;
+	AudioEngine::ErrorCheck(implementation->mpBackend->CreateSound(strSoundName.c_str(), eMode, &pSound));
+	if (pSound)
+	{
+		implementation->mSounds[strSoundName] = { pSound, b3D };
+	}
+}
+
+void AudioEngine::UnloadSound(const std::string& strSoundName)
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+
+	auto tFoundIt = implementation->mSounds.find(strSoundName);
+	if (tFoundIt == implementation->mSounds.end())
+		return;
+
+	// Its channels stop, and are reclaimed on the next update when their end callbacks come in
+	AudioEngine::ErrorCheck(implementation->mpBackend->ReleaseSound(tFoundIt->second.pSound));
+	implementation->mSounds.erase(tFoundIt);
+}
+
+ChannelHandle AudioEngine::PlaySound(const std::string& strSoundName, const glm::vec3& vPosition, float fVolumeDb)
+{
+	auto tFoundIt = implementation->mSounds.find(strSoundName);
+	if (tFoundIt == implementation->mSounds.end())
+	{
+		LoadSound(strSoundName);
+		tFoundIt = implementation->mSounds.find(strSoundName);
+		if (tFoundIt == implementation->mSounds.end())
+			return INVALID_CHANNEL_HANDLE;
+	}
+
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+
+	const Implementation::Sound& sound = tFoundIt->second;
+	ChannelHandle hChannel = implementation->CreateChannelSlot(sound.b3D);
+	if (hChannel == INVALID_CHANNEL_HANDLE)
+		return INVALID_CHANNEL_HANDLE;
+
+	// Start paused so the position and volume are in place before the first sample plays
+	BackendChannel* pChannel = NULL;
+	AudioEngine::ErrorCheck(implementation->mpBackend->PlaySound(sound.pSound, hChannel, true, &pChannel));
+	if (!pChannel)
+	{
+		implementation->ReleaseChannelSlot(hChannel);
+		return INVALID_CHANNEL_HANDLE;
+	}
+	implementation->mChannelSlots[hChannel & 0xFFFF].pChannel = pChannel;
+
+	if (sound.b3D)
+		AudioEngine::ErrorCheck(implementation->mpBackend->SetChannel3DAttributes(pChannel, VectorToFmod(vPosition), VectorToFmod(glm::vec3(0.0f))));
+	AudioEngine::ErrorCheck(implementation->mpBackend->SetChannelVolume(pChannel, dbToVolume(fVolumeDb)));
+	AudioEngine::ErrorCheck(implementation->mpBackend->SetChannelPaused(pChannel, false));
+
+	return hChannel;
+}
+
+void AudioEngine::StopChannel(ChannelHandle hChannel)
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+
+	Implementation::ChannelSlot* pSlot = implementation->GetChannelSlot(hChannel);
+	if (!pSlot)
+		return;
+
+	AudioEngine::ErrorCheck(implementation->mpBackend->StopChannel(pSlot->pChannel));
+}
+
+void AudioEngine::SetChannelPosition(ChannelHandle hChannel, const glm::vec3& vPosition)
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+
+	Implementation::ChannelSlot* pSlot = implementation->GetChannelSlot(hChannel);
+	if (!pSlot || !pSlot->b3D)
+		return;
+
+	AudioEngine::ErrorCheck(implementation->mpBackend->SetChannel3DAttributes(pSlot->pChannel, VectorToFmod(vPosition), VectorToFmod(glm::vec3(0.0f))));
+}
+
+void AudioEngine::SetChannelVolume(ChannelHandle hChannel, float fVolumeDb)
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+
+	Implementation::ChannelSlot* pSlot = implementation->GetChannelSlot(hChannel);
+	if (!pSlot)
+		return;
+
+	AudioEngine::ErrorCheck(implementation->mpBackend->SetChannelVolume(pSlot->pChannel, dbToVolume(fVolumeDb)));
+}
+
+bool AudioEngine::IsChannelPlaying(ChannelHandle hChannel) const
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+	return implementation->GetChannelSlot(hChannel) != NULL;
+}
+
+int AudioEngine::GetActiveChannelCount() const
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+	return (int)implementation->mActiveChannels.size();
+}
+
+
+//////// FMOD Parameters ////////
+
+// Copies a parameter name into a command, returns false if it is too long to queue
+static bool CopyCommandName(AudioCommand& command, const std::string& strName)
+{
+	if (strName.length() >= AudioCommand::MAX_NAME_LENGTH)
+	{
+		std::cout << "Audio Engine: parameter name \"" << strName << "\" is too long to queue" << std::endl;
+		return false;
+	}
+
+	strName.copy(command.strName, strName.length());
+	command.strName[strName.length()] = '\0';
+	return true;
+}
+
+ParameterHandle AudioEngine::GetParameterHandle(EventHandle hEvent, const std::string& strParameterName)
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+
+	Implementation::EventSlot* pSlot = implementation->GetEventSlot(hEvent);
+	if (!pSlot)
+		return INVALID_PARAMETER_HANDLE;
+
+	return implementation->ResolveParameter(pSlot->nPool, strParameterName);
+}
+
+ParameterHandle AudioEngine::GetGlobalParameterHandle(const std::string& strParameterName)
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+	return implementation->ResolveGlobalParameter(strParameterName);
+}
+
+void AudioEngine::SetEventParameter(EventHandle hEvent, ParameterHandle hParameter, float fValue)
+{
+	if (implementation->ShouldQueue())
+	{
+		AudioCommand command = { AudioCommand::Type::SetEventParameterByHandle, hEvent };
+		command.fValue = fValue;
+		command.hParameter = hParameter;
+		implementation->Enqueue(command);
+		return;
+	}
+
+	implementation->StageParameter(hEvent, hParameter, fValue);
+}
+
+void AudioEngine::SetGlobalParameter(ParameterHandle hParameter, float fValue)
+{
+	if (implementation->ShouldQueue())
+	{
+		AudioCommand command = { AudioCommand::Type::SetGlobalParameterByHandle };
+		command.fValue = fValue;
+		command.hParameter = hParameter;
+		implementation->Enqueue(command);
+		return;
+	}
+
+	implementation->StageGlobalParameter(hParameter, fValue);
+}
+
+void AudioEngine::GetEventParameter(EventHandle hEvent, const std::string& strParameterName, float* parameter)
+{
+	// The slots and the backend belong to the audio thread while it's running, so answer from its last snapshot.
+	// Values set since then aren't seen until its next tick, and parameters that were never set are left alone
+	if (implementation->ShouldQueue())
+	{
+		const Implementation::Snapshot& snapshot = implementation->mSnapshot.GetFront();
+		const Implementation::VoiceSnapshot* pVoice = snapshot.Find(hEvent);
+		if (!pVoice || pVoice->nPool >= snapshot.Pools.size())
+			return;
+
+		const std::map<std::string, uint16_t>& names = snapshot.Pools[pVoice->nPool].ParameterNames;
+		auto tFoundIt = names.find(strParameterName);
+		if (tFoundIt != names.end() && tFoundIt->second < pVoice->ParameterValues.size() &&
+			!std::isnan(pVoice->ParameterValues[tFoundIt->second]))
+		{
+			*parameter = pVoice->ParameterValues[tFoundIt->second];
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+
+	Implementation::EventSlot* pSlot = implementation->GetEventSlot(hEvent);
+	if (!pSlot)
+		return;
+
+	// A value that hasn't been flushed yet is newer than what FMOD has. This comes before the instance check on
+	// purpose, evicted voices have no instance but keep their staged values until MakeResident sends them
+	const Implementation::EventPool& pool = implementation->mEventPools[pSlot->nPool];
+	auto tFoundIt = pool.ParameterNames.find(strParameterName);
+	if (tFoundIt != pool.ParameterNames.end())
+	{
+		uint16_t nIndex = tFoundIt->second;
+		if (nIndex < pSlot->ParameterDirty.size() && nIndex < pSlot->ParameterValues.size() && pSlot->ParameterDirty[nIndex])
+		{
+			*parameter = pSlot->ParameterValues[nIndex];
+			return;
+		}
+	}
+
+	// Nothing staged, and nothing to ask FMOD either
+	if (!pSlot->pInstance)
+		return;
+
+	AudioEngine::ErrorCheck(implementation->mpBackend->GetParameterByName(pSlot->pInstance, strParameterName.c_str(), parameter));
+}
+
+void AudioEngine::SetEventParameter(EventHandle hEvent, const std::string& strParameterName, float fValue)
+{
+	if (implementation->ShouldQueue())
+	{
+		AudioCommand command = { AudioCommand::Type::SetEventParameter, hEvent };
+		command.fValue = fValue;
+		if (CopyCommandName(command, strParameterName))
+			implementation->Enqueue(command);
+		return;
+	}
+
+	Implementation::EventSlot* pSlot = implementation->GetEventSlot(hEvent);
+	if (!pSlot)
+		return;
+
+	implementation->StageParameter(hEvent, implementation->ResolveParameter(pSlot->nPool, strParameterName), fValue);
+}
+
+void AudioEngine::GetEventParameter(const std::string& strEventName, const std::string& strParameterName, float* parameter)
+{
+	GetEventParameter(GetEventHandle(strEventName), strParameterName, parameter);
+}
+
+void AudioEngine::SetEventParameter(const std::string& strEventName, const std::string& strParameterName, float fValue)
+{
+	SetEventParameter(GetEventHandle(strEventName), strParameterName, fValue);
+}
+
+void AudioEngine::SetGlobalParameter(const std::string& strParameterName, float fValue)
+{
+	if (implementation->ShouldQueue())
+	{
+		AudioCommand command = { AudioCommand::Type::SetGlobalParameter };
+		command.fValue = fValue;
+		if (CopyCommandName(command, strParameterName))
+			implementation->Enqueue(command);
+		return;
+	}
+
+	implementation->StageGlobalParameter(implementation->ResolveGlobalParameter(strParameterName), fValue);
+}
+
+
+//////// Staged Parameters ////////
+
+ParameterHandle Implementation::ResolveParameter(uint16_t nPool, const std::string& strName)
+{
+	EventPool& pool = mEventPools[nPool];
+	auto tFoundIt = pool.ParameterNames.find(strName);
+	if (tFoundIt != pool.ParameterNames.end())
+		return ((ParameterHandle)nPool << 16) | (ParameterHandle)(tFoundIt->second + 1);
+
+	if (!pool.pDescription || pool.ParameterIDs.size() >= 0xFFFF)
+		return INVALID_PARAMETER_HANDLE;
+
+	// Only ask FMOD the first time this name is used on this event
+	FMOD_STUDIO_PARAMETER_DESCRIPTION parameter;
+	if (AudioEngine::ErrorCheck(mpBackend->GetParameterDescriptionByName(pool.pDescription, strName.c_str(), &parameter)))
+		return INVALID_PARAMETER_HANDLE;
+
+	uint16_t nIndex = (uint16_t)pool.ParameterIDs.size();
+	pool.ParameterIDs.push_back(parameter.id);
+	pool.ParameterNames[strName] = nIndex;
+	pool.nParameterNamesVersion = ++mnParameterNamesVersion;
+	return ((ParameterHandle)nPool << 16) | (ParameterHandle)(nIndex + 1);
+}
+
+ParameterHandle Implementation::ResolveGlobalParameter(const std::string& strName)
+{
+	auto tFoundIt = mGlobalParameterNames.find(strName);
+	if (tFoundIt != mGlobalParameterNames.end())
+		return (ParameterHandle)tFoundIt->second + 1;
+
+	if (mGlobalParameterIDs.size() >= 0xFFFF)
+		return INVALID_PARAMETER_HANDLE;
+
+	FMOD_STUDIO_PARAMETER_DESCRIPTION parameter;
+	if (AudioEngine::ErrorCheck(mpBackend->GetParameterDescriptionByName(strName.c_str(), &parameter)))
+		return INVALID_PARAMETER_HANDLE;
+
+	uint16_t nIndex = (uint16_t)mGlobalParameterIDs.size();
+	mGlobalParameterIDs.push_back(parameter.id);
+	mGlobalParameterNames[strName] = nIndex;
+	mGlobalParameterValues.push_back(parameter.defaultvalue);
+	mGlobalParameterDirty.push_back(0);
+	return (ParameterHandle)nIndex + 1;
+}
+
+void Implementation::StageParameter(EventHandle hVoice, ParameterHandle hParameter, float fValue)
+{
+	EventSlot* pSlot = GetEventSlot(hVoice);
+	if (!pSlot || hParameter == INVALID_PARAMETER_HANDLE)
+		return;
+
+	// Handles from another event are ignored
+	const EventPool& pool = mEventPools[pSlot->nPool];
+	uint32_t nIndex = (hParameter & 0xFFFF) - 1;
+	if ((hParameter >> 16) != pSlot->nPool || nIndex >= pool.ParameterIDs.size())
+		return;
+
+	// Only grows when the event has a parameter this voice hasn't seen yet
+	if (nIndex >= pSlot->ParameterValues.size())
+	{
+		pSlot->ParameterValues.resize(pool.ParameterIDs.size(), NAN);
+		pSlot->ParameterDirty.resize(pool.ParameterIDs.size(), 0);
+	}
+
+	pSlot->ParameterValues[nIndex] = fValue;
+	if (pSlot->ParameterDirty[nIndex])
+		return;
+
+	pSlot->ParameterDirty[nIndex] = 1;
+	if (pSlot->DirtyParameters.empty())
+		mParameterVoices.push_back(hVoice);
+	pSlot->DirtyParameters.push_back((uint16_t)nIndex);
+}
+
+void Implementation::StageGlobalParameter(ParameterHandle hParameter, float fValue)
+{
+	uint32_t nIndex = hParameter - 1;
+	if (hParameter == INVALID_PARAMETER_HANDLE || nIndex >= mGlobalParameterIDs.size())
+		return;
+
+	mGlobalParameterValues[nIndex] = fValue;
+	if (!mGlobalParameterDirty[nIndex])
+	{
+		mGlobalParameterDirty[nIndex] = 1;
+		mDirtyGlobalParameters.push_back((uint16_t)nIndex);
+	}
+}
+
+void Implementation::FlushParameters()
+{
+	// One setParametersByIDs per voice, no matter how many of its parameters changed
+	for (EventHandle hVoice : mParameterVoices)
+	{
+		// Evicted voices keep their staged values, MakeResident queues them again
+		EventSlot* pSlot = GetEventSlot(hVoice);
+		if (!pSlot || !pSlot->pInstance || pSlot->DirtyParameters.empty())
+			continue;
+
+		const EventPool& pool = mEventPools[pSlot->nPool];
+		mParameterIDs.clear();
+		mParameterValues.clear();
+		for (uint16_t nIndex : pSlot->DirtyParameters)
+		{
+			mParameterIDs.push_back(pool.ParameterIDs[nIndex]);
+			mParameterValues.push_back(pSlot->ParameterValues[nIndex]);
+			pSlot->ParameterDirty[nIndex] = 0;
+		}
+		pSlot->DirtyParameters.clear();
+
+		AudioEngine::ErrorCheck(mpBackend->SetParametersByIDs(pSlot->pInstance, mParameterIDs.data(), mParameterValues.data(), (int)mParameterIDs.size()));
+	}
+	mParameterVoices.clear();
+
+	if (!mDirtyGlobalParameters.empty())
+	{
+		mParameterIDs.clear();
+		mParameterValues.clear();
+		for (uint16_t nIndex : mDirtyGlobalParameters)
+		{
+			mParameterIDs.push_back(mGlobalParameterIDs[nIndex]);
+			mParameterValues.push_back(mGlobalParameterValues[nIndex]);
+			mGlobalParameterDirty[nIndex] = 0;
+		}
+		mDirtyGlobalParameters.clear();
+
+		AudioEngine::ErrorCheck(mpBackend->SetParametersByIDs(mParameterIDs.data(), mParameterValues.data(), (int)mParameterIDs.size()));
+	}
+}
+
+
+//////// Occlusion ////////
+
+void Implementation::UpdateOcclusion(float fDeltaTime)
+{
+	mnOcclusionRays = 0;
+	if (mActiveVoices.empty())
+		return;
+
+	// Trace the next few voices from the listener FMOD will hear them through, the rest keep their last result
+	if (!mOcclusion.IsEmpty())
+	{
+		size_t nCount = mActiveVoices.size();
+		if (mnOcclusionCursor >= nCount)
+			mnOcclusionCursor = 0;
+
+		for (size_t n = 0; n < nCount && mnOcclusionRays < mnOcclusionRaysPerUpdate; n++)
+		{
+			EventHandle hVoice = mActiveVoices[mnOcclusionCursor];
+			mnOcclusionCursor = (mnOcclusionCursor + 1) % nCount;
+
+			EventSlot* pSlot = GetEventSlot(hVoice);
+			if (!pSlot || pSlot->bVirtual || !mEventPools[pSlot->nPool].b3D)
+				continue;
+
+			const glm::vec3& vPosition = pSlot->attributes.vPosition;
+			int nNearest = 0;
+			float fNearest = glm::length(vPosition - mListeners[0].vPosition);
+			for (int i = 1; i < mnListeners; i++)
+			{
+				float fDistance = glm::length(vPosition - mListeners[i].vPosition);
+				if (fDistance < fNearest)
+				{
+					fNearest = fDistance;
+					nNearest = i;
+				}
+			}
+
+			pSlot->fOcclusionTarget = mOcclusion.Trace(mListeners[nNearest].vPosition, vPosition);
+			mnOcclusionRays++;
+		}
+	}
+
+	// Only voices whose value actually moved stage a parameter
+	float fStep = mfOcclusionRampTime > 0.0f ? fDeltaTime / mfOcclusionRampTime : 1.0f;
+	for (EventHandle hVoice : mActiveVoices)
+	{
+		EventSlot* pSlot = GetEventSlot(hVoice);
+		if (!pSlot)
+			continue;
+
+		float fTarget = mOcclusion.IsEmpty() ? 0.0f : pSlot->fOcclusionTarget;
+		if (pSlot->fOcclusion == fTarget)
+			continue;
+
+		if (fTarget > pSlot->fOcclusion)
+			pSlot->fOcclusion = std::min(pSlot->fOcclusion + fStep, fTarget);
+		else
+			pSlot->fOcclusion = std::max(pSlot->fOcclusion - fStep, fTarget);
+
+		// Look for the parameter without ErrorCheck, plenty of events won't have one
+		EventPool& pool = mEventPools[pSlot->nPool];
+		if (!pool.bOcclusionResolved)
+		{
+			pool.bOcclusionResolved = true;
+			pool.hOcclusionParameter = INVALID_PARAMETER_HANDLE;
+			FMOD_STUDIO_PARAMETER_DESCRIPTION parameter;
+			if (pool.pDescription && mpBackend->GetParameterDescriptionByName(pool.pDescription, mstrOcclusionParameter.c_str(), &parameter) == FMOD_OK)
+				pool.hOcclusionParameter = ResolveParameter(pSlot->nPool, mstrOcclusionParameter);
+		}
+		StageParameter(hVoice, pool.hOcclusionParameter, pSlot->fOcclusion);
+	}
+}
+
+void AudioEngine::SetOcclusionGeometry(const OccluderBox* pBoxes, int nCount)
+{
+	// Build outside the lock, so the audio thread only waits for the swap
+	OcclusionBVH occlusion;
+	occlusion.Build(pBoxes, nCount);
+
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+	std::swap(implementation->mOcclusion, occlusion);
+}
+
+void AudioEngine::SetOcclusionSettings(int nRaysPerUpdate, float fRampTime, const std::string& strParameterName)
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+	implementation->mnOcclusionRaysPerUpdate = std::max(nRaysPerUpdate, 0);
+	implementation->mfOcclusionRampTime = std::max(fRampTime, 0.0f);
+	if (implementation->mstrOcclusionParameter != strParameterName)
+	{
+		implementation->mstrOcclusionParameter = strParameterName;
+		for (Implementation::EventPool& pool : implementation->mEventPools)
+		{
+			pool.bOcclusionResolved = false;
+		}
+	}
+}
+
+float AudioEngine::GetOcclusion(EventHandle hEvent) const
+{
+	const Implementation::PlaybackCacheEntry* pEntry = implementation->FindPlaybackState(hEvent);
+	return pEntry ? pEntry->fOcclusion : 0.0f;
+}
+
+
+//////// Virtual Voices ////////
+
+void AudioEngine::SetVirtualVoiceSettings(float fThresholdDb, int nMaxRealVoices)
+{
+	std::lock_guard<std::mutex> lock(implementation->mStructureMutex);
+	implementation->mfVirtualThreshold = dbToVolume(fThresholdDb);
+	implementation->mnMaxRealVoices = nMaxRealVoices;
+}
+
+VoiceStats AudioEngine::GetVoiceStats() const
+{
+	if (implementation->ShouldQueue())
+		return implementation->mSnapshot.GetFront().voiceStats;
+
+	return implementation->mVoiceStats;
+}
+
+
+//////// Profiling ////////
+
+void AudioProfile::Add(const AudioFrameStats& stats)
+{
+	Frames[nNext] = stats;
+	nNext = (nNext + 1) % MAX_FRAMES;
+	if (nCount < MAX_FRAMES)
+		nCount++;
+}
+
+void AudioProfile::Clear()
+{
+	nCount = 0;
+	nNext = 0;
+}
+
+const AudioFrameStats& AudioProfile::Get(int nIndex) const
+{
+	int nOldest = (nCount < MAX_FRAMES) ? 0 : nNext;
+	return Frames[(nOldest + nIndex) % MAX_FRAMES];
+}
+
+const AudioFrameStats& AudioProfile::Latest() const
+{
+	return Frames[(nNext + MAX_FRAMES - 1) % MAX_FRAMES];
+}
+
+bool AudioProfile::WriteCSV(const std::string& strFileName) const
+{
+	std::ofstream file(strFileName);
+	if (!file)
+		return false;
+
+	file << "frame,update_us,backend_calls,loaded_voices,real_voices,virtual_voices,channels,"
+		"cpu_dsp,cpu_stream,cpu_geometry,cpu_update,cpu_studio,memory_current,memory_max,resident_sample_bytes,occlusion_rays\n";
+	for (int i = 0; i < nCount; i++)
+	{
+		const AudioFrameStats& stats = Get(i);
+		file << stats.nFrame << ',' << stats.fUpdateTime << ',' << stats.nBackendCalls << ','
+			<< stats.nLoadedVoices << ',' << stats.nRealVoices << ',' << stats.nVirtualVoices << ',' << stats.nActiveChannels << ','
+			<< stats.cpuUsage.dspusage << ',' << stats.cpuUsage.streamusage << ',' << stats.cpuUsage.geometryusage << ','
+			<< stats.cpuUsage.updateusage << ',' << stats.cpuUsage.studiousage << ','
+			<< stats.nMemoryCurrent << ',' << stats.nMemoryMax << ',' << stats.nResidentSampleBytes << ',' << stats.nOcclusionRays << '\n';
+	}
+
+	return (bool)file;
+}
+
+void Implementation::RecordFrameStats(float fUpdateTime)
+{
+	AudioFrameStats stats;
+	stats.nFrame = mnFrame;
+	stats.fUpdateTime = fUpdateTime;
+	stats.nBackendCalls = (int)(mpBackend->GetCallCount() - mnLastCallCount);
+	stats.nLoadedVoices = (int)(mEventSlots.size() - mFreeEventSlots.size());
+	stats.nRealVoices = mVoiceStats.nReal;
+	stats.nVirtualVoices = mVoiceStats.nVirtual;
+	stats.nActiveChannels = (int)mActiveChannels.size();
+	stats.nResidentSampleBytes = mnResidentSampleBytes;
+	stats.nOcclusionRays = mnOcclusionRays;
+	AudioEngine::ErrorCheck(mpBackend->GetCPUUsage(&stats.cpuUsage));
+	AudioEngine::ErrorCheck(mpBackend->GetMemoryUsage(&stats.nMemoryCurrent, &stats.nMemoryMax));
+
+	std::lock_guard<std::mutex> lock(mProfileMutex);
+	mProfile.Add(stats);
+}
+
+void AudioEngine::SetProfilingEnabled(bool bEnabled)
+{
+	implementation->mbProfiling = bEnabled;
+}
+
+bool AudioEngine::IsProfilingEnabled() const
+{
+	return implementation->mbProfiling;
+}
+
+void AudioEngine::GetProfile(AudioProfile& profile) const
+{
+	std::lock_guard<std::mutex> lock(implementation->mProfileMutex);
+	profile = implementation->mProfile;
+}
+
+void AudioEngine::ClearProfile()
+{
+	std::lock_guard<std::mutex> lock(implementation->mProfileMutex);
+	implementation->mProfile.Clear();
+}
+
+bool AudioEngine::ExportProfileCSV(const std::string& strFileName) const
+{
+	std::lock_guard<std::mutex> lock(implementation->mProfileMutex);
+	if (!implementation->mProfile.WriteCSV(strFileName))
+	{
+		std::cout << "Audio Engine: couldn't write the profile to " << strFileName << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+
+//////// Listeners ////////
+
+float Implementation::GetNearestListenerDistance(const glm::vec3& vPosition) const
+{
+	float fNearest = glm::length(vPosition - mListeners[0].vPosition);
+	for (int i = 1; i < mnListeners; i++)
+	{
+		fNearest = std::min(fNearest, glm::length(vPosition - mListeners[i].vPosition));
+	}
+
+	return fNearest;
+}
+
+void AudioEngine::SetNumListeners(int nListeners)
+{
+	nListeners = glm::clamp(nListeners, 1, FMOD_MAX_LISTENERS);
+
+	if (implementation->ShouldQueue())
+	{
+		AudioCommand command = { AudioCommand::Type::SetNumListeners };
+		command.nIndex = nListeners;
+		implementation->Enqueue(command);
+		return;
+	}
+
+	if (nListeners == implementation->mnListeners)
+		return;
+
+	// Listeners that come back start over, rather than working out a velocity from where they were
+	for (int i = implementation->mnListeners; i < nListeners; i++)
+	{
+		implementation->mListeners[i].Reset();
+		implementation->mListeners[i].bDirty = true;
+	}
+	implementation->mnListeners = nListeners;
+	implementation->mbListenerCountDirty = true;
+}
+
+int AudioEngine::GetNumListeners() const
+{
+	if (implementation->ShouldQueue())
+		return implementation->mSnapshot.GetFront().nListeners;
+
+	return implementation->mnListeners;
+}
+
+void AudioEngine::SetListenerPosition(const glm::vec3& vPosition, int nListener)
+{
+	if (nListener < 0 || nListener >= FMOD_MAX_LISTENERS)
+		return;
+
+	if (implementation->ShouldQueue())
+	{
+		AudioCommand command = { AudioCommand::Type::SetListenerPosition };
+		command.nIndex = nListener;
+		command.vA = vPosition;
+		implementation->Enqueue(command);
+		return;
+	}
+
+	implementation->mListeners[nListener].vPosition = vPosition;
+	implementation->mListeners[nListener].bDirty = true;
+}
+
+void AudioEngine::SetListenerOrientation(const glm::vec3& vUp, const glm::vec3& vForward, int nListener)
+{
+	if (nListener < 0 || nListener >= FMOD_MAX_LISTENERS)
+		return;
+
+	if (implementation->ShouldQueue())
+	{
+		AudioCommand command = { AudioCommand::Type::SetListenerOrientation };
+		command.nIndex = nListener;
+		command.vA = vUp;
+		command.vB = vForward;
+		implementation->Enqueue(command);
+		return;
+	}
+
+	implementation->mListeners[nListener].vForward = vForward;
+	implementation->mListeners[nListener].vUp = vUp;
+	implementation->mListeners[nListener].bDirty = true;
+}
+
+void AudioEngine::SetListeners(const ListenerAttributes* pListeners, int nCount)
+{
+	if (nCount <= 0)
+		return;
+
+	nCount = std::min(nCount, FMOD_MAX_LISTENERS);
+	SetNumListeners(nCount);
+	for (int i = 0; i < nCount; i++)
+	{
+		SetListenerPosition(pListeners[i].vPosition, i);
+		SetListenerOrientation(pListeners[i].vUp, pListeners[i].vForward, i);
+	}
 }
 
 
@@ -4,6 +4,7 @@
 #include "fmod_studio.hpp"
 #include "fmod.hpp"
 #include "fmod_errors.h"
+#include "AudioBackend.h"
 
 // Standard Library
 #include <string>
@@ -12,49 +13,482 @@
 #include <math.h>
 #include <iostream>
 #include <fstream>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <memory>
 
 #include <glm/glm.hpp>
 
+#include "AudioThread.h"
+#include "AudioOcclusion.h"
+#include "GUIDTable.h"
+
+/*
+ * A compact reference to a loaded event instance. The low 16 bits index into the engine's event slot
+ * array, and the high 16 bits hold the generation of that slot when the handle was given out, so a
+ * handle to an event that has since been unloaded is rejected instead of touching the wrong instance.
+ */
+typedef uint32_t EventHandle;
+const EventHandle INVALID_EVENT_HANDLE = 0;
+
+/*
+ * A parameter resolved to its FMOD_STUDIO_PARAMETER_ID by GetParameterHandle or GetGlobalParameterHandle.
+ * Event parameter handles work on every voice of the event they were resolved for, and no other event.
+ */
+typedef uint32_t ParameterHandle;
+const ParameterHandle INVALID_PARAMETER_HANDLE = 0;
+
+/*
+ * A sound playing on its own channel, returned by PlaySound. Packed the same way as EventHandle, and it
+ * stops being valid as soon as the channel has finished playing.
+ */
+typedef uint32_t ChannelHandle;
+const ChannelHandle INVALID_CHANNEL_HANDLE = 0;
+
+/*
+ * Returned by LoadBankAsync, use it to poll how far along the load is. 0 is never a valid ticket.
+ */
+typedef uint32_t AudioLoadTicket;
+const AudioLoadTicket INVALID_LOAD_TICKET = 0;
+
+/*
+ * Decides which voice of an event is restarted when the event is played while all of its voices are busy
+ */
+enum class VoiceStealMode
+{
+	Oldest,   // The voice that was started first
+	Quietest, // The voice with the lowest audibility
+	Farthest  // The voice furthest away from the listener
+};
+
+/*
+ * Where one listener is and which way it faces, for AudioEngine::SetListeners
+ */
+struct ListenerAttributes
+{
+	glm::vec3 vPosition = glm::vec3(0.0f);
+	glm::vec3 vForward = glm::vec3(0.0f, 0.0f, -1.0f);
+	glm::vec3 vUp = glm::vec3(0.0f, 1.0f, 0.0f);
+};
+
+/*
+ * How long an event's sample data is kept in memory. Whether an asset streams from disk is decided when the bank
+ * is built in FMOD Studio; FMOD keeps an event's sample data loaded for as long as any instance of it exists, so
+ * this decides when the engine creates and releases the event's instances.
+ */
+enum class SamplePolicy
+{
+	Auto,    // Short events are loaded by LoadEvent, long or streamed ones when first played. Evicted over budget
+	Preload, // Loaded by LoadEvent and kept until the event is unloaded, never evicted
+	Stream   // Loaded when played and let go as soon as none of its voices are playing
+};
+
+/*
+ * The sample data one loaded event is holding on to, from GetSampleMemory
+ */
+struct EventSampleMemory
+{
+	std::string strEvent;
+	std::string strBank;  // empty if the event wasn't listed by any loaded bank
+	SamplePolicy ePolicy; // Auto events that stream report Stream
+	bool bResident;
+	size_t nBytes;        // what it takes up while resident
+	bool bEstimated;      // worked out from the event's length, FMOD only measures memory in its logging builds
+	uint32_t nLastPlayed; // the Update it was last played in
+};
+
+/*
+ * The number of playing voices that are actually reaching FMOD (real) and the number that have been
+ * paused by the engine because they are out of range or too quiet to hear (virtual)
+ */
+struct VoiceStats
+{
+	int nReal = 0;
+	int nVirtual = 0;
+};
+
+/*
+ * What a single Update cost and what was loaded and playing at the end of it, recorded while profiling is on
+ */
+struct AudioFrameStats
+{
+	uint32_t nFrame = 0;      // Updates since Init
+	float fUpdateTime = 0.0f; // microseconds spent in Update, including the backend's own update
+	int nBackendCalls = 0;    // calls made to the backend since the previous Update, by the game and the engine
+	int nLoadedVoices = 0;    // event slots in use, across every loaded event
+	int nRealVoices = 0;
+	int nVirtualVoices = 0;
+	int nActiveChannels = 0;
+	FMOD_STUDIO_CPU_USAGE cpuUsage = {}; // FMOD's own usage in percent
+	int nMemoryCurrent = 0;   // bytes allocated by FMOD
+	int nMemoryMax = 0;
+	size_t nResidentSampleBytes = 0; // sample data held by loaded events, see SetSampleResidencySettings
+	int nOcclusionRays = 0;   // voices traced against the occlusion geometry, see SetOcclusionSettings
+};
+
+/*
+ * The stats of the last MAX_FRAMES updates in a ring. It is a fixed size, so copying it out every frame
+ * for a graph doesn't allocate.
+ */
+struct AudioProfile
+{
+	static const int MAX_FRAMES = 300;
+
+	AudioFrameStats Frames[MAX_FRAMES];
+	int nCount = 0; // frames recorded, up to MAX_FRAMES
+	int nNext = 0;  // where the next frame goes, which is also the oldest frame once the ring is full
+
+	void Add(const AudioFrameStats& stats);
+	void Clear();
+	const AudioFrameStats& Get(int nIndex) const; // 0 is the oldest frame
+	const AudioFrameStats& Latest() const;
+	// One row per frame, oldest first, with a header row
+	bool WriteCSV(const std::string& strFileName) const;
+};
+
 struct Implementation
 {
 	/* 
-	- Initializes and shuts down FMOD 
-	- Holds instances of of both the Studio and core system objects
-	- Also holds a map of all the sounds and events we've played
+	- Creates and shuts down the backend (FMOD, or the headless stand in)
+	- Also holds a map of all the events we've played
 	*/
 
-	Implementation();
+	Implementation(std::unique_ptr<AudioBackend> pBackend);
 	~Implementation();
 
 	void Update();
 
 	// System
-	FMOD::Studio::System* mpStudioSystem;
-	FMOD::System* mpSystem;
+	std::unique_ptr<AudioBackend> mpBackend;
 
-	// GUIDs
-	typedef std::map<std::string, std::string> GUIDMap;
+	// GUIDs (see GUIDTable)
 
 	// Banks
-	typedef std::map<std::string, FMOD::Studio::Bank*> BankMap;
+	typedef std::map<std::string, BackendBank*> BankMap;
+
+	// A bank being loaded in the background, optionally followed by the sample data of some of its events
+	struct LoadRequest
+	{
+		BackendBank* pBank;
+		std::vector<std::string> PreloadEvents;
+		std::vector<BackendEventDescription*> PreloadDescriptions; // filled in once the bank has loaded
+		bool bMetadataLoaded;
+
+		// Written by whichever thread runs Update, read by anyone
+		std::atomic<float> fProgress;
+		std::atomic<bool> bDone;
+		std::atomic<bool> bFailed;
+	};
+
+	void UpdateLoadRequests();
+
+	// 3D attributes are staged here and sent to FMOD once per update
+	struct StagedAttributes
+	{
+		glm::vec3 vPosition;
+		glm::vec3 vLastPosition; // position sent on the last flush, velocity is worked out from this
+		glm::vec3 vForward;
+		glm::vec3 vUp;
+		glm::vec3 vVelocity;     // only used when bAutoVelocity is false
+		bool bDirty;
+		bool bHasLastPosition;
+		bool bAutoVelocity;      // work the velocity out from how far we moved since the last flush
+
+		void Reset();
+		// Fills out the FMOD attributes and returns true if the worked out velocity is not zero
+		bool Resolve(float fDeltaTime, FMOD_3D_ATTRIBUTES& attributes);
+	};
 
 	// Events
-	typedef std::map<std::string, FMOD::Studio::EventInstance*> EventMap;
-	
-	
+	struct EventSlot
+	{
+		BackendEventInstance* pInstance; // NULL while the event's sample data isn't resident
+		uint16_t nGeneration; // bumped every time the slot is released, starts at 1
+		bool bInUse;          // false while the slot is on the free list
+		uint16_t nPool;       // index of the pool this voice belongs to
+		bool bActive;         // true from PlayEvent until the instance reaches STOPPED
+		uint32_t nStartOrder; // used to find the oldest voice when stealing
+		StagedAttributes attributes;
+		bool bVirtual;        // paused by the engine because it can't be heard, attributes aren't sent to FMOD
+		float fCullDistance;  // goes virtual beyond this distance if it is closer than the event's max distance, 0 for none
+		FMOD_STUDIO_PLAYBACK_STATE eState; // as of the last update
+		uint32_t nStartCount; // bumped by PlayEvent, and when the voice stops (including being stolen),
+		uint32_t nStopCount;  // so the game thread can tell what happened since it last looked
+		bool bTrackTimeline;  // read the timeline position along with the playback state
+		int nTimelinePosition; // milliseconds, as of the last update
+		float fOcclusion;     // what was last sent to the event's occlusion parameter, eases towards fOcclusionTarget
+		float fOcclusionTarget; // from the voice's last trace
+
+		// Parameter values waiting for the next flush, indexed the same as the pool's ParameterIDs. Values that
+		// have never been set are NAN, the rest are sent again if the voice's instance is recreated.
+		std::vector<float> ParameterValues;
+		std::vector<uint8_t> ParameterDirty;
+		std::vector<uint16_t> DirtyParameters;
+	};
+	typedef std::map<std::string, EventHandle> EventMap; // only used to resolve names to handles
+
+	// Every instance of an event is created together, when it becomes resident, so playing a resident event
+	// never calls createInstance
+	struct EventPool
+	{
+		BackendEventDescription* pDescription;
+		std::string strName;
+		std::vector<EventHandle> Voices; // the first voice is the handle returned by LoadEvent
+		VoiceStealMode eStealMode;
+		bool b3D;
+		float fMinDistance;
+		float fMaxDistance;
+
+		// Parameters are resolved once for the whole event, a handle is (pool << 16) | (index + 1)
+		std::vector<FMOD_STUDIO_PARAMETER_ID> ParameterIDs;
+		std::map<std::string, uint16_t> ParameterNames;
+		uint32_t nParameterNamesVersion; // changes whenever ParameterNames does, so the snapshot only copies it then
+
+		// Sample residency
+		SamplePolicy ePolicy; // Auto only if it can be evicted, events that stream are Stream
+		std::string strBank;
+		bool bResident;       // the voices have instances, so FMOD has the sample data loaded
+		size_t nSampleBytes;
+		bool bSampleBytesMeasured; // asked the backend once the samples loaded, otherwise it is an estimate
+		uint32_t nLastPlayed; // the Update it was last played in, for evicting the least recently used
+
+		// Occlusion
+		ParameterHandle hOcclusionParameter; // INVALID if the event doesn't have one
+		bool bOcclusionResolved; // looked for the parameter since the event was loaded or the name last changed
+	};
+
+	// Used when sorting voices by how loud we expect them to be
+	struct VoiceAudibility
+	{
+		EventHandle hVoice;
+		float fGain;
+	};
+
+	EventHandle CreateEventSlot(BackendEventInstance* pInstance, uint16_t nPool);
+	void ReleaseEventSlot(EventHandle hEvent);
+	EventSlot* GetEventSlot(EventHandle hEvent);
+	float GetStealScore(const EventPool& pool, const EventSlot& slot); // higher is a better voice to steal
+	EventHandle AcquireVoice(EventPool& pool);
+	EventHandle SelectVoice(EventHandle hEvent);
+	EventHandle SelectQueuedVoice(EventHandle hEvent); // game thread, picks from the snapshot without the lock
+	EventHandle StartVoice(EventHandle hEvent, EventHandle hVoice);
+	void RecycleStoppedVoices();
+	void CullVirtualVoices();
+	void SetVoiceVirtual(EventHandle hVoice, bool bVirtual);
+	void MarkAttributesDirty(EventHandle hVoice, EventSlot& slot);
+	void FlushAttributes(float fDeltaTime);
+
+	// Emitters
+	// A batch of positions from SetEventPositions. In threaded mode the game thread fills in the back batch, and
+	// AudioEngine::Update publishes it to the audio thread, which applies the newest one on its next tick.
+	struct PositionBatch
+	{
+		uint32_t nSequence; // bumped for every published batch, so the audio thread only applies each one once
+		std::vector<EventHandle> Events;
+		std::vector<glm::vec3> Positions;
+		std::vector<glm::vec3> Velocities;
+		std::vector<uint8_t> AutoVelocity;
+		std::vector<float> CullDistances;
+
+		void Clear();
+	};
+
+	void StageEventPositions(const EventHandle* phEvents, const glm::vec3* pPositions, int nCount,
+		const glm::vec3* pVelocities, const float* pCullDistances);
+	void PublishPositionBatch(); // game thread
+	void ApplyPositionBatch();   // audio thread
+
+	// Listeners
+	// FMOD attenuates each event by the listener closest to it, so culling and stealing do the same
+	float GetNearestListenerDistance(const glm::vec3& vPosition) const;
+
+	// Sample residency
+	bool MakeResident(uint16_t nPool);
+	void Evict(uint16_t nPool);
+	bool IsPoolIdle(const EventPool& pool);
+	void MeasureSampleBytes(EventPool& pool);
+	void UpdateResidency();
+	const std::string& FindEventBank(BackendEventDescription* pDescription);
+
+	// Occlusion
+	// Traces a few voices against the geometry each update, round robin, and eases every voice's parameter towards its
+	// last result so voices that were traced on different updates don't jump
+	void UpdateOcclusion(float fDeltaTime);
+
+	// Parameters
+	ParameterHandle ResolveParameter(uint16_t nPool, const std::string& strName);
+	ParameterHandle ResolveGlobalParameter(const std::string& strName);
+	void StageParameter(EventHandle hVoice, ParameterHandle hParameter, float fValue);
+	void StageGlobalParameter(ParameterHandle hParameter, float fValue);
+	void FlushParameters();
+
 	// Channels
-	int mnNextChannelId;
-	typedef std::map<int, FMOD::Channel*> ChannelMap;
+	// Slots are handed out in PlaySound and given back when the backend reports the channel has ended,
+	// so nothing is polled and nothing is allocated by Update
+	struct ChannelSlot
+	{
+		BackendChannel* pChannel; // NULL while the slot is free
+		uint16_t nGeneration;     // bumped every time the slot is released, starts at 1
+		uint16_t nActiveIndex;    // in mActiveChannels
+		bool b3D;
+	};
 
 	// Sounds
-	typedef std::map<std::string, FMOD::Sound*> SoundMap;
+	struct Sound
+	{
+		BackendSound* pSound;
+		bool b3D;
+	};
+	typedef std::map<std::string, Sound> SoundMap;
+
+	ChannelHandle CreateChannelSlot(bool b3D);
+	void ReleaseChannelSlot(ChannelHandle hChannel);
+	ChannelSlot* GetChannelSlot(ChannelHandle hChannel);
+	void ReclaimEndedChannels();
+
+	// Update thread
+	// What the game thread can see of the audio thread's state, published after every tick
+	struct VoiceSnapshot
+	{
+		EventHandle hVoice;
+		bool bActive;
+		FMOD_STUDIO_PLAYBACK_STATE eState;
+		uint32_t nStartCount;
+		uint32_t nStopCount;
+		int nTimelinePosition;
+		float fOcclusion;
+		float fStealScore; // only worked out once every voice of the event is busy, 0 otherwise
+		uint16_t nPool;
+		std::vector<float> ParameterValues; // staged or last sent, NAN if never set
+	};
+	struct PoolSnapshot
+	{
+		uint32_t nParameterNamesVersion;
+		std::map<std::string, uint16_t> ParameterNames;
+	};
+	struct Snapshot
+	{
+		std::vector<VoiceSnapshot> Voices; // indexed the same as mEventSlots
+		std::vector<PoolSnapshot> Pools;   // indexed the same as mEventPools
+		uint32_t nPlaysStarted; // PlayEvent commands run so far, see mQueuedPlays
+		VoiceStats voiceStats;
+		int nListeners;
+
+		const VoiceSnapshot* Find(EventHandle hVoice) const;
+	};
+
+	// True if the call should be queued for the audio thread instead of running now
+	bool ShouldQueue() const;
+	bool Enqueue(const AudioCommand& command);
+	void ExecuteCommand(const AudioCommand& command);
+	void PublishSnapshot();
+	void UpdateThreadMain(int nTickRate);
+
+	// Playback state
+	// What the game thread last saw of each voice, indexed the same as mEventSlots. It is rebuilt once per
+	// AudioEngine::Update from the slots (or the snapshot in threaded mode), so queries never reach the backend.
+	struct PlaybackCacheEntry
+	{
+		EventHandle hVoice;
+		FMOD_STUDIO_PLAYBACK_STATE eState;
+		uint32_t nStartCount;
+		uint32_t nStopCount;
+		int nTimelinePosition;
+		float fOcclusion;
+		bool bJustStarted;
+		bool bJustStopped;
+	};
 
+	void RefreshPlaybackCache();
+	const PlaybackCacheEntry* FindPlaybackState(EventHandle hVoice) const;
 
-	GUIDMap mGUIDs;
+
+	GUIDTable mGUIDs;
 	BankMap mBanks;
+	std::vector<std::unique_ptr<LoadRequest>> mLoadRequests; // a ticket is its index + 1
+	size_t mnFirstPendingLoad; // everything before this has finished
 	EventMap mEvents;
-	ChannelMap mChannels;
+	std::vector<EventSlot> mEventSlots;
+	std::vector<uint16_t> mFreeEventSlots;
+	std::vector<EventPool> mEventPools;
+	std::vector<uint16_t> mFreeEventPools; // left behind by UnloadEvent, LoadEvent takes these first
+	std::vector<EventHandle> mActiveVoices;
+	uint32_t mnNextStartOrder;
+	std::vector<EventHandle> mDirtyVoices;
+	StagedAttributes mListeners[FMOD_MAX_LISTENERS];
+	int mnListeners;
+	bool mbListenerCountDirty;
+	std::vector<EventHandle> mParameterVoices; // voices with staged parameters
+	uint32_t mnParameterNamesVersion; // the last version handed to a pool
+	std::vector<FMOD_STUDIO_PARAMETER_ID> mParameterIDs; // scratch space for a flush
+	std::vector<float> mParameterValues;
+
+	// Global parameters, handles are the index + 1
+	std::vector<FMOD_STUDIO_PARAMETER_ID> mGlobalParameterIDs;
+	std::map<std::string, uint16_t> mGlobalParameterNames;
+	std::vector<float> mGlobalParameterValues;
+	std::vector<uint8_t> mGlobalParameterDirty;
+	std::vector<uint16_t> mDirtyGlobalParameters;
+
+	// Sample residency
+	size_t mnSampleBudget;      // bytes, 0 for no limit
+	float mfShortEventLength;   // seconds, Auto events this long or shorter are preloaded
+	size_t mnResidentSampleBytes;
+	std::vector<uint16_t> mEvictionCandidates;
+	std::map<BackendEventDescription*, std::string> mEventBanks; // filled in from each bank's event list
+	std::vector<BackendBank*> mIndexedBanks;
+	std::chrono::steady_clock::time_point mLastUpdateTime;
 	SoundMap mSounds;
+	std::vector<ChannelSlot> mChannelSlots;
+	std::vector<uint16_t> mFreeChannelSlots;
+	std::vector<ChannelHandle> mActiveChannels;
+
+	// Occlusion
+	OcclusionBVH mOcclusion;
+	int mnOcclusionRaysPerUpdate;
+	float mfOcclusionRampTime;  // seconds to go from unblocked to fully blocked
+	std::string mstrOcclusionParameter;
+	size_t mnOcclusionCursor;   // where in mActiveVoices the next update starts tracing
+	int mnOcclusionRays;        // traced on the last update
+
+	// Virtual voices
+	float mfVirtualThreshold; // linear gain below which a voice goes virtual
+	int mnMaxRealVoices;      // 0 for no limit
+	std::vector<VoiceAudibility> mVoiceAudibility;
+	VoiceStats mVoiceStats;
+
+	// Update thread
+	std::thread mUpdateThread;
+	bool mbThreaded; // only touched by the game thread
+	std::atomic<bool> mbThreadRunning;
+	std::mutex mStructureMutex; // held by the audio thread while it ticks, and by loading on the game thread
+	AudioCommandQueue mCommands;
+	mutable TripleBuffer<Snapshot> mSnapshot;
+	TripleBuffer<PositionBatch> mPositionBatches;
+	uint32_t mnPositionBatchSequence; // the last batch published, only touched by the game thread
+	uint32_t mnAppliedPositionBatch;  // the last batch applied, only touched by the audio thread
+	int mnDroppedCommands;
+
+	// Queued plays. The game thread picks the voice itself so PlayEvent can return it, and numbers each play it
+	// queues. A voice whose last play is numbered above the snapshot's nPlaysStarted hasn't started yet, so it isn't
+	// picked again. The numbers are compared by their difference, so they can wrap.
+	uint32_t mnPlaysQueued;  // only touched by the game thread
+	uint32_t mnPlaysStarted; // only touched by whichever thread runs the commands
+	std::vector<uint32_t> mQueuedPlays; // the number of each voice's last queued play, indexed the same as mEventSlots
+
+	// Playback state, only touched by the game thread
+	std::vector<PlaybackCacheEntry> mPlaybackCache;
+
+	// Profiling
+	void RecordFrameStats(float fUpdateTime);
+
+	std::atomic<bool> mbProfiling;
+	std::mutex mProfileMutex; // the profile is written by whichever thread runs Update
+	AudioProfile mProfile;
+	uint32_t mnFrame;
+	size_t mnLastCallCount; // backend calls made up to the end of the last Update
 
 };
 
@@ -70,32 +504,162 @@ public:
 	}
 
 	// Logistics
-	void Init();
-	void LoadGUIDs(); // Called by init
+	// The headless backend plays nothing and needs no FMOD libraries, it is for tests and benchmarks.
+	// If FMOD isn't available in this build, Init falls back to it. The offline backend renders into
+	// strOutputFile instead of playing, each Update mixing one block as fast as it is called. Given an
+	// output file, the headless backend renders a stand in mix of test tones there.
+	void Init(AudioBackendType eBackend = AudioBackendType::FMOD, const std::string& strOutputFile = "");
+	void LoadGUIDs(bool bUseCache = true); // Called by init, the cache is rebuilt whenever GUIDs.txt changes
+	void AddGUID(const std::string& strPath, const FMOD_GUID& guid); // for paths that aren't in GUIDs.txt
 	void Update();
 	void Shutdown();
 	static int ErrorCheck(FMOD_RESULT result);
+	AudioBackend* GetBackend() const;
+
+	// Update thread
+	// Moves Update onto a worker thread ticking at nTickRate times a second. Per frame calls then just queue a
+	// command and return, and queries (playback state, GetEventParameter, voice counts) read the snapshot from
+	// the last tick. PlayEvent picks its voice from that snapshot, so it still returns the voice that will play,
+	// which starts on the next tick. None of these wait on the audio thread.
+	// Anything that changes or reads the engine's structure runs on the calling thread and waits for the current
+	// tick to finish: loading and unloading banks, events and sounds, everything to do with channels, resolving
+	// parameter handles, the occlusion, virtual voice and residency settings, and the sample memory queries.
+	void StartUpdateThread(int nTickRate = 60);
+	void StopUpdateThread();
+	bool IsThreaded() const;
 
 	// Banks
 	void LoadBank(const std::string& strBankName);
 	void UnloadAllBanks();
+
+	// Starts loading a bank without blocking, then loads the sample data of each of the preload events so
+	// they can play without a hitch. Events can't be loaded from the bank until IsLoadComplete returns true.
+	AudioLoadTicket LoadBankAsync(const std::string& strBankName, const std::vector<std::string>& preloadEvents = std::vector<std::string>());
+	float GetLoadProgress(AudioLoadTicket ticket) const; // 0 to 1
+	bool IsLoadComplete(AudioLoadTicket ticket) const;
+	bool HasLoadFailed(AudioLoadTicket ticket) const;
 	
 	// Events
-	void LoadEvent(const std::string& strEventName);
-	void PlayEvent(const std::string& strEventName);
-	void StopEvent(const std::string& strEventName, bool bImmediate = false);
+	// The event gets nMaxVoices instances, and eStealMode picks which one restarts once they are all busy. The
+	// instances are created up front or when the event is first played, depending on ePolicy.
+	EventHandle LoadEvent(const std::string& strEventName, int nMaxVoices = 1, VoiceStealMode eStealMode = VoiceStealMode::Oldest,
+		SamplePolicy ePolicy = SamplePolicy::Auto);
+	// Unloading frees the event's pool for the next LoadEvent, so drop any parameter handles resolved for it too
+	void UnloadEvent(EventHandle hEvent);
+	EventHandle GetEventHandle(const std::string& strEventName) const;
+	void StopAllVoices(EventHandle hEvent, bool bFadeOut = false);
+	int GetActiveVoiceCount(EventHandle hEvent) const;
+
+	// Handle versions are O(1) and don't allocate, use these for anything called per frame
+	// PlayEvent starts the given voice if it is idle, otherwise another voice of the same event,
+	// and returns the handle of the voice that was started. With the update thread running the
+	// voice is picked straight away from the last tick's state, without waiting on the audio
+	// thread, and starts on its next tick. Returns INVALID_EVENT_HANDLE if no voice could be picked.
+	EventHandle PlayEvent(EventHandle hEvent);
+	void StopEvent(EventHandle hEvent, bool bFadeOut = false);
+	void SetEventPosition(EventHandle hEvent, const glm::vec3& vPosition);
+	void SetEventOrientation(EventHandle hEvent, const glm::vec3& vUp, const glm::vec3& vForward);
+
+	// Emitters
+	// Stages the positions of many voices in one call, pPositions[i] is where phEvents[i] is. Velocities are worked
+	// out from how far each voice moved unless pVelocities is given. If pCullDistances is given, each voice also goes
+	// virtual once it is further than that from every listener (0 to only use the event's max distance). In threaded
+	// mode the frame's batches reach the audio thread together when Update is called, and only the newest frame is
+	// applied if it falls behind, so submit every emitter every frame.
+	void SetEventPositions(const EventHandle* phEvents, const glm::vec3* pPositions, int nCount,
+		const glm::vec3* pVelocities = NULL, const float* pCullDistances = NULL);
 
+	// Playback state
+	// These read a cache that is refreshed once per Update (from the last tick in threaded mode), so they are free
+	// to call as often as you like. Pass the handle PlayEvent returned, since it may have started another voice.
+	FMOD_STUDIO_PLAYBACK_STATE GetPlaybackState(EventHandle hEvent) const;
+	bool isEventPlaying(EventHandle hEvent) const;   // anything but STOPPED, so this includes fading out
+	bool EventJustStarted(EventHandle hEvent) const; // started between the last two Updates
+	bool EventJustStopped(EventHandle hEvent) const; // stopped, finished or was stolen between the last two Updates
+	// Reading the timeline position costs a backend call per Update, so only voices that ask for it have it tracked.
+	// GetTimelinePosition is in seconds, and 0 for voices that aren't tracked or aren't playing.
+	void TrackTimelinePosition(EventHandle hEvent, bool bTrack = true);
+	float GetTimelinePosition(EventHandle hEvent) const;
+
+	// Name versions look up the handle and forward to the handle versions
+	EventHandle PlayEvent(const std::string& strEventName);
+	void StopEvent(const std::string& strEventName, bool bFadeOut = false);
 	void SetEventPosition(const std::string& strEventName, const glm::vec3 vPosition);
 	bool isEventPlaying(const std::string& strEventName) const;
 
+	// Sounds
+	// Sounds play straight on the core system, for one shots that don't need an FMOD Studio event. These take
+	// the same lock as loading, so in threaded mode they wait for the current tick.
+	void LoadSound(const std::string& strSoundName, bool b3D = true, bool bLooping = false, bool bStream = false);
+	void UnloadSound(const std::string& strSoundName);
+	ChannelHandle PlaySound(const std::string& strSoundName, const glm::vec3& vPosition = glm::vec3(0.0f), float fVolumeDb = 0.0f);
+	void StopChannel(ChannelHandle hChannel);
+	void SetChannelPosition(ChannelHandle hChannel, const glm::vec3& vPosition);
+	void SetChannelVolume(ChannelHandle hChannel, float fVolumeDb);
+	bool IsChannelPlaying(ChannelHandle hChannel) const;
+	int GetActiveChannelCount() const;
+
 	// Parameters
+	// Resolving a name makes FMOD look it up, so do it once up front and keep the handle. Setting a parameter only
+	// stages the value, and every staged parameter of a voice is sent in a single call on the next Update. The name
+	// versions resolve through the same cache, so they are only slower by a map lookup.
+	ParameterHandle GetParameterHandle(EventHandle hEvent, const std::string& strParameterName);
+	ParameterHandle GetGlobalParameterHandle(const std::string& strParameterName);
+	void SetEventParameter(EventHandle hEvent, ParameterHandle hParameter, float fValue);
+	void SetGlobalParameter(ParameterHandle hParameter, float fValue);
+
+	// Reads back the value last set, or FMOD's if there isn't one. In threaded mode it reads the last tick's snapshot
+	// instead, so it never waits on the audio thread, and leaves parameters that were never set alone.
+	void GetEventParameter(EventHandle hEvent, const std::string& strParameterName, float* parameter);
+	void SetEventParameter(EventHandle hEvent, const std::string& strParameterName, float fValue);
 	void GetEventParameter(const std::string& strEventName, const std::string& strEventParameter, float* parameter);
 	void SetEventParameter(const std::string& strEventName, const std::string& strParameterName, float fValue);
 	void SetGlobalParameter(const std::string& strParameterName, float fValue);
 
+	// Occlusion
+	// Each Update traces up to nRaysPerUpdate playing 3D voices against the occlusion geometry, from the listener nearest
+	// to them, and picks up where it left off on the next one. The strengths of the boxes in the way (up to 1) are sent
+	// to the event's strParameterName parameter, ramping there over fRampTime so voices traced a few updates apart still
+	// change smoothly. Events without the parameter are traced but left alone, so give it a low pass in FMOD Studio.
+	void SetOcclusionGeometry(const OccluderBox* pBoxes, int nCount); // rebuilds the tree, so only call it when they change
+	void SetOcclusionSettings(int nRaysPerUpdate, float fRampTime = 0.25f, const std::string& strParameterName = "Occlusion");
+	float GetOcclusion(EventHandle hEvent) const; // 0 for voices that haven't been traced, or aren't playing
+
+	// Virtual voices
+	// Voices quieter than fThresholdDb, or beyond the event's max distance, are paused until they can be heard.
+	// If nMaxRealVoices is above 0, only that many of the loudest voices are left playing
+	void SetVirtualVoiceSettings(float fThresholdDb, int nMaxRealVoices = 0);
+	VoiceStats GetVoiceStats() const;
+
+	// Sample residency
+	// While the sample data of every resident event adds up to more than nBudgetBytes (0 for no limit), the
+	// least recently played Auto events that aren't playing are evicted. Auto events no longer than
+	// fShortEventLength seconds are preloaded by LoadEvent. Evicted events load again when they are played,
+	// which can take a moment for anything that doesn't stream.
+	void SetSampleResidencySettings(size_t nBudgetBytes, float fShortEventLength = 2.0f);
+	size_t GetResidentSampleBytes() const;
+	size_t GetResidentSampleBytes(const std::string& strBankName) const;
+	void GetSampleMemory(std::vector<EventSampleMemory>& events) const; // one entry per loaded event
+	void PrintSampleMemory() const; // per bank and per event, for tuning the budget
+
+	// Profiling
+	// While enabled, every Update records how long it took, the backend calls made since the last one, voice
+	// and channel counts and FMOD's CPU and memory usage into a rolling AudioProfile. Off by default.
+	void SetProfilingEnabled(bool bEnabled);
+	bool IsProfilingEnabled() const;
+	void GetProfile(AudioProfile& profile) const; // copies, so it is safe with the update thread running
+	void ClearProfile();
+	bool ExportProfileCSV(const std::string& strFileName) const;
+
 	// Listeners
-	void SetListenerPosition(const glm::vec3& vPosition);
-	void SetListenerOrientation(const glm::vec3& vUP, const glm::vec3& vForward);
+	// Like event positions, these are staged and sent to FMOD on the next Update, along with a velocity for doppler.
+	// There is one listener until SetNumListeners asks for more (up to FMOD_MAX_LISTENERS), for split screen.
+	void SetNumListeners(int nListeners);
+	int GetNumListeners() const;
+	void SetListenerPosition(const glm::vec3& vPosition, int nListener = 0);
+	void SetListenerOrientation(const glm::vec3& vUP, const glm::vec3& vForward, int nListener = 0);
+	// Sets the number of listeners and all of their attributes at once, listener i is pListeners[i]
+	void SetListeners(const ListenerAttributes* pListeners, int nCount);
 
 	// Helpers
 	float dbToVolume(float db);
@@ -0,0 +1,10 @@
+#pragma once
+
+/*
+ * Marks an entity as a place the audio is heard from. AudioLayer sends the world transform of every
+ * listener to the AudioEngine in one go each frame, so split screen cameras can each have their own.
+ */
+struct AudioListenerComponent {
+	// The FMOD listener this entity drives, from 0 up to FMOD_MAX_LISTENERS - 1
+	int Index = 0;
+};
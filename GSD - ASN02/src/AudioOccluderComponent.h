@@ -0,0 +1,14 @@
+#pragma once
+#include <GLM/glm.hpp>
+
+/*
+ * Lets a renderable block sound. AudioLayer turns the bounds of every occluder's mesh into a world space box each
+ * frame, and only rebuilds the AudioEngine's occlusion geometry when one of them has moved.
+ */
+struct AudioOccluderComponent {
+	// The bounds of the entity's mesh, in its local space
+	glm::vec3 Min = glm::vec3(-0.5f);
+	glm::vec3 Max = glm::vec3(0.5f);
+	// How much of the sound passing through it is blocked, from 0 to 1
+	float     Strength = 1.0f;
+};
@@ -0,0 +1,123 @@
+#include "AudioOcclusion.h"
+#include <algorithm>
+
+// Leaves hold up to this many boxes, splitting any further costs more in node tests than it saves in box tests
+static const uint32_t MAX_LEAF_BOXES = 4;
+// Deep enough for a tree of millions of boxes, since every split halves the boxes
+static const int MAX_TRACE_DEPTH = 64;
+
+void OcclusionBVH::Build(const OccluderBox* pBoxes, int nCount)
+{
+	Clear();
+	if (!pBoxes || nCount <= 0)
+		return;
+
+	mBoxes.assign(pBoxes, pBoxes + nCount);
+	mNodes.reserve(2 * (nCount / MAX_LEAF_BOXES + 1));
+	BuildNode(0, (uint32_t)nCount);
+}
+
+void OcclusionBVH::Clear()
+{
+	mNodes.clear();
+	mBoxes.clear();
+}
+
+uint32_t OcclusionBVH::BuildNode(uint32_t nFirst, uint32_t nCount)
+{
+	uint32_t nNode = (uint32_t)mNodes.size();
+	mNodes.push_back(Node());
+
+	// The node's bounds, and the bounds of the box centres for picking a split
+	glm::vec3 vMin = mBoxes[nFirst].vMin;
+	glm::vec3 vMax = mBoxes[nFirst].vMax;
+	glm::vec3 vCentreMin = (vMin + vMax) * 0.5f;
+	glm::vec3 vCentreMax = vCentreMin;
+	for (uint32_t i = nFirst + 1; i < nFirst + nCount; i++)
+	{
+		const OccluderBox& box = mBoxes[i];
+		vMin = glm::min(vMin, box.vMin);
+		vMax = glm::max(vMax, box.vMax);
+		glm::vec3 vCentre = (box.vMin + box.vMax) * 0.5f;
+		vCentreMin = glm::min(vCentreMin, vCentre);
+		vCentreMax = glm::max(vCentreMax, vCentre);
+	}
+	mNodes[nNode].vMin = vMin;
+	mNodes[nNode].vMax = vMax;
+
+	if (nCount <= MAX_LEAF_BOXES)
+	{
+		mNodes[nNode].nFirst = nFirst;
+		mNodes[nNode].nCount = nCount;
+		return nNode;
+	}
+
+	// Split at the median along the axis the centres are most spread out on, which keeps the tree balanced
+	glm::vec3 vExtent = vCentreMax - vCentreMin;
+	int nAxis = vExtent.x > vExtent.y ? (vExtent.x > vExtent.z ? 0 : 2) : (vExtent.y > vExtent.z ? 1 : 2);
+	uint32_t nHalf = nCount / 2;
+	std::nth_element(mBoxes.begin() + nFirst, mBoxes.begin() + nFirst + nHalf, mBoxes.begin() + nFirst + nCount,
+		[nAxis](const OccluderBox& lhs, const OccluderBox& rhs) { return lhs.vMin[nAxis] + lhs.vMax[nAxis] < rhs.vMin[nAxis] + rhs.vMax[nAxis]; });
+
+	BuildNode(nFirst, nHalf);
+	uint32_t nRight = BuildNode(nFirst + nHalf, nCount - nHalf);
+	mNodes[nNode].nFirst = nRight;
+	mNodes[nNode].nCount = 0;
+	return nNode;
+}
+
+// Where the line enters and leaves a box, as fractions of the way from one end to the other
+static inline void IntersectSlabs(const glm::vec3& vMin, const glm::vec3& vMax, const glm::vec3& vFrom, const glm::vec3& vInvDelta,
+	float& fEnter, float& fExit)
+{
+	glm::vec3 vNear = (vMin - vFrom) * vInvDelta;
+	glm::vec3 vFar = (vMax - vFrom) * vInvDelta;
+	glm::vec3 vEnter = glm::min(vNear, vFar);
+	glm::vec3 vExit = glm::max(vNear, vFar);
+	fEnter = std::max(std::max(vEnter.x, vEnter.y), vEnter.z);
+	fExit = std::min(std::min(vExit.x, vExit.y), vExit.z);
+}
+
+float OcclusionBVH::Trace(const glm::vec3& vFrom, const glm::vec3& vTo) const
+{
+	if (mNodes.empty())
+		return 0.0f;
+
+	// Dividing by a zero component gives infinity, which the slab test handles the way we want
+	glm::vec3 vInvDelta = 1.0f / (vTo - vFrom);
+
+	float fOcclusion = 0.0f;
+	uint32_t stack[MAX_TRACE_DEPTH];
+	int nDepth = 0;
+	stack[nDepth++] = 0;
+	while (nDepth > 0)
+	{
+		const Node& node = mNodes[stack[--nDepth]];
+
+		float fEnter, fExit;
+		IntersectSlabs(node.vMin, node.vMax, vFrom, vInvDelta, fEnter, fExit);
+		if (fEnter > fExit || fExit < 0.0f || fEnter > 1.0f)
+			continue;
+
+		if (node.nCount == 0)
+		{
+			stack[nDepth++] = (uint32_t)(&node - mNodes.data()) + 1;
+			stack[nDepth++] = node.nFirst;
+			continue;
+		}
+
+		for (uint32_t i = node.nFirst; i < node.nFirst + node.nCount; i++)
+		{
+			const OccluderBox& box = mBoxes[i];
+			IntersectSlabs(box.vMin, box.vMax, vFrom, vInvDelta, fEnter, fExit);
+			if (fEnter > 0.0f && fExit < 1.0f && fEnter <= fExit)
+			{
+				fOcclusion += box.fStrength;
+				if (fOcclusion >= 1.0f)
+					return 1.0f;
+			}
+		}
+	}
+
+	return fOcclusion;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+// Standard Library
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+/*
+ * A world space box that blocks sound. Strength is how much of the sound it blocks on its own, so a thin wall
+ * can let some through while a solid block stops all of it.
+ */
+struct OccluderBox
+{
+	glm::vec3 vMin = glm::vec3(0.0f);
+	glm::vec3 vMax = glm::vec3(0.0f);
+	float fStrength = 1.0f;
+};
+
+/*
+ * A bounding volume hierarchy over OccluderBoxes, for tracing the line between a listener and a voice. It is only
+ * as detailed as the boxes it is given, which is plenty for deciding how muffled something should sound.
+ */
+class OcclusionBVH
+{
+public:
+	// Rebuilds the whole tree, it is meant for geometry that changes now and then rather than every frame
+	void Build(const OccluderBox* pBoxes, int nCount);
+	void Clear();
+	bool IsEmpty() const { return mBoxes.empty(); }
+	int GetBoxCount() const { return (int)mBoxes.size(); }
+	int GetNodeCount() const { return (int)mNodes.size(); }
+
+	// The strengths of every box the line from vFrom to vTo passes all the way through, added up to at most 1.
+	// Boxes around either end don't count, so a voice isn't blocked by whatever it is attached to.
+	float Trace(const glm::vec3& vFrom, const glm::vec3& vTo) const;
+
+private:
+	// Children are stored next to each other, the left one right after its parent
+	struct Node
+	{
+		glm::vec3 vMin;
+		uint32_t nFirst; // the right child for interior nodes, the first box for leaves
+		glm::vec3 vMax;
+		uint32_t nCount; // boxes in a leaf, 0 for interior nodes
+	};
+
+	uint32_t BuildNode(uint32_t nFirst, uint32_t nCount);
+
+	std::vector<Node> mNodes;
+	std::vector<OccluderBox> mBoxes; // reordered so every leaf's boxes are together
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include <memory>
+#include <GLM/glm.hpp>
+#include "MotionPath.h"
+#include "AudioEngine.h"
+
+/*
+ * Moves an entity along a MotionPath. Any number of entities can share a path, AudioLayer samples all of them
+ * in one pass each frame, before the emitters are gathered, so an AudioEmitterComponent on the same entity follows it.
+ */
+struct AudioPathComponent {
+	std::shared_ptr<const MotionPath> Path;
+	// Added to every point on the path, so entities can share a path from different places
+	glm::vec3   Origin = glm::vec3(0.0f);
+	// How far along the path the entity is, in seconds
+	float       Time = 0.0f;
+	// How fast Time moves along, 0 to hold still
+	float       Speed = 1.0f;
+	bool        Loop = false;
+	// If set, Time follows this voice's timeline position instead of the frame time, so the movement stays in step
+	// with the sound (Speed still scales it)
+	EventHandle SyncEvent = INVALID_EVENT_HANDLE;
+	// The voice AudioLayer last asked the engine to track, so it only asks when SyncEvent changes
+	EventHandle TrackedEvent = INVALID_EVENT_HANDLE;
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+// Standard Library
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+typedef uint32_t EventHandle;
+typedef uint32_t ParameterHandle;
+
+/*
+ * A deferred call into the AudioEngine. When the engine runs its own update thread, the per frame
+ * calls are packed into one of these and run on the audio thread during its next tick.
+ */
+struct AudioCommand
+{
+	enum class Type : uint8_t
+	{
+		PlayEvent,
+		StopEvent,
+		StopAllVoices,
+		SetEventPosition,
+		SetEventOrientation,
+		SetEventParameter,
+		SetGlobalParameter,
+		SetEventParameterByHandle,
+		SetGlobalParameterByHandle,
+		SetListenerPosition,
+		SetListenerOrientation,
+		SetNumListeners,
+		TrackTimelinePosition
+	};
+
+	// Parameter names are copied in, so longer names can't be queued
+	static const size_t MAX_NAME_LENGTH = 32;
+
+	Type eType;
+	EventHandle hEvent;
+	bool bFlag;
+	float fValue;
+	ParameterHandle hParameter;
+	int nIndex; // the listener, or the number of listeners for SetNumListeners
+	EventHandle hVoice; // the voice PlayEvent picked on the game thread
+	glm::vec3 vA;
+	glm::vec3 vB;
+	char strName[MAX_NAME_LENGTH];
+};
+
+/*
+ * A fixed size, lock-free ring buffer of commands with exactly one producer (the game thread) and
+ * one consumer (the audio thread). Push never blocks, it fails if the audio thread has fallen behind.
+ */
+class AudioCommandQueue
+{
+public:
+	// nCapacity is rounded up to a power of two
+	AudioCommandQueue(size_t nCapacity = 4096)
+	{
+		size_t nSize = 1;
+		while (nSize < nCapacity)
+			nSize <<= 1;
+
+		mCommands.resize(nSize);
+		mnMask = nSize - 1;
+		mnHead = 0;
+		mnTail = 0;
+	}
+
+	// Called from the producer thread only
+	bool Push(const AudioCommand& command)
+	{
+		size_t nTail = mnTail.load(std::memory_order_relaxed);
+		if (nTail - mnHead.load(std::memory_order_acquire) > mnMask)
+			return false;
+
+		mCommands[nTail & mnMask] = command;
+		mnTail.store(nTail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Called from the consumer thread only
+	bool Pop(AudioCommand& command)
+	{
+		size_t nHead = mnHead.load(std::memory_order_relaxed);
+		if (nHead == mnTail.load(std::memory_order_acquire))
+			return false;
+
+		command = mCommands[nHead & mnMask];
+		mnHead.store(nHead + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	std::vector<AudioCommand> mCommands;
+	size_t mnMask;
+
+	// Kept on separate cache lines so the two threads don't fight over them
+	alignas(64) std::atomic<size_t> mnHead;
+	alignas(64) std::atomic<size_t> mnTail;
+};
+
+/*
+ * Hands the latest copy of some state from one writer thread to one reader thread without either
+ * of them ever waiting. The writer fills the back buffer and swaps it with the middle one, the reader
+ * swaps its front buffer with the middle one whenever the writer has published something new.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() : mnBack(0), mnMiddle(1), mnFront(2) { }
+
+	// The writer fills this in, then calls Publish
+	T& GetBack() { return mBuffers[mnBack]; }
+
+	void Publish()
+	{
+		mnBack = mnMiddle.exchange(mnBack | NEW_DATA, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	// The reader always gets the most recently published state
+	const T& GetFront()
+	{
+		if (mnMiddle.load(std::memory_order_relaxed) & NEW_DATA)
+			mnFront = mnMiddle.exchange(mnFront, std::memory_order_acq_rel) & INDEX_MASK;
+
+		return mBuffers[mnFront];
+	}
+
+private:
+	static const int NEW_DATA = 4;
+	static const int INDEX_MASK = 3;
+
+	T mBuffers[3];
+	int mnBack;
+	std::atomic<int> mnMiddle;
+	int mnFront;
+};
@@ -0,0 +1,11 @@
+#pragma once
+#include <GLM/glm.hpp>
+
+/*
+ * The bounds of a renderable's mesh, in its local space. The culling layer keeps a world space box for each one,
+ * renderables without bounds are never culled.
+ */
+struct BoundsComponent {
+	glm::vec3 Min = glm::vec3(-0.5f);
+	glm::vec3 Max = glm::vec3(0.5f);
+};
@@ -0,0 +1,82 @@
+#include "Easing.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EASING_SSE
+#include <emmintrin.h>
+#endif
+
+#ifdef EASING_SSE
+
+// The same curves as the scalar versions, four at a time
+static inline __m128 Pow8(__m128 x)
+{
+	x = _mm_mul_ps(x, x);
+	x = _mm_mul_ps(x, x);
+	return _mm_mul_ps(x, x);
+}
+
+static inline __m128 Evaluate4(Easing::Curve eCurve, __m128 u)
+{
+	const __m128 ONE = _mm_set1_ps(1.0f);
+	const __m128 HALF = _mm_set1_ps(0.5f);
+	const __m128 TWO = _mm_set1_ps(2.0f);
+
+	switch (eCurve)
+	{
+	case Easing::Curve::EaseIn:
+	{
+		__m128 u2 = _mm_mul_ps(u, u);
+		return _mm_mul_ps(_mm_mul_ps(u2, u2), u);
+	}
+	case Easing::Curve::EaseOut:
+		return _mm_sub_ps(ONE, Pow8(_mm_sub_ps(ONE, u)));
+	case Easing::Curve::EaseInOut:
+	{
+		// Both halves are worked out and the mask picks one, so there is no branch per value
+		__m128 lower = _mm_mul_ps(HALF, Pow8(_mm_mul_ps(TWO, u)));
+		__m128 upper = _mm_sub_ps(ONE, _mm_mul_ps(HALF, Pow8(_mm_mul_ps(TWO, _mm_sub_ps(ONE, u)))));
+		__m128 mask = _mm_cmplt_ps(u, HALF);
+		return _mm_or_ps(_mm_and_ps(mask, lower), _mm_andnot_ps(mask, upper));
+	}
+	default:
+		return u;
+	}
+}
+
+#endif
+
+void Easing::Evaluate(Curve eCurve, const float* pU, float* pOut, size_t nCount)
+{
+	size_t i = 0;
+#ifdef EASING_SSE
+	for (; i + 4 <= nCount; i += 4)
+	{
+		_mm_storeu_ps(pOut + i, Evaluate4(eCurve, _mm_loadu_ps(pU + i)));
+	}
+#endif
+
+	// Whatever doesn't fill a whole vector
+	for (; i < nCount; i++)
+	{
+		pOut[i] = Evaluate(eCurve, pU[i]);
+	}
+}
+
+void Easing::Lerp(Curve eCurve, float a, float b, const float* pU, float* pOut, size_t nCount)
+{
+	size_t i = 0;
+#ifdef EASING_SSE
+	__m128 start = _mm_set1_ps(a);
+	__m128 range = _mm_set1_ps(b - a);
+	for (; i + 4 <= nCount; i += 4)
+	{
+		__m128 t = Evaluate4(eCurve, _mm_loadu_ps(pU + i));
+		_mm_storeu_ps(pOut + i, _mm_add_ps(start, _mm_mul_ps(range, t)));
+	}
+#endif
+
+	for (; i < nCount; i++)
+	{
+		pOut[i] = Lerp(eCurve, a, b, pU[i]);
+	}
+}
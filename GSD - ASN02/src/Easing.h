@@ -0,0 +1,54 @@
+#pragma once
+
+// Standard Library
+#include <cstddef>
+
+/*
+ * The easing curves used for scripted movement. Every curve is a whole number power, so it is written out as
+ * a handful of multiplies that the compiler can fold or inline instead of calling powf. The scalar versions are
+ * constexpr, and the batch versions work through four values at a time with SSE where it is available.
+ * Curves expect u from 0 to 1, and stay within 5e-7 (a few float steps near 1) of the exact curve over that range.
+ */
+namespace Easing
+{
+	enum class Curve
+	{
+		Linear,
+		EaseIn,   // y = x^5, slow start
+		EaseOut,  // y = 1 - (1 - x)^8, slow finish
+		EaseInOut // x^8 scaled onto each half, slow start and finish
+	};
+
+	// x^N by squaring, unrolled at compile time
+	template <int N>
+	constexpr float Pow(float x) { return (N % 2 == 1 ? x : 1.0f) * Pow<N / 2>(x * x); }
+	template <>
+	constexpr float Pow<0>(float) { return 1.0f; }
+
+	constexpr float EaseIn(float u) { return Pow<5>(u); }
+	constexpr float EaseOut(float u) { return 1.0f - Pow<8>(1.0f - u); }
+	constexpr float EaseInOut(float u)
+	{
+		return u < 0.5f ?
+			0.5f * Pow<8>(2.0f * u) :
+			1.0f - 0.5f * Pow<8>(2.0f * (1.0f - u));
+	}
+
+	constexpr float Evaluate(Curve eCurve, float u)
+	{
+		return eCurve == Curve::EaseIn ? EaseIn(u) :
+			eCurve == Curve::EaseOut ? EaseOut(u) :
+			eCurve == Curve::EaseInOut ? EaseInOut(u) :
+			u;
+	}
+
+	// Eases from a to b
+	constexpr float Lerp(Curve eCurve, float a, float b, float u)
+	{
+		return a + (b - a) * Evaluate(eCurve, u);
+	}
+
+	// Batch versions, pOut[i] is the curve at pU[i]. pOut can be the same array as pU.
+	void Evaluate(Curve eCurve, const float* pU, float* pOut, size_t nCount);
+	void Lerp(Curve eCurve, float a, float b, const float* pU, float* pOut, size_t nCount);
+}
@@ -0,0 +1,391 @@
+#include "FMODAudioBackend.h"
+#include "AudioEngine.h"
+
+#ifndef AUDIO_NO_FMOD
+
+// The opaque backend handles are the FMOD objects themselves
+static FMOD::Studio::Bank* ToFMOD(BackendBank* pBank) { return reinterpret_cast<FMOD::Studio::Bank*>(pBank); }
+static FMOD::Studio::EventDescription* ToFMOD(BackendEventDescription* pDescription) { return reinterpret_cast<FMOD::Studio::EventDescription*>(pDescription); }
+static FMOD::Studio::EventInstance* ToFMOD(BackendEventInstance* pInstance) { return reinterpret_cast<FMOD::Studio::EventInstance*>(pInstance); }
+static FMOD::Sound* ToFMOD(BackendSound* pSound) { return reinterpret_cast<FMOD::Sound*>(pSound); }
+static FMOD::Channel* ToFMOD(BackendChannel* pChannel) { return reinterpret_cast<FMOD::Channel*>(pChannel); }
+
+FMODAudioBackend::FMODAudioBackend(const char* strOutputFile)
+{
+	mpStudioSystem = NULL;
+	AudioEngine::ErrorCheck(FMOD::Studio::System::create(&mpStudioSystem));
+
+	mpSystem = NULL;
+	AudioEngine::ErrorCheck(mpStudioSystem->getCoreSystem(&mpSystem));
+
+	mfUpdateStep = 0.0f;
+	if (strOutputFile)
+	{
+		// Everything (studio, streams and the mixer) runs inside update, so nothing happens between updates
+		AudioEngine::ErrorCheck(mpSystem->setOutput(FMOD_OUTPUTTYPE_WAVWRITER_NRT));
+		AudioEngine::ErrorCheck(mpStudioSystem->initialize(32, FMOD_STUDIO_INIT_SYNCHRONOUS_UPDATE,
+			FMOD_INIT_3D_RIGHTHANDED | FMOD_INIT_STREAM_FROM_UPDATE | FMOD_INIT_MIX_FROM_UPDATE, (void*)strOutputFile));
+
+		unsigned int nBlockLength = 1024;
+		int nSampleRate = 48000;
+		AudioEngine::ErrorCheck(mpSystem->getDSPBufferSize(&nBlockLength, NULL));
+		AudioEngine::ErrorCheck(mpSystem->getSoftwareFormat(&nSampleRate, NULL, NULL));
+		mfUpdateStep = (float)nBlockLength / nSampleRate;
+	}
+	else
+	{
+		AudioEngine::ErrorCheck(mpStudioSystem->initialize(32, FMOD_STUDIO_INIT_NORMAL, FMOD_INIT_3D_RIGHTHANDED, NULL));
+	}
+
+	// So the channel callback can find its way back here
+	AudioEngine::ErrorCheck(mpSystem->setUserData(this));
+
+	mnPlayingChannels = 0;
+	mnCallCount = 0;
+}
+
+FMODAudioBackend::~FMODAudioBackend()
+{
+	AudioEngine::ErrorCheck(mpStudioSystem->unloadAll());
+	AudioEngine::ErrorCheck(mpStudioSystem->release());
+}
+
+
+//////// System ////////
+
+FMOD_RESULT FMODAudioBackend::Update()
+{
+	mnCallCount++;
+	// Channels that ended are picked up by ChannelCallback during the update
+	return mpStudioSystem->update();
+}
+
+FMOD_RESULT FMODAudioBackend::UnloadAll()
+{
+	mnCallCount++;
+	return mpStudioSystem->unloadAll();
+}
+
+FMOD_RESULT FMODAudioBackend::SetNumListeners(int nListeners)
+{
+	mnCallCount++;
+	return mpStudioSystem->setNumListeners(nListeners);
+}
+
+FMOD_RESULT FMODAudioBackend::SetListenerAttributes(int nListener, const FMOD_3D_ATTRIBUTES& attributes)
+{
+	mnCallCount++;
+	return mpStudioSystem->setListenerAttributes(nListener, &attributes);
+}
+
+FMOD_RESULT FMODAudioBackend::SetParameterByName(const char* strName, float fValue)
+{
+	mnCallCount++;
+	return mpStudioSystem->setParameterByName(strName, fValue);
+}
+
+FMOD_RESULT FMODAudioBackend::GetParameterDescriptionByName(const char* strName, FMOD_STUDIO_PARAMETER_DESCRIPTION* pParameter)
+{
+	mnCallCount++;
+	return mpStudioSystem->getParameterDescriptionByName(strName, pParameter);
+}
+
+FMOD_RESULT FMODAudioBackend::SetParametersByIDs(const FMOD_STUDIO_PARAMETER_ID* pIDs, float* pValues, int nCount)
+{
+	mnCallCount++;
+	return mpStudioSystem->setParametersByIDs(pIDs, pValues, nCount);
+}
+
+
+//////// Banks ////////
+
+FMOD_RESULT FMODAudioBackend::LoadBankFile(const char* strFileName, FMOD_STUDIO_LOAD_BANK_FLAGS flags, BackendBank** ppBank)
+{
+	mnCallCount++;
+	FMOD::Studio::Bank* pBank = NULL;
+	FMOD_RESULT result = mpStudioSystem->loadBankFile(strFileName, flags, &pBank);
+	*ppBank = reinterpret_cast<BackendBank*>(pBank);
+	return result;
+}
+
+FMOD_RESULT FMODAudioBackend::GetLoadingState(BackendBank* pBank, FMOD_STUDIO_LOADING_STATE* pState)
+{
+	mnCallCount++;
+	return ToFMOD(pBank)->getLoadingState(pState);
+}
+
+FMOD_RESULT FMODAudioBackend::GetEventCount(BackendBank* pBank, int* pCount)
+{
+	mnCallCount++;
+	return ToFMOD(pBank)->getEventCount(pCount);
+}
+
+FMOD_RESULT FMODAudioBackend::GetEventList(BackendBank* pBank, BackendEventDescription** ppDescriptions, int nCapacity, int* pCount)
+{
+	mnCallCount++;
+	return ToFMOD(pBank)->getEventList(reinterpret_cast<FMOD::Studio::EventDescription**>(ppDescriptions), nCapacity, pCount);
+}
+
+
+//////// Event Descriptions ////////
+
+FMOD_RESULT FMODAudioBackend::GetEventByID(const FMOD_GUID* pGUID, BackendEventDescription** ppDescription)
+{
+	mnCallCount++;
+	FMOD::Studio::EventDescription* pDescription = NULL;
+	FMOD_RESULT result = mpStudioSystem->getEventByID(pGUID, &pDescription);
+	*ppDescription = reinterpret_cast<BackendEventDescription*>(pDescription);
+	return result;
+}
+
+FMOD_RESULT FMODAudioBackend::Is3D(BackendEventDescription* pDescription, bool* pIs3D)
+{
+	mnCallCount++;
+	return ToFMOD(pDescription)->is3D(pIs3D);
+}
+
+FMOD_RESULT FMODAudioBackend::GetMinimumDistance(BackendEventDescription* pDescription, float* pDistance)
+{
+	mnCallCount++;
+	return ToFMOD(pDescription)->getMinimumDistance(pDistance);
+}
+
+FMOD_RESULT FMODAudioBackend::GetMaximumDistance(BackendEventDescription* pDescription, float* pDistance)
+{
+	mnCallCount++;
+	return ToFMOD(pDescription)->getMaximumDistance(pDistance);
+}
+
+FMOD_RESULT FMODAudioBackend::GetLength(BackendEventDescription* pDescription, int* pLength)
+{
+	mnCallCount++;
+	return ToFMOD(pDescription)->getLength(pLength);
+}
+
+FMOD_RESULT FMODAudioBackend::IsStream(BackendEventDescription* pDescription, bool* pIsStream)
+{
+	mnCallCount++;
+	return ToFMOD(pDescription)->isStream(pIsStream);
+}
+
+FMOD_RESULT FMODAudioBackend::LoadSampleData(BackendEventDescription* pDescription)
+{
+	mnCallCount++;
+	return ToFMOD(pDescription)->loadSampleData();
+}
+
+FMOD_RESULT FMODAudioBackend::UnloadSampleData(BackendEventDescription* pDescription)
+{
+	mnCallCount++;
+	return ToFMOD(pDescription)->unloadSampleData();
+}
+
+FMOD_RESULT FMODAudioBackend::GetSampleLoadingState(BackendEventDescription* pDescription, FMOD_STUDIO_LOADING_STATE* pState)
+{
+	mnCallCount++;
+	return ToFMOD(pDescription)->getSampleLoadingState(pState);
+}
+
+FMOD_RESULT FMODAudioBackend::CreateInstance(BackendEventDescription* pDescription, BackendEventInstance** ppInstance)
+{
+	mnCallCount++;
+	FMOD::Studio::EventInstance* pInstance = NULL;
+	FMOD_RESULT result = ToFMOD(pDescription)->createInstance(&pInstance);
+	*ppInstance = reinterpret_cast<BackendEventInstance*>(pInstance);
+	return result;
+}
+
+FMOD_RESULT FMODAudioBackend::GetParameterDescriptionByName(BackendEventDescription* pDescription, const char* strName, FMOD_STUDIO_PARAMETER_DESCRIPTION* pParameter)
+{
+	mnCallCount++;
+	return ToFMOD(pDescription)->getParameterDescriptionByName(strName, pParameter);
+}
+
+
+//////// Event Instances ////////
+
+FMOD_RESULT FMODAudioBackend::Start(BackendEventInstance* pInstance)
+{
+	mnCallCount++;
+	return ToFMOD(pInstance)->start();
+}
+
+FMOD_RESULT FMODAudioBackend::Stop(BackendEventInstance* pInstance, FMOD_STUDIO_STOP_MODE eMode)
+{
+	mnCallCount++;
+	return ToFMOD(pInstance)->stop(eMode);
+}
+
+FMOD_RESULT FMODAudioBackend::Release(BackendEventInstance* pInstance)
+{
+	mnCallCount++;
+	return ToFMOD(pInstance)->release();
+}
+
+FMOD_RESULT FMODAudioBackend::SetPaused(BackendEventInstance* pInstance, bool bPaused)
+{
+	mnCallCount++;
+	return ToFMOD(pInstance)->setPaused(bPaused);
+}
+
+FMOD_RESULT FMODAudioBackend::GetPlaybackState(BackendEventInstance* pInstance, FMOD_STUDIO_PLAYBACK_STATE* pState)
+{
+	mnCallCount++;
+	return ToFMOD(pInstance)->getPlaybackState(pState);
+}
+
+FMOD_RESULT FMODAudioBackend::GetTimelinePosition(BackendEventInstance* pInstance, int* pPosition)
+{
+	mnCallCount++;
+	return ToFMOD(pInstance)->getTimelinePosition(pPosition);
+}
+
+FMOD_RESULT FMODAudioBackend::Set3DAttributes(BackendEventInstance* pInstance, const FMOD_3D_ATTRIBUTES& attributes)
+{
+	mnCallCount++;
+	return ToFMOD(pInstance)->set3DAttributes(&attributes);
+}
+
+FMOD_RESULT FMODAudioBackend::GetAudibility(BackendEventInstance* pInstance, float* pAudibility)
+{
+	mnCallCount++;
+	// Audibility lives on the instance's channel group, which only exists once it has started
+	FMOD::ChannelGroup* pGroup = NULL;
+	FMOD_RESULT result = ToFMOD(pInstance)->getChannelGroup(&pGroup);
+	if (result != FMOD_OK)
+		return result;
+	if (!pGroup)
+		return FMOD_ERR_STUDIO_NOT_LOADED;
+
+	return pGroup->getAudibility(pAudibility);
+}
+
+FMOD_RESULT FMODAudioBackend::GetMemoryUsage(BackendEventInstance* pInstance, FMOD_STUDIO_MEMORY_USAGE* pUsage)
+{
+	mnCallCount++;
+	return ToFMOD(pInstance)->getMemoryUsage(pUsage);
+}
+
+FMOD_RESULT FMODAudioBackend::GetParameterByName(BackendEventInstance* pInstance, const char* strName, float* pValue)
+{
+	mnCallCount++;
+	return ToFMOD(pInstance)->getParameterByName(strName, pValue);
+}
+
+FMOD_RESULT FMODAudioBackend::SetParameterByName(BackendEventInstance* pInstance, const char* strName, float fValue)
+{
+	mnCallCount++;
+	return ToFMOD(pInstance)->setParameterByName(strName, fValue);
+}
+
+FMOD_RESULT FMODAudioBackend::SetParametersByIDs(BackendEventInstance* pInstance, const FMOD_STUDIO_PARAMETER_ID* pIDs, float* pValues, int nCount)
+{
+	mnCallCount++;
+	return ToFMOD(pInstance)->setParametersByIDs(pIDs, pValues, nCount);
+}
+
+
+//////// Sounds and Channels ////////
+
+FMOD_RESULT FMODAudioBackend::CreateSound(const char* strFileName, FMOD_MODE mode, BackendSound** ppSound)
+{
+	mnCallCount++;
+	FMOD::Sound* pSound = NULL;
+	FMOD_RESULT result = mpSystem->createSound(strFileName, mode, NULL, &pSound);
+	*ppSound = reinterpret_cast<BackendSound*>(pSound);
+	return result;
+}
+
+FMOD_RESULT FMODAudioBackend::ReleaseSound(BackendSound* pSound)
+{
+	mnCallCount++;
+	// Any channels still playing the sound are stopped, and their end callbacks still fire
+	return ToFMOD(pSound)->release();
+}
+
+FMOD_RESULT FMODAudioBackend::PlaySound(BackendSound* pSound, uint32_t nChannelId, bool bPaused, BackendChannel** ppChannel)
+{
+	mnCallCount++;
+	*ppChannel = NULL;
+
+	// Make room for this channel's id now, so the callback never has to allocate
+	size_t nNeeded = mEndedChannels.size() + mnPlayingChannels + 1;
+	if (mEndedChannels.capacity() < nNeeded)
+		mEndedChannels.reserve(nNeeded * 2);
+
+	// Start paused so the callback is in place before anything can play
+	FMOD::Channel* pChannel = NULL;
+	FMOD_RESULT result = mpSystem->playSound(ToFMOD(pSound), NULL, true, &pChannel);
+	if (result != FMOD_OK)
+		return result;
+
+	pChannel->setUserData((void*)(uintptr_t)nChannelId);
+	pChannel->setCallback(&FMODAudioBackend::ChannelCallback);
+	mnPlayingChannels++;
+
+	*ppChannel = reinterpret_cast<BackendChannel*>(pChannel);
+	return bPaused ? FMOD_OK : pChannel->setPaused(false);
+}
+
+FMOD_RESULT FMODAudioBackend::StopChannel(BackendChannel* pChannel)
+{
+	mnCallCount++;
+	return ToFMOD(pChannel)->stop();
+}
+
+FMOD_RESULT FMODAudioBackend::SetChannelPaused(BackendChannel* pChannel, bool bPaused)
+{
+	mnCallCount++;
+	return ToFMOD(pChannel)->setPaused(bPaused);
+}
+
+FMOD_RESULT FMODAudioBackend::SetChannel3DAttributes(BackendChannel* pChannel, const FMOD_VECTOR& position, const FMOD_VECTOR& velocity)
+{
+	mnCallCount++;
+	return ToFMOD(pChannel)->set3DAttributes(&position, &velocity);
+}
+
+FMOD_RESULT FMODAudioBackend::SetChannelVolume(BackendChannel* pChannel, float fVolume)
+{
+	mnCallCount++;
+	return ToFMOD(pChannel)->setVolume(fVolume);
+}
+
+FMOD_RESULT F_CALLBACK FMODAudioBackend::ChannelCallback(FMOD_CHANNELCONTROL* pChannelControl, FMOD_CHANNELCONTROL_TYPE eControlType,
+	FMOD_CHANNELCONTROL_CALLBACK_TYPE eCallbackType, void* pCommandData1, void* pCommandData2)
+{
+	if (eControlType != FMOD_CHANNELCONTROL_CHANNEL || eCallbackType != FMOD_CHANNELCONTROL_CALLBACK_END)
+		return FMOD_OK;
+
+	FMOD::Channel* pChannel = reinterpret_cast<FMOD::Channel*>(pChannelControl);
+	FMOD::System* pSystem = NULL;
+	void* pChannelId = NULL;
+	void* pBackend = NULL;
+	pChannel->getUserData(&pChannelId);
+	pChannel->getSystemObject(&pSystem);
+	if (!pSystem || pSystem->getUserData(&pBackend) != FMOD_OK || !pBackend)
+		return FMOD_OK;
+
+	FMODAudioBackend& backend = *static_cast<FMODAudioBackend*>(pBackend);
+	backend.mEndedChannels.push_back((uint32_t)(uintptr_t)pChannelId);
+	if (backend.mnPlayingChannels > 0)
+		backend.mnPlayingChannels--;
+
+	return FMOD_OK;
+}
+
+
+//////// Profiling ////////
+
+FMOD_RESULT FMODAudioBackend::GetCPUUsage(FMOD_STUDIO_CPU_USAGE* pUsage)
+{
+	return mpStudioSystem->getCPUUsage(pUsage);
+}
+
+FMOD_RESULT FMODAudioBackend::GetMemoryUsage(int* pCurrent, int* pMax)
+{
+	// Not blocking, so the numbers can be a little behind if another thread is allocating
+	return FMOD::Memory_GetStats(pCurrent, pMax, false);
+}
+
+#endif
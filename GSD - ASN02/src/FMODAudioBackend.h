@@ -0,0 +1,101 @@
+#pragma once
+
+#include "AudioBackend.h"
+
+// FMOD
+#include "fmod_studio.hpp"
+#include "fmod.hpp"
+
+// Standard Library
+#include <vector>
+
+/*
+ * The real backend, forwards everything to FMOD Studio. Defining AUDIO_NO_FMOD leaves it out of the
+ * build, for machines that don't have the FMOD libraries.
+ */
+class FMODAudioBackend : public AudioBackend
+{
+public:
+	// Given an output file, FMOD writes the mix there with its non realtime WAV writer instead of playing it. Each
+	// update then mixes exactly one DSP block, so the render runs as fast as updates are called and always comes
+	// out the same.
+	FMODAudioBackend(const char* strOutputFile = NULL);
+	~FMODAudioBackend();
+
+	AudioBackendType GetType() const override { return mfUpdateStep > 0.0f ? AudioBackendType::Offline : AudioBackendType::FMOD; }
+	float GetUpdateStep() const override { return mfUpdateStep; }
+
+	// System
+	FMOD_RESULT Update() override;
+	FMOD_RESULT UnloadAll() override;
+	FMOD_RESULT SetNumListeners(int nListeners) override;
+	FMOD_RESULT SetListenerAttributes(int nListener, const FMOD_3D_ATTRIBUTES& attributes) override;
+	FMOD_RESULT SetParameterByName(const char* strName, float fValue) override;
+	FMOD_RESULT GetParameterDescriptionByName(const char* strName, FMOD_STUDIO_PARAMETER_DESCRIPTION* pParameter) override;
+	FMOD_RESULT SetParametersByIDs(const FMOD_STUDIO_PARAMETER_ID* pIDs, float* pValues, int nCount) override;
+
+	// Banks
+	FMOD_RESULT LoadBankFile(const char* strFileName, FMOD_STUDIO_LOAD_BANK_FLAGS flags, BackendBank** ppBank) override;
+	FMOD_RESULT GetLoadingState(BackendBank* pBank, FMOD_STUDIO_LOADING_STATE* pState) override;
+	FMOD_RESULT GetEventCount(BackendBank* pBank, int* pCount) override;
+	FMOD_RESULT GetEventList(BackendBank* pBank, BackendEventDescription** ppDescriptions, int nCapacity, int* pCount) override;
+
+	// Event descriptions
+	FMOD_RESULT GetEventByID(const FMOD_GUID* pGUID, BackendEventDescription** ppDescription) override;
+	FMOD_RESULT Is3D(BackendEventDescription* pDescription, bool* pIs3D) override;
+	FMOD_RESULT GetMinimumDistance(BackendEventDescription* pDescription, float* pDistance) override;
+	FMOD_RESULT GetMaximumDistance(BackendEventDescription* pDescription, float* pDistance) override;
+	FMOD_RESULT GetLength(BackendEventDescription* pDescription, int* pLength) override;
+	FMOD_RESULT IsStream(BackendEventDescription* pDescription, bool* pIsStream) override;
+	FMOD_RESULT LoadSampleData(BackendEventDescription* pDescription) override;
+	FMOD_RESULT UnloadSampleData(BackendEventDescription* pDescription) override;
+	FMOD_RESULT GetSampleLoadingState(BackendEventDescription* pDescription, FMOD_STUDIO_LOADING_STATE* pState) override;
+	FMOD_RESULT CreateInstance(BackendEventDescription* pDescription, BackendEventInstance** ppInstance) override;
+	FMOD_RESULT GetParameterDescriptionByName(BackendEventDescription* pDescription, const char* strName, FMOD_STUDIO_PARAMETER_DESCRIPTION* pParameter) override;
+
+	// Event instances
+	FMOD_RESULT Start(BackendEventInstance* pInstance) override;
+	FMOD_RESULT Stop(BackendEventInstance* pInstance, FMOD_STUDIO_STOP_MODE eMode) override;
+	FMOD_RESULT Release(BackendEventInstance* pInstance) override;
+	FMOD_RESULT SetPaused(BackendEventInstance* pInstance, bool bPaused) override;
+	FMOD_RESULT GetPlaybackState(BackendEventInstance* pInstance, FMOD_STUDIO_PLAYBACK_STATE* pState) override;
+	FMOD_RESULT GetTimelinePosition(BackendEventInstance* pInstance, int* pPosition) override;
+	FMOD_RESULT Set3DAttributes(BackendEventInstance* pInstance, const FMOD_3D_ATTRIBUTES& attributes) override;
+	FMOD_RESULT GetAudibility(BackendEventInstance* pInstance, float* pAudibility) override;
+	FMOD_RESULT GetMemoryUsage(BackendEventInstance* pInstance, FMOD_STUDIO_MEMORY_USAGE* pUsage) override;
+	FMOD_RESULT GetParameterByName(BackendEventInstance* pInstance, const char* strName, float* pValue) override;
+	FMOD_RESULT SetParameterByName(BackendEventInstance* pInstance, const char* strName, float fValue) override;
+	FMOD_RESULT SetParametersByIDs(BackendEventInstance* pInstance, const FMOD_STUDIO_PARAMETER_ID* pIDs, float* pValues, int nCount) override;
+
+	// Sounds and channels
+	FMOD_RESULT CreateSound(const char* strFileName, FMOD_MODE mode, BackendSound** ppSound) override;
+	FMOD_RESULT ReleaseSound(BackendSound* pSound) override;
+	FMOD_RESULT PlaySound(BackendSound* pSound, uint32_t nChannelId, bool bPaused, BackendChannel** ppChannel) override;
+	FMOD_RESULT StopChannel(BackendChannel* pChannel) override;
+	FMOD_RESULT SetChannelPaused(BackendChannel* pChannel, bool bPaused) override;
+	FMOD_RESULT SetChannel3DAttributes(BackendChannel* pChannel, const FMOD_VECTOR& position, const FMOD_VECTOR& velocity) override;
+	FMOD_RESULT SetChannelVolume(BackendChannel* pChannel, float fVolume) override;
+	const std::vector<uint32_t>& GetEndedChannels() const override { return mEndedChannels; }
+	void ClearEndedChannels() override { mEndedChannels.clear(); }
+
+	// Profiling
+	size_t GetCallCount() const override { return mnCallCount; }
+	FMOD_RESULT GetCPUUsage(FMOD_STUDIO_CPU_USAGE* pUsage) override;
+	FMOD_RESULT GetMemoryUsage(int* pCurrent, int* pMax) override;
+
+private:
+	// FMOD calls this from System::update when a channel ends, finishes or is stopped
+	static FMOD_RESULT F_CALLBACK ChannelCallback(FMOD_CHANNELCONTROL* pChannelControl, FMOD_CHANNELCONTROL_TYPE eControlType,
+		FMOD_CHANNELCONTROL_CALLBACK_TYPE eCallbackType, void* pCommandData1, void* pCommandData2);
+
+	// System
+	FMOD::Studio::System* mpStudioSystem;
+	FMOD::System* mpSystem;
+
+	// Channels
+	std::vector<uint32_t> mEndedChannels;
+	size_t mnPlayingChannels; // played but not ended yet, mEndedChannels always has room for all of them
+
+	size_t mnCallCount;
+	float mfUpdateStep; // the length of a DSP block when rendering offline, otherwise 0
+};
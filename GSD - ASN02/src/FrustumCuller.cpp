@@ -0,0 +1,207 @@
+#include "FrustumCuller.h"
+#include "BoundsComponent.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CULLING_SSE
+#include <emmintrin.h>
+#endif
+
+typedef florp::game::RenderableComponent Renderable;
+
+// Renderables without bounds get a box big enough to always be inside, but small enough that the plane tests
+// can't overflow to infinity
+static const float UNBOUNDED_EXTENT = 1.0e30f;
+
+void FrustumCuller::Connect(entt::registry& registry) {
+	Resize(0);
+	myEntities.clear();
+	myIndices.clear();
+
+	registry.view<Renderable>().each([&](auto entity, Renderable& renderable) {
+		Add(entity);
+	});
+
+	registry.on_construct<Renderable>().connect<&FrustumCuller::OnConstruct>(*this);
+	registry.on_destroy<Renderable>().connect<&FrustumCuller::OnDestroy>(*this);
+}
+
+void FrustumCuller::Disconnect(entt::registry& registry) {
+	registry.on_construct<Renderable>().disconnect<&FrustumCuller::OnConstruct>(*this);
+	registry.on_destroy<Renderable>().disconnect<&FrustumCuller::OnDestroy>(*this);
+
+	Resize(0);
+	myEntities.clear();
+	myIndices.clear();
+}
+
+void FrustumCuller::OnConstruct(entt::entity entity, entt::registry& registry, const Renderable& renderable) {
+	Add(entity);
+}
+
+void FrustumCuller::OnDestroy(entt::entity entity, entt::registry& registry) {
+	auto it = myIndices.find(entity);
+	if (it == myIndices.end())
+		return;
+
+	// Swap the last renderable into the gap
+	uint32_t index = it->second;
+	uint32_t last = (uint32_t)myEntities.size() - 1;
+	myIndices.erase(it);
+	if (index != last) {
+		myEntities[index] = myEntities[last];
+		myCenterX[index] = myCenterX[last];
+		myCenterY[index] = myCenterY[last];
+		myCenterZ[index] = myCenterZ[last];
+		myExtentX[index] = myExtentX[last];
+		myExtentY[index] = myExtentY[last];
+		myExtentZ[index] = myExtentZ[last];
+		myVersions[index] = myVersions[last];
+		myDirty[index] = myDirty[last];
+		myIndices[myEntities[index]] = index;
+	}
+	myEntities.pop_back();
+	Resize(myEntities.size());
+}
+
+void FrustumCuller::Add(entt::entity entity) {
+	if (myIndices.find(entity) != myIndices.end())
+		return;
+
+	// The bounds are worked out on the next update, once the mesh and transform have been set up
+	myIndices[entity] = (uint32_t)myEntities.size();
+	myEntities.push_back(entity);
+	Resize(myEntities.size());
+	myDirty[myEntities.size() - 1] = 1;
+}
+
+void FrustumCuller::Resize(size_t count) {
+	size_t padded = (count + 3) & ~(size_t)3;
+	myCenterX.resize(padded);
+	myCenterY.resize(padded);
+	myCenterZ.resize(padded);
+	myExtentX.resize(padded);
+	myExtentY.resize(padded);
+	myExtentZ.resize(padded);
+	myVersions.resize(count);
+	myDirty.resize(count);
+}
+
+int FrustumCuller::UpdateBounds(entt::registry& registry, const WorldTransforms& transforms) {
+	int updated = 0;
+	for (size_t ix = 0; ix < myEntities.size(); ix++) {
+		entt::entity entity = myEntities[ix];
+
+		// Anything that hasn't moved keeps the box it had
+		uint32_t version = transforms.GetVersion(entity);
+		if (!myDirty[ix] && version == myVersions[ix])
+			continue;
+		const glm::mat4& world = transforms.GetWorld(entity);
+		myVersions[ix] = version;
+		myDirty[ix] = 0;
+		updated++;
+
+		if (!registry.has<BoundsComponent>(entity)) {
+			myCenterX[ix] = world[3].x;
+			myCenterY[ix] = world[3].y;
+			myCenterZ[ix] = world[3].z;
+			myExtentX[ix] = UNBOUNDED_EXTENT;
+			myExtentY[ix] = UNBOUNDED_EXTENT;
+			myExtentZ[ix] = UNBOUNDED_EXTENT;
+			// We'll keep checking, in case bounds get added later
+			myDirty[ix] = 1;
+			continue;
+		}
+
+		// Transform the centre, and add up how far each local axis reaches along each world axis to get the extents
+		const BoundsComponent& bounds = registry.get<BoundsComponent>(entity);
+		glm::vec3 localCenter = (bounds.Min + bounds.Max) * 0.5f;
+		glm::vec3 localExtent = (bounds.Max - bounds.Min) * 0.5f;
+		glm::vec3 center = glm::vec3(world * glm::vec4(localCenter, 1.0f));
+		glm::vec3 extent = glm::abs(glm::vec3(world[0])) * localExtent.x +
+			glm::abs(glm::vec3(world[1])) * localExtent.y +
+			glm::abs(glm::vec3(world[2])) * localExtent.z;
+
+		myCenterX[ix] = center.x;
+		myCenterY[ix] = center.y;
+		myCenterZ[ix] = center.z;
+		myExtentX[ix] = extent.x;
+		myExtentY[ix] = extent.y;
+		myExtentZ[ix] = extent.z;
+	}
+	return updated;
+}
+
+void FrustumCuller::Cull(const glm::mat4& viewProjection, std::vector<entt::entity>& visible) const {
+	visible.clear();
+
+	// The clip space planes, pulled straight out of the rows of the view projection matrix. They aren't normalized,
+	// the box test only cares which side of each plane things are on
+	glm::vec4 rows[4];
+	for (int ix = 0; ix < 4; ix++)
+		rows[ix] = glm::vec4(viewProjection[0][ix], viewProjection[1][ix], viewProjection[2][ix], viewProjection[3][ix]);
+	glm::vec4 planes[6] = {
+		rows[3] + rows[0], rows[3] - rows[0],
+		rows[3] + rows[1], rows[3] - rows[1],
+		rows[3] + rows[2], rows[3] - rows[2]
+	};
+
+	size_t count = myEntities.size();
+	size_t ix = 0;
+#ifdef CULLING_SSE
+	// Each plane's coefficients, and their magnitudes for measuring how far a box reaches, four wide
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6], reachX[6], reachY[6], reachZ[6];
+	for (int px = 0; px < 6; px++) {
+		planeX[px] = _mm_set1_ps(planes[px].x);
+		planeY[px] = _mm_set1_ps(planes[px].y);
+		planeZ[px] = _mm_set1_ps(planes[px].z);
+		planeW[px] = _mm_set1_ps(planes[px].w);
+		reachX[px] = _mm_set1_ps(std::fabs(planes[px].x));
+		reachY[px] = _mm_set1_ps(std::fabs(planes[px].y));
+		reachZ[px] = _mm_set1_ps(std::fabs(planes[px].z));
+	}
+
+	// The arrays are padded, so the last group can be loaded whole and the padding ignored afterwards
+	for (; ix < count; ix += 4) {
+		__m128 centerX = _mm_loadu_ps(&myCenterX[ix]);
+		__m128 centerY = _mm_loadu_ps(&myCenterY[ix]);
+		__m128 centerZ = _mm_loadu_ps(&myCenterZ[ix]);
+		__m128 extentX = _mm_loadu_ps(&myExtentX[ix]);
+		__m128 extentY = _mm_loadu_ps(&myExtentY[ix]);
+		__m128 extentZ = _mm_loadu_ps(&myExtentZ[ix]);
+
+		// A box is outside if it is entirely behind any one plane, that is if its centre is further behind the plane
+		// than the box reaches towards it
+		__m128 outside = _mm_setzero_ps();
+		for (int px = 0; px < 6; px++) {
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(planeX[px], centerX), _mm_mul_ps(planeY[px], centerY)),
+				_mm_add_ps(_mm_mul_ps(planeZ[px], centerZ), planeW[px]));
+			__m128 reach = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(reachX[px], extentX), _mm_mul_ps(reachY[px], extentY)),
+				_mm_mul_ps(reachZ[px], extentZ));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+		}
+
+		int mask = _mm_movemask_ps(outside);
+		for (size_t jx = 0; jx < 4 && ix + jx < count; jx++) {
+			if ((mask & (1 << jx)) == 0)
+				visible.push_back(myEntities[ix + jx]);
+		}
+	}
+#endif
+
+	for (; ix < count; ix++) {
+		bool outside = false;
+		for (const glm::vec4& plane : planes) {
+			float distance = plane.x * myCenterX[ix] + plane.y * myCenterY[ix] + plane.z * myCenterZ[ix] + plane.w;
+			float reach = std::fabs(plane.x) * myExtentX[ix] + std::fabs(plane.y) * myExtentY[ix] + std::fabs(plane.z) * myExtentZ[ix];
+			if (distance + reach < 0.0f) {
+				outside = true;
+				break;
+			}
+		}
+		if (!outside)
+			visible.push_back(myEntities[ix]);
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <GLM/glm.hpp>
+#include "florp/game/SceneManager.h"
+#include "florp/game/RenderableComponent.h"
+#include "WorldTransforms.h"
+
+/*
+ * Keeps a world space bounding box for every renderable in a scene, and tests them against view frustums.
+ *
+ * The boxes are stored as separate arrays of centres and half extents, so the frustum test can work through four
+ * renderables at a time with SSE. A renderable's box is only recalculated when its world transform has changed
+ * since the last update, going by its version in WorldTransforms.
+ */
+class FrustumCuller {
+public:
+	// Starts tracking the renderables in the registry, including the ones that already exist
+	void Connect(entt::registry& registry);
+	// Stops tracking, and forgets all the bounds
+	void Disconnect(entt::registry& registry);
+
+	/*
+	 * Recalculates the world bounds of every renderable that has moved, or had its BoundsComponent added
+	 * @param registry The registry that was connected
+	 * @param transforms The world transforms, already updated for this frame
+	 * @returns The number of bounds that were recalculated
+	 */
+	int UpdateBounds(entt::registry& registry, const WorldTransforms& transforms);
+
+	/*
+	 * Finds the renderables whose bounds are at least partly inside a frustum
+	 * @param viewProjection The view projection matrix of the camera or light, the frustum is its clip space
+	 * @param visible Receives the renderables inside the frustum, in no particular order
+	 */
+	void Cull(const glm::mat4& viewProjection, std::vector<entt::entity>& visible) const;
+
+	// How many renderables are tracked
+	size_t GetCount() const { return myEntities.size(); }
+
+private:
+	void OnConstruct(entt::entity entity, entt::registry& registry, const florp::game::RenderableComponent& renderable);
+	void OnDestroy(entt::entity entity, entt::registry& registry);
+	void Add(entt::entity entity);
+	void Resize(size_t count);
+
+	std::vector<entt::entity> myEntities;
+	std::unordered_map<entt::entity, uint32_t> myIndices; // where each entity is in the arrays
+
+	// The world bounds, padded out to a multiple of four so the last group can be loaded whole
+	std::vector<float> myCenterX, myCenterY, myCenterZ;
+	std::vector<float> myExtentX, myExtentY, myExtentZ;
+
+	// The version of the world transform each box was last calculated from, and whether it has to be recalculated regardless
+	std::vector<uint32_t> myVersions;
+	std::vector<uint8_t>  myDirty;
+};
@@ -0,0 +1,295 @@
+#include "GUIDTable.h"
+
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <filesystem>
+
+// Written at the start of cache files, bump the version if the layout changes
+static const char CACHE_MAGIC[4] = { 'G', 'U', 'I', 'D' };
+static const uint32_t CACHE_VERSION = 1;
+
+const uint32_t GUIDTable::EMPTY_BUCKET;
+
+struct CacheHeader
+{
+	char strMagic[4];
+	uint32_t nVersion;
+	uint64_t nSourceSize;     // size of GUIDs.txt when the cache was written
+	int64_t nSourceTime;      // last write time of GUIDs.txt when the cache was written
+	uint32_t nEntryCount;
+	uint32_t nPathBytes;
+};
+
+// Gets the size and last write time of a file, so we can tell if a cache is stale
+static bool GetFileStamp(const std::string& strFileName, uint64_t& nSize, int64_t& nTime)
+{
+	std::error_code error;
+	nSize = (uint64_t)std::filesystem::file_size(strFileName, error);
+	if (error)
+		return false;
+
+	nTime = (int64_t)std::filesystem::last_write_time(strFileName, error).time_since_epoch().count();
+	return !error;
+}
+
+static int HexValue(char c)
+{
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+// Reads nDigits hex digits into nValue, returns false if any of them aren't hex
+static bool ParseHex(const char* strText, int nDigits, uint32_t& nValue)
+{
+	nValue = 0;
+	for (int i = 0; i < nDigits; i++)
+	{
+		int nDigit = HexValue(strText[i]);
+		if (nDigit < 0)
+			return false;
+		nValue = (nValue << 4) | (uint32_t)nDigit;
+	}
+	return true;
+}
+
+GUIDTable::GUIDTable()
+{
+	Clear();
+}
+
+void GUIDTable::Clear()
+{
+	mEntries.clear();
+	mPaths.clear();
+	mBuckets.assign(64, EMPTY_BUCKET);
+}
+
+bool GUIDTable::ParseGUID(const char* strText, size_t nLength, FMOD_GUID& guid)
+{
+	// {04a7b6f2-3e2b-4e10-902f-5a92c9162433}
+	if (nLength != 38 || strText[0] != '{' || strText[37] != '}' ||
+		strText[9] != '-' || strText[14] != '-' || strText[19] != '-' || strText[24] != '-')
+		return false;
+
+	uint32_t nValue;
+	if (!ParseHex(strText + 1, 8, nValue)) return false;
+	guid.Data1 = nValue;
+	if (!ParseHex(strText + 10, 4, nValue)) return false;
+	guid.Data2 = (unsigned short)nValue;
+	if (!ParseHex(strText + 15, 4, nValue)) return false;
+	guid.Data3 = (unsigned short)nValue;
+
+	// The last two groups are just bytes
+	const char* strBytes[8] = { strText + 20, strText + 22, strText + 25, strText + 27, strText + 29, strText + 31, strText + 33, strText + 35 };
+	for (int i = 0; i < 8; i++)
+	{
+		if (!ParseHex(strBytes[i], 2, nValue)) return false;
+		guid.Data4[i] = (unsigned char)nValue;
+	}
+
+	return true;
+}
+
+bool GUIDTable::LoadText(const std::string& strFileName)
+{
+	// Read the whole file in one go
+	std::ifstream guidFile(strFileName, std::ios::binary | std::ios::ate);
+	if (!guidFile.is_open())
+		return false;
+
+	std::vector<char> buffer((size_t)guidFile.tellg());
+	guidFile.seekg(0);
+	guidFile.read(buffer.data(), buffer.size());
+	guidFile.close();
+
+	Clear();
+
+	int nSkipped = 0;
+	const char* pCurrent = buffer.data();
+	const char* pEnd = pCurrent + buffer.size();
+	while (pCurrent < pEnd)
+	{
+		// Format: "{bb98735b-7f42-4b9a-a178-7fe3140e7ea5} event:/Glide"
+		const char* pLineEnd = (const char*)memchr(pCurrent, '\n', pEnd - pCurrent);
+		if (!pLineEnd)
+			pLineEnd = pEnd;
+
+		const char* pLineTrim = pLineEnd;
+		if (pLineTrim > pCurrent && pLineTrim[-1] == '\r')
+			pLineTrim--;
+
+		size_t nLineLength = pLineTrim - pCurrent;
+		if (nLineLength > 0)
+		{
+			FMOD_GUID guid;
+			if (nLineLength > 39 && pCurrent[38] == ' ' && ParseGUID(pCurrent, 38, guid))
+				Add(guid, pCurrent + 39, nLineLength - 39);
+			else
+				nSkipped++;
+		}
+
+		pCurrent = pLineEnd + 1;
+	}
+
+	if (nSkipped > 0)
+		std::cout << "Audio Engine: skipped " << nSkipped << " badly formatted lines in " << strFileName << std::endl;
+
+	return true;
+}
+
+bool GUIDTable::LoadCache(const std::string& strFileName, const std::string& strSourceFileName)
+{
+	uint64_t nSourceSize;
+	int64_t nSourceTime;
+	if (!GetFileStamp(strSourceFileName, nSourceSize, nSourceTime))
+		return false;
+
+	std::ifstream cacheFile(strFileName, std::ios::binary);
+	if (!cacheFile.is_open())
+		return false;
+
+	CacheHeader header;
+	if (!cacheFile.read((char*)&header, sizeof(header)) ||
+		memcmp(header.strMagic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+		header.nVersion != CACHE_VERSION ||
+		header.nSourceSize != nSourceSize ||
+		header.nSourceTime != nSourceTime)
+		return false;
+
+	Clear();
+	mEntries.resize(header.nEntryCount);
+	mPaths.resize(header.nPathBytes);
+	if (!cacheFile.read((char*)mEntries.data(), mEntries.size() * sizeof(Entry)) ||
+		!cacheFile.read(mPaths.data(), mPaths.size()))
+	{
+		Clear();
+		return false;
+	}
+
+	// Make sure nothing points outside the path buffer before we trust it
+	for (const Entry& entry : mEntries)
+	{
+		if ((uint64_t)entry.nPathOffset + entry.nPathLength > mPaths.size())
+		{
+			Clear();
+			return false;
+		}
+	}
+
+	// The hashes are stored, so rebuilding the buckets is cheap
+	size_t nBuckets = 64;
+	while (nBuckets < mEntries.size() * 2)
+		nBuckets <<= 1;
+	Rehash(nBuckets);
+
+	return true;
+}
+
+bool GUIDTable::SaveCache(const std::string& strFileName, const std::string& strSourceFileName) const
+{
+	CacheHeader header;
+	memcpy(header.strMagic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.nVersion = CACHE_VERSION;
+	header.nEntryCount = (uint32_t)mEntries.size();
+	header.nPathBytes = (uint32_t)mPaths.size();
+	if (!GetFileStamp(strSourceFileName, header.nSourceSize, header.nSourceTime))
+		return false;
+
+	std::ofstream cacheFile(strFileName, std::ios::binary | std::ios::trunc);
+	if (!cacheFile.is_open())
+		return false;
+
+	cacheFile.write((const char*)&header, sizeof(header));
+	cacheFile.write((const char*)mEntries.data(), mEntries.size() * sizeof(Entry));
+	cacheFile.write(mPaths.data(), mPaths.size());
+	return cacheFile.good();
+}
+
+const FMOD_GUID* GUIDTable::Find(const char* strPrefix, const std::string& strPath) const
+{
+	// Hash and compare the two halves separately so we don't have to join them
+	size_t nPrefixLength = strlen(strPrefix);
+	uint64_t nHash = Hash(strPath.data(), strPath.length(), Hash(strPrefix, nPrefixLength));
+	size_t nLength = nPrefixLength + strPath.length();
+
+	size_t nMask = mBuckets.size() - 1;
+	for (size_t nBucket = (size_t)nHash & nMask; mBuckets[nBucket] != EMPTY_BUCKET; nBucket = (nBucket + 1) & nMask)
+	{
+		const Entry& entry = mEntries[mBuckets[nBucket]];
+		if (entry.nHash != nHash || entry.nPathLength != nLength)
+			continue;
+
+		const char* strEntryPath = mPaths.data() + entry.nPathOffset;
+		if (memcmp(strEntryPath, strPrefix, nPrefixLength) == 0 &&
+			memcmp(strEntryPath + nPrefixLength, strPath.data(), strPath.length()) == 0)
+			return &entry.guid;
+	}
+
+	return NULL;
+}
+
+const FMOD_GUID* GUIDTable::Find(const std::string& strPath) const
+{
+	return Find("", strPath);
+}
+
+void GUIDTable::Add(const FMOD_GUID& guid, const char* strPath, size_t nLength)
+{
+	uint64_t nHash = Hash(strPath, nLength);
+
+	// Find the path's bucket, later lines win if it's already in the table
+	size_t nMask = mBuckets.size() - 1;
+	size_t nBucket = (size_t)nHash & nMask;
+	for (; mBuckets[nBucket] != EMPTY_BUCKET; nBucket = (nBucket + 1) & nMask)
+	{
+		Entry& existing = mEntries[mBuckets[nBucket]];
+		if (existing.nHash == nHash && existing.nPathLength == nLength &&
+			memcmp(mPaths.data() + existing.nPathOffset, strPath, nLength) == 0)
+		{
+			existing.guid = guid;
+			return;
+		}
+	}
+
+	Entry entry;
+	entry.guid = guid;
+	entry.nHash = nHash;
+	entry.nPathOffset = (uint32_t)mPaths.size();
+	entry.nPathLength = (uint32_t)nLength;
+	mPaths.insert(mPaths.end(), strPath, strPath + nLength);
+	mEntries.push_back(entry);
+
+	// Keep the table at most half full so probe chains stay short
+	if (mEntries.size() * 2 > mBuckets.size())
+		Rehash(mBuckets.size() * 2);
+	else
+		mBuckets[nBucket] = (uint32_t)(mEntries.size() - 1);
+}
+
+void GUIDTable::Rehash(size_t nBuckets)
+{
+	mBuckets.assign(nBuckets, EMPTY_BUCKET);
+	size_t nMask = nBuckets - 1;
+
+	for (size_t i = 0; i < mEntries.size(); i++)
+	{
+		size_t nBucket = (size_t)mEntries[i].nHash & nMask;
+		while (mBuckets[nBucket] != EMPTY_BUCKET)
+			nBucket = (nBucket + 1) & nMask;
+		mBuckets[nBucket] = (uint32_t)i;
+	}
+}
+
+uint64_t GUIDTable::Hash(const char* strText, size_t nLength, uint64_t nHash)
+{
+	// FNV-1a, can be continued across several strings by passing the last hash back in
+	for (size_t i = 0; i < nLength; i++)
+	{
+		nHash ^= (unsigned char)strText[i];
+		nHash *= 1099511628211ULL;
+	}
+	return nHash;
+}
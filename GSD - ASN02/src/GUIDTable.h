@@ -0,0 +1,58 @@
+#pragma once
+
+// FMOD
+#include "fmod_common.h"
+
+// Standard Library
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+ * Maps FMOD paths (event:/, bus:/, bank:/, ...) to their GUIDs. The GUIDs are parsed once when the table
+ * is loaded, and stored in an open addressing hash table with all the paths packed into one buffer, so
+ * lookups never allocate and FMOD never has to parse a GUID string again.
+ */
+class GUIDTable
+{
+public:
+	GUIDTable();
+
+	// Parses a GUIDs.txt file exported from FMOD Studio. Lines that aren't "{guid} path" are skipped.
+	bool LoadText(const std::string& strFileName);
+
+	// Loads a cache written by SaveCache, fails if the cache is missing, corrupt, or older than strSourceFileName
+	bool LoadCache(const std::string& strFileName, const std::string& strSourceFileName);
+	bool SaveCache(const std::string& strFileName, const std::string& strSourceFileName) const;
+
+	// Looks up strPrefix + strPath (ie. "event:/" + "Car Crash"), returns NULL if it isn't in the table
+	const FMOD_GUID* Find(const char* strPrefix, const std::string& strPath) const;
+	const FMOD_GUID* Find(const std::string& strPath) const;
+
+	// Adds a single path, replacing its GUID if it is already in the table
+	void Add(const FMOD_GUID& guid, const char* strPath, size_t nLength);
+
+	size_t Size() const { return mEntries.size(); }
+	void Clear();
+
+	// Parses "{xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx}", returns false if it isn't a GUID
+	static bool ParseGUID(const char* strText, size_t nLength, FMOD_GUID& guid);
+
+private:
+	struct Entry
+	{
+		FMOD_GUID guid;
+		uint64_t nHash;
+		uint32_t nPathOffset; // into mPaths
+		uint32_t nPathLength;
+	};
+
+	static const uint32_t EMPTY_BUCKET = 0xFFFFFFFF;
+
+	void Rehash(size_t nBuckets);
+	static uint64_t Hash(const char* strText, size_t nLength, uint64_t nHash = 14695981039346656037ULL);
+
+	std::vector<Entry> mEntries;
+	std::vector<uint32_t> mBuckets; // indices into mEntries, power of two sized, never more than half full
+	std::vector<char> mPaths;
+};
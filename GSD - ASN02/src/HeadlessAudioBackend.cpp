@@ -0,0 +1,1165 @@
+#include "HeadlessAudioBackend.h"
+
+#include <cstring>
+#include <math.h>
+#include <algorithm>
+
+static const float PI = 3.14159265f;
+static const float SPEED_OF_SOUND = 343.0f; // metres per second, FMOD's default doppler scale
+static const float TONE_LEVEL = 0.25f;      // so a few events at full volume don't clip
+// The low pass an Occlusion parameter sweeps through, from fully open down to heavily muffled
+static const float OPEN_CUTOFF = 20000.0f;
+static const float OCCLUDED_CUTOFF = 150.0f; // below the test tones, so blocked ones come out clearly quieter
+
+static float Dot(const FMOD_VECTOR& a, const FMOD_VECTOR& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+static FMOD_VECTOR Subtract(const FMOD_VECTOR& a, const FMOD_VECTOR& b)
+{
+	FMOD_VECTOR result = { a.x - b.x, a.y - b.y, a.z - b.z };
+	return result;
+}
+
+static FMOD_VECTOR Cross(const FMOD_VECTOR& a, const FMOD_VECTOR& b)
+{
+	FMOD_VECTOR result = { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	return result;
+}
+
+// Little endian, whatever the machine is
+static void WriteUInt(std::ofstream& file, uint32_t nValue, int nBytes)
+{
+	for (int i = 0; i < nBytes; i++)
+	{
+		file.put((char)(nValue & 0xFF));
+		nValue >>= 8;
+	}
+}
+
+HeadlessAudioBackend::HeadlessAudioBackend()
+{
+	memset(mListeners, 0, sizeof(mListeners));
+	for (FMOD_3D_ATTRIBUTES& listener : mListeners)
+	{
+		listener.forward.z = 1.0f;
+		listener.up.y = 1.0f;
+	}
+	mnListeners = 1;
+
+	mfUpdateStep = 1.0f / 60.0f;
+	mfTime = 0.0f;
+	mnLoadUpdates = 2;
+	mfSoundLength = 1.0f;
+	mnCallCount = 0;
+
+	mnSampleRate = 48000;
+	mfFramesOwed = 0.0f;
+	mnRenderedFrames = 0;
+}
+
+HeadlessAudioBackend::~HeadlessAudioBackend()
+{
+	CloseOutputFile();
+}
+
+
+//////// Setup ////////
+
+void HeadlessAudioBackend::AddEvent(const FMOD_GUID& guid, const HeadlessEventInfo& info)
+{
+	std::unique_ptr<Description> description(new Description());
+	description->guid = guid;
+	description->info = info;
+	description->bAnyParameter = false;
+	description->nID = (uint32_t)mDescriptions.size() + 1;
+	for (auto& parameter : info.Parameters)
+	{
+		description->ParameterNames.push_back(parameter.first);
+	}
+	description->bSamplesRequested = false;
+	description->nSampleUpdatesLeft = 0;
+	description->nInstances = 0;
+	mDescriptions.push_back(std::move(description));
+}
+
+bool HeadlessAudioBackend::GetAttributes(BackendEventInstance* pInstance, FMOD_3D_ATTRIBUTES* pAttributes) const
+{
+	Instance* pFound = Get(pInstance);
+	if (!pFound)
+		return false;
+
+	*pAttributes = pFound->attributes;
+	return true;
+}
+
+bool HeadlessAudioBackend::IsPaused(BackendEventInstance* pInstance) const
+{
+	Instance* pFound = Get(pInstance);
+	return pFound && pFound->bPaused;
+}
+
+size_t HeadlessAudioBackend::GetResidentSampleBytes() const
+{
+	size_t nBytes = 0;
+	for (const std::unique_ptr<Description>& description : mDescriptions)
+	{
+		if (description->bSamplesRequested || description->nInstances > 0)
+			nBytes += description->info.nSampleBytes;
+	}
+
+	return nBytes;
+}
+
+
+//////// Output ////////
+
+bool HeadlessAudioBackend::OpenOutputFile(const char* strFileName, int nSampleRate)
+{
+	CloseOutputFile();
+
+	mOutput.open(strFileName, std::ios::binary | std::ios::trunc);
+	if (!mOutput)
+		return false;
+
+	mnSampleRate = nSampleRate;
+	mfFramesOwed = 0.0f;
+	mnRenderedFrames = 0;
+
+	// The sizes are filled in when the file is closed
+	mOutput.write("RIFF", 4);
+	WriteUInt(mOutput, 0, 4);
+	mOutput.write("WAVEfmt ", 8);
+	WriteUInt(mOutput, 16, 4);                   // format chunk size
+	WriteUInt(mOutput, 1, 2);                    // PCM
+	WriteUInt(mOutput, 2, 2);                    // channels
+	WriteUInt(mOutput, nSampleRate, 4);
+	WriteUInt(mOutput, nSampleRate * 2 * 2, 4);  // bytes per second
+	WriteUInt(mOutput, 2 * 2, 2);                // bytes per frame
+	WriteUInt(mOutput, 16, 2);                   // bits per sample
+	mOutput.write("data", 4);
+	WriteUInt(mOutput, 0, 4);
+	return (bool)mOutput;
+}
+
+void HeadlessAudioBackend::CloseOutputFile()
+{
+	if (!mOutput.is_open())
+		return;
+
+	uint32_t nDataBytes = (uint32_t)(mnRenderedFrames * 2 * 2);
+	mOutput.seekp(4);
+	WriteUInt(mOutput, 36 + nDataBytes, 4);
+	mOutput.seekp(40);
+	WriteUInt(mOutput, nDataBytes, 4);
+	mOutput.close();
+}
+
+float HeadlessAudioBackend::GetRolloffGain(const HeadlessEventInfo& info, float fDistance)
+{
+	// Inverse rolloff, the same as FMOD's default
+	if (fDistance > info.fMaxDistance)
+		return 0.0f;
+	if (fDistance <= info.fMinDistance)
+		return 1.0f;
+	return info.fMinDistance / fDistance;
+}
+
+void HeadlessAudioBackend::Mix()
+{
+	mfFramesOwed += mfUpdateStep * mnSampleRate;
+	int nFrames = (int)mfFramesOwed;
+	mfFramesOwed -= nFrames;
+	if (nFrames <= 0)
+		return;
+
+	mMixBuffer.assign(nFrames * 2, 0.0f);
+
+	const FMOD_3D_ATTRIBUTES& listener = mListeners[0];
+	FMOD_VECTOR right = Cross(listener.forward, listener.up);
+	for (Instance* pInstance : mPlaying)
+	{
+		Instance& instance = *pInstance;
+		if (instance.bPaused || instance.eState == FMOD_STUDIO_PLAYBACK_STARTING)
+			continue;
+
+		const HeadlessEventInfo& info = instance.pDescription->info;
+		float fGain = 1.0f;
+		float fPan = 0.0f;   // -1 is hard left, 1 is hard right
+		float fPitch = 1.0f;
+		if (info.b3D)
+		{
+			FMOD_VECTOR offset = Subtract(instance.attributes.position, listener.position);
+			float fDistance = sqrtf(Dot(offset, offset));
+			fGain = GetRolloffGain(info, fDistance);
+			if (fDistance > 0.0f)
+			{
+				fPan = Dot(offset, right) / fDistance;
+
+				// Both speeds are along the line between them, positive when moving apart
+				float fSourceSpeed = Dot(instance.attributes.velocity, offset) / fDistance;
+				float fListenerSpeed = -Dot(listener.velocity, offset) / fDistance;
+				fPitch = (SPEED_OF_SOUND - fListenerSpeed) / (SPEED_OF_SOUND + fSourceSpeed);
+				fPitch = std::min(std::max(fPitch, 0.5f), 2.0f);
+			}
+		}
+		if (instance.eState == FMOD_STUDIO_PLAYBACK_STOPPING && info.fFadeOutTime > 0.0f)
+			fGain *= std::max(instance.fFadeRemaining, 0.0f) / info.fFadeOutTime;
+
+		float fFrequency = info.fToneFrequency > 0.0f ? info.fToneFrequency :
+			220.0f * powf(2.0f, (float)((instance.pDescription->nID - 1) % 12) / 12.0f);
+
+		// A one pole low pass only changes a pure tone's level, so the filter comes down to its gain at the tone
+		auto tOcclusion = instance.Parameters.find("Occlusion");
+		if (tOcclusion != instance.Parameters.end() && tOcclusion->second > 0.0f)
+		{
+			float fOcclusion = std::min(tOcclusion->second, 1.0f);
+			float fCutoff = OPEN_CUTOFF * powf(OCCLUDED_CUTOFF / OPEN_CUTOFF, fOcclusion);
+			fGain /= sqrtf(1.0f + (fFrequency / fCutoff) * (fFrequency / fCutoff));
+		}
+
+		// Constant power pan
+		float fAngle = (fPan + 1.0f) * 0.25f * PI;
+		float fLeftGain = fGain * cosf(fAngle) * TONE_LEVEL;
+		float fRightGain = fGain * sinf(fAngle) * TONE_LEVEL;
+		float fPhaseStep = 2.0f * PI * fFrequency * fPitch / mnSampleRate;
+		for (int i = 0; i < nFrames; i++)
+		{
+			float fRamp = (float)(i + 1) / nFrames;
+			float fSample = sinf(instance.fPhase);
+			mMixBuffer[i * 2] += fSample * (instance.fLeftGain + (fLeftGain - instance.fLeftGain) * fRamp);
+			mMixBuffer[i * 2 + 1] += fSample * (instance.fRightGain + (fRightGain - instance.fRightGain) * fRamp);
+
+			instance.fPhase += fPhaseStep;
+			if (instance.fPhase > 2.0f * PI)
+				instance.fPhase -= 2.0f * PI;
+		}
+		instance.fLeftGain = fLeftGain;
+		instance.fRightGain = fRightGain;
+	}
+
+	// 16 bit little endian, written in one go
+	mOutputBuffer.resize(nFrames * 2 * 2);
+	for (int i = 0; i < nFrames * 2; i++)
+	{
+		float fSample = std::min(std::max(mMixBuffer[i], -1.0f), 1.0f);
+		uint16_t nSample = (uint16_t)(int16_t)lrintf(fSample * 32767.0f);
+		mOutputBuffer[i * 2] = (char)(nSample & 0xFF);
+		mOutputBuffer[i * 2 + 1] = (char)(nSample >> 8);
+	}
+	mOutput.write(mOutputBuffer.data(), mOutputBuffer.size());
+	mnRenderedFrames += nFrames;
+}
+
+
+//////// Objects ////////
+
+HeadlessAudioBackend::Bank* HeadlessAudioBackend::Get(BackendBank* pBank) const
+{
+	Bank* pFound = reinterpret_cast<Bank*>(pBank);
+	if (!pFound || pFound->bUnloaded)
+		return NULL;
+
+	return pFound;
+}
+
+HeadlessAudioBackend::Description* HeadlessAudioBackend::Get(BackendEventDescription* pDescription) const
+{
+	return reinterpret_cast<Description*>(pDescription);
+}
+
+HeadlessAudioBackend::Instance* HeadlessAudioBackend::Get(BackendEventInstance* pInstance) const
+{
+	Instance* pFound = reinterpret_cast<Instance*>(pInstance);
+	if (!pFound || !pFound->pDescription)
+		return NULL;
+
+	return pFound;
+}
+
+void HeadlessAudioBackend::SetStopped(Instance& instance)
+{
+	if (instance.eState == FMOD_STUDIO_PLAYBACK_STOPPED)
+		return;
+
+	instance.eState = FMOD_STUDIO_PLAYBACK_STOPPED;
+
+	// Swap remove from the playing list
+	Instance* pLast = mPlaying.back();
+	mPlaying[instance.nPlayingIndex] = pLast;
+	pLast->nPlayingIndex = instance.nPlayingIndex;
+	mPlaying.pop_back();
+}
+
+HeadlessAudioBackend::Sound* HeadlessAudioBackend::Get(BackendSound* pSound) const
+{
+	Sound* pFound = reinterpret_cast<Sound*>(pSound);
+	if (!pFound || pFound->bReleased)
+		return NULL;
+
+	return pFound;
+}
+
+HeadlessAudioBackend::Channel* HeadlessAudioBackend::Get(BackendChannel* pChannel) const
+{
+	Channel* pFound = reinterpret_cast<Channel*>(pChannel);
+	if (!pFound || !pFound->pSound)
+		return NULL;
+
+	return pFound;
+}
+
+void HeadlessAudioBackend::EndChannel(Channel& channel)
+{
+	mEndedChannels.push_back(channel.nId);
+	channel.pSound = NULL;
+	mFreeChannels.push_back(&channel);
+
+	Channel* pLast = mPlayingChannels.back();
+	mPlayingChannels[channel.nPlayingIndex] = pLast;
+	pLast->nPlayingIndex = channel.nPlayingIndex;
+	mPlayingChannels.pop_back();
+}
+
+FMOD_RESULT HeadlessAudioBackend::DescribeParameter(std::vector<std::string>& names, const char* strName, bool bAddMissing, uint32_t nOwnerID,
+	float fDefault, FMOD_STUDIO_PARAMETER_DESCRIPTION* pParameter)
+{
+	if (!strName || !pParameter)
+		return FMOD_ERR_INVALID_PARAM;
+
+	size_t nIndex = 0;
+	while (nIndex < names.size() && names[nIndex] != strName)
+		nIndex++;
+
+	if (nIndex == names.size())
+	{
+		if (!bAddMissing)
+			return FMOD_ERR_EVENT_NOTFOUND;
+		names.push_back(strName);
+	}
+
+	memset(pParameter, 0, sizeof(FMOD_STUDIO_PARAMETER_DESCRIPTION));
+	pParameter->name = names[nIndex].c_str();
+	pParameter->id.data1 = (unsigned int)nIndex + 1;
+	pParameter->id.data2 = nOwnerID;
+	pParameter->minimum = -1e6f;
+	pParameter->maximum = 1e6f;
+	pParameter->defaultvalue = fDefault;
+	return FMOD_OK;
+}
+
+bool HeadlessAudioBackend::IsInBank(const Description& description, const Bank& bank)
+{
+	// Compare against the file name without the folder and extension, "Desktop/Master.bank" is "Master"
+	size_t nStart = bank.strFileName.find_last_of("/\\");
+	nStart = (nStart == std::string::npos) ? 0 : nStart + 1;
+	size_t nEnd = bank.strFileName.rfind(".bank");
+	if (nEnd == std::string::npos || nEnd < nStart)
+		nEnd = bank.strFileName.size();
+
+	return bank.strFileName.compare(nStart, nEnd - nStart, description.info.strBank) == 0;
+}
+
+bool HeadlessAudioBackend::IsAnyBankLoaded() const
+{
+	for (const std::unique_ptr<Bank>& bank : mBanks)
+	{
+		if (!bank->bUnloaded && bank->nUpdatesLeft == 0)
+			return true;
+	}
+
+	return false;
+}
+
+
+//////// System ////////
+
+FMOD_RESULT HeadlessAudioBackend::Update()
+{
+	mnCallCount++;
+
+	// The step that just went by is heard as things were at the start of it
+	if (mOutput.is_open())
+		Mix();
+
+	mfTime += mfUpdateStep;
+
+	// Loading
+	for (std::unique_ptr<Bank>& bank : mBanks)
+	{
+		if (bank->nUpdatesLeft > 0)
+			bank->nUpdatesLeft--;
+	}
+	for (std::unique_ptr<Description>& description : mDescriptions)
+	{
+		if (description->bSamplesRequested && description->nSampleUpdatesLeft > 0)
+			description->nSampleUpdatesLeft--;
+	}
+
+	// Playback, walk backwards since stopping swap removes
+	for (size_t i = mPlaying.size(); i-- > 0;)
+	{
+		Instance& instance = *mPlaying[i];
+		switch (instance.eState)
+		{
+		case FMOD_STUDIO_PLAYBACK_STARTING:
+			// Like FMOD, an instance starts playing on the update after start is called
+			instance.eState = FMOD_STUDIO_PLAYBACK_PLAYING;
+			break;
+		case FMOD_STUDIO_PLAYBACK_PLAYING:
+			if (instance.bPaused)
+				break;
+
+			instance.fPosition += mfUpdateStep;
+			if (instance.pDescription->info.fLength > 0.0f && instance.fPosition >= instance.pDescription->info.fLength)
+				SetStopped(instance);
+			break;
+		case FMOD_STUDIO_PLAYBACK_STOPPING:
+			if (instance.bPaused)
+				break;
+
+			instance.fFadeRemaining -= mfUpdateStep;
+			if (instance.fFadeRemaining <= 0.0f)
+				SetStopped(instance);
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Channels
+	for (size_t i = mPlayingChannels.size(); i-- > 0;)
+	{
+		Channel& channel = *mPlayingChannels[i];
+		if (!channel.bStopped && !channel.bPaused && !(channel.pSound->mode & FMOD_LOOP_NORMAL))
+		{
+			channel.fPosition += mfUpdateStep;
+			channel.bStopped = channel.fPosition >= mfSoundLength;
+		}
+
+		if (channel.bStopped)
+			EndChannel(channel);
+	}
+
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::UnloadAll()
+{
+	mnCallCount++;
+
+	// Unloading the banks takes everything that came from them along too
+	for (std::unique_ptr<Instance>& instance : mInstances)
+	{
+		if (instance->pDescription)
+			Release(reinterpret_cast<BackendEventInstance*>(instance.get()));
+	}
+	for (std::unique_ptr<Description>& description : mDescriptions)
+	{
+		description->bSamplesRequested = false;
+		description->nSampleUpdatesLeft = 0;
+	}
+	for (std::unique_ptr<Bank>& bank : mBanks)
+	{
+		bank->bUnloaded = true;
+	}
+
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::SetNumListeners(int nListeners)
+{
+	mnCallCount++;
+	if (nListeners < 1 || nListeners > FMOD_MAX_LISTENERS)
+		return FMOD_ERR_INVALID_PARAM;
+
+	mnListeners = nListeners;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::SetListenerAttributes(int nListener, const FMOD_3D_ATTRIBUTES& attributes)
+{
+	mnCallCount++;
+	if (nListener < 0 || nListener >= mnListeners)
+		return FMOD_ERR_INVALID_PARAM;
+
+	mListeners[nListener] = attributes;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::SetParameterByName(const char* strName, float fValue)
+{
+	mnCallCount++;
+	mGlobalParameters[strName] = fValue;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::GetParameterDescriptionByName(const char* strName, FMOD_STUDIO_PARAMETER_DESCRIPTION* pParameter)
+{
+	mnCallCount++;
+
+	// Any global parameter exists, we don't have a project to check against
+	return DescribeParameter(mGlobalParameterNames, strName, true, 0, 0.0f, pParameter);
+}
+
+FMOD_RESULT HeadlessAudioBackend::SetParametersByIDs(const FMOD_STUDIO_PARAMETER_ID* pIDs, float* pValues, int nCount)
+{
+	mnCallCount++;
+	if (!pIDs || !pValues)
+		return FMOD_ERR_INVALID_PARAM;
+
+	for (int i = 0; i < nCount; i++)
+	{
+		if (pIDs[i].data2 != 0 || pIDs[i].data1 == 0 || pIDs[i].data1 > mGlobalParameterNames.size())
+			return FMOD_ERR_EVENT_NOTFOUND;
+
+		mGlobalParameters[mGlobalParameterNames[pIDs[i].data1 - 1]] = pValues[i];
+	}
+	return FMOD_OK;
+}
+
+
+//////// Banks ////////
+
+FMOD_RESULT HeadlessAudioBackend::LoadBankFile(const char* strFileName, FMOD_STUDIO_LOAD_BANK_FLAGS flags, BackendBank** ppBank)
+{
+	mnCallCount++;
+	*ppBank = NULL;
+
+	for (const std::unique_ptr<Bank>& bank : mBanks)
+	{
+		if (!bank->bUnloaded && bank->strFileName == strFileName)
+			return FMOD_ERR_EVENT_ALREADY_LOADED;
+	}
+
+	std::unique_ptr<Bank> bank(new Bank());
+	bank->strFileName = strFileName;
+	bank->nUpdatesLeft = (flags & FMOD_STUDIO_LOAD_BANK_NONBLOCKING) ? mnLoadUpdates : 0;
+	bank->bUnloaded = false;
+
+	*ppBank = reinterpret_cast<BackendBank*>(bank.get());
+	mBanks.push_back(std::move(bank));
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::GetLoadingState(BackendBank* pBank, FMOD_STUDIO_LOADING_STATE* pState)
+{
+	mnCallCount++;
+	Bank* pFound = Get(pBank);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+	if (!pState)
+		return FMOD_ERR_INVALID_PARAM;
+
+	*pState = pFound->nUpdatesLeft > 0 ? FMOD_STUDIO_LOADING_STATE_LOADING : FMOD_STUDIO_LOADING_STATE_LOADED;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::GetEventCount(BackendBank* pBank, int* pCount)
+{
+	return GetEventList(pBank, NULL, 0, pCount);
+}
+
+FMOD_RESULT HeadlessAudioBackend::GetEventList(BackendBank* pBank, BackendEventDescription** ppDescriptions, int nCapacity, int* pCount)
+{
+	mnCallCount++;
+	Bank* pFound = Get(pBank);
+	if (!pFound || pFound->nUpdatesLeft > 0)
+		return FMOD_ERR_INVALID_HANDLE;
+	if (!pCount)
+		return FMOD_ERR_INVALID_PARAM;
+
+	// Only events we were told about are listed, made up ones aren't really in any bank
+	int nCount = 0;
+	for (const std::unique_ptr<Description>& description : mDescriptions)
+	{
+		if (description->bAnyParameter || !IsInBank(*description, *pFound))
+			continue;
+
+		if (ppDescriptions && nCount < nCapacity)
+			ppDescriptions[nCount] = reinterpret_cast<BackendEventDescription*>(description.get());
+		nCount++;
+	}
+
+	*pCount = ppDescriptions ? std::min(nCount, nCapacity) : nCount;
+	return FMOD_OK;
+}
+
+
+//////// Event Descriptions ////////
+
+FMOD_RESULT HeadlessAudioBackend::GetEventByID(const FMOD_GUID* pGUID, BackendEventDescription** ppDescription)
+{
+	mnCallCount++;
+	*ppDescription = NULL;
+
+	if (!IsAnyBankLoaded())
+		return FMOD_ERR_EVENT_NOTFOUND;
+
+	Description* pFound = NULL;
+	for (std::unique_ptr<Description>& description : mDescriptions)
+	{
+		if (memcmp(&description->guid, pGUID, sizeof(FMOD_GUID)) == 0)
+		{
+			pFound = description.get();
+			break;
+		}
+	}
+
+	// Make up an event for GUIDs we weren't told about, so the game can run against a real GUIDs.txt
+	if (!pFound)
+	{
+		AddEvent(*pGUID, mDefaultEventInfo);
+		pFound = mDescriptions.back().get();
+		pFound->bAnyParameter = true;
+	}
+
+	*ppDescription = reinterpret_cast<BackendEventDescription*>(pFound);
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::Is3D(BackendEventDescription* pDescription, bool* pIs3D)
+{
+	mnCallCount++;
+	Description* pFound = Get(pDescription);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+	if (!pIs3D)
+		return FMOD_ERR_INVALID_PARAM;
+
+	*pIs3D = pFound->info.b3D;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::GetMinimumDistance(BackendEventDescription* pDescription, float* pDistance)
+{
+	mnCallCount++;
+	Description* pFound = Get(pDescription);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+	if (!pDistance)
+		return FMOD_ERR_INVALID_PARAM;
+
+	*pDistance = pFound->info.fMinDistance;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::GetMaximumDistance(BackendEventDescription* pDescription, float* pDistance)
+{
+	mnCallCount++;
+	Description* pFound = Get(pDescription);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+	if (!pDistance)
+		return FMOD_ERR_INVALID_PARAM;
+
+	*pDistance = pFound->info.fMaxDistance;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::GetLength(BackendEventDescription* pDescription, int* pLength)
+{
+	mnCallCount++;
+	Description* pFound = Get(pDescription);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+	if (!pLength)
+		return FMOD_ERR_INVALID_PARAM;
+
+	*pLength = (int)(pFound->info.fLength * 1000.0f);
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::IsStream(BackendEventDescription* pDescription, bool* pIsStream)
+{
+	mnCallCount++;
+	Description* pFound = Get(pDescription);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+	if (!pIsStream)
+		return FMOD_ERR_INVALID_PARAM;
+
+	*pIsStream = pFound->info.bStream;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::LoadSampleData(BackendEventDescription* pDescription)
+{
+	mnCallCount++;
+	Description* pFound = Get(pDescription);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+
+	if (!pFound->bSamplesRequested)
+	{
+		pFound->bSamplesRequested = true;
+		pFound->nSampleUpdatesLeft = mnLoadUpdates;
+	}
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::UnloadSampleData(BackendEventDescription* pDescription)
+{
+	mnCallCount++;
+	Description* pFound = Get(pDescription);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+	if (!pFound->bSamplesRequested)
+		return FMOD_ERR_STUDIO_NOT_LOADED;
+
+	pFound->bSamplesRequested = false;
+	pFound->nSampleUpdatesLeft = 0;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::GetSampleLoadingState(BackendEventDescription* pDescription, FMOD_STUDIO_LOADING_STATE* pState)
+{
+	mnCallCount++;
+	Description* pFound = Get(pDescription);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+	if (!pState)
+		return FMOD_ERR_INVALID_PARAM;
+
+	// Like FMOD, live instances keep the sample data loaded without it being asked for
+	if (!pFound->bSamplesRequested)
+		*pState = pFound->nInstances > 0 ? FMOD_STUDIO_LOADING_STATE_LOADED : FMOD_STUDIO_LOADING_STATE_UNLOADED;
+	else if (pFound->nSampleUpdatesLeft > 0)
+		*pState = FMOD_STUDIO_LOADING_STATE_LOADING;
+	else
+		*pState = FMOD_STUDIO_LOADING_STATE_LOADED;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::CreateInstance(BackendEventDescription* pDescription, BackendEventInstance** ppInstance)
+{
+	mnCallCount++;
+	*ppInstance = NULL;
+
+	Description* pFound = Get(pDescription);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+
+	// Reuse a released instance if we have one
+	Instance* pInstance;
+	if (!mFreeInstances.empty())
+	{
+		pInstance = mFreeInstances.back();
+		mFreeInstances.pop_back();
+	}
+	else
+	{
+		mInstances.push_back(std::unique_ptr<Instance>(new Instance()));
+		pInstance = mInstances.back().get();
+	}
+
+	pInstance->pDescription = pFound;
+	pInstance->eState = FMOD_STUDIO_PLAYBACK_STOPPED;
+	pInstance->bPaused = false;
+	pInstance->fPosition = 0.0f;
+	pInstance->fFadeRemaining = 0.0f;
+	memset(&pInstance->attributes, 0, sizeof(pInstance->attributes));
+	pInstance->attributes.forward.z = 1.0f;
+	pInstance->attributes.up.y = 1.0f;
+	pInstance->Parameters = pFound->info.Parameters;
+	pInstance->nPlayingIndex = 0;
+	pInstance->fPhase = 0.0f;
+	pInstance->fLeftGain = 0.0f;
+	pInstance->fRightGain = 0.0f;
+	pFound->nInstances++;
+
+	*ppInstance = reinterpret_cast<BackendEventInstance*>(pInstance);
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::GetParameterDescriptionByName(BackendEventDescription* pDescription, const char* strName, FMOD_STUDIO_PARAMETER_DESCRIPTION* pParameter)
+{
+	mnCallCount++;
+	Description* pFound = Get(pDescription);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+
+	float fDefault = 0.0f;
+	auto tFoundIt = strName ? pFound->info.Parameters.find(strName) : pFound->info.Parameters.end();
+	if (tFoundIt != pFound->info.Parameters.end())
+		fDefault = tFoundIt->second;
+
+	return DescribeParameter(pFound->ParameterNames, strName, pFound->bAnyParameter, pFound->nID, fDefault, pParameter);
+}
+
+
+//////// Event Instances ////////
+
+FMOD_RESULT HeadlessAudioBackend::Start(BackendEventInstance* pInstance)
+{
+	mnCallCount++;
+	Instance* pFound = Get(pInstance);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+
+	// Starting an instance that is already playing restarts it
+	if (pFound->eState == FMOD_STUDIO_PLAYBACK_STOPPED)
+	{
+		pFound->nPlayingIndex = mPlaying.size();
+		mPlaying.push_back(pFound);
+	}
+
+	pFound->eState = FMOD_STUDIO_PLAYBACK_STARTING;
+	pFound->fPosition = 0.0f;
+	pFound->fPhase = 0.0f;
+	pFound->fLeftGain = 0.0f;
+	pFound->fRightGain = 0.0f;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::Stop(BackendEventInstance* pInstance, FMOD_STUDIO_STOP_MODE eMode)
+{
+	mnCallCount++;
+	Instance* pFound = Get(pInstance);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+
+	if (pFound->eState == FMOD_STUDIO_PLAYBACK_STOPPED || pFound->eState == FMOD_STUDIO_PLAYBACK_STOPPING)
+	{
+		if (eMode == FMOD_STUDIO_STOP_IMMEDIATE)
+			SetStopped(*pFound);
+		return FMOD_OK;
+	}
+
+	if (eMode == FMOD_STUDIO_STOP_ALLOWFADEOUT && pFound->pDescription->info.fFadeOutTime > 0.0f)
+	{
+		pFound->eState = FMOD_STUDIO_PLAYBACK_STOPPING;
+		pFound->fFadeRemaining = pFound->pDescription->info.fFadeOutTime;
+	}
+	else
+	{
+		SetStopped(*pFound);
+	}
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::Release(BackendEventInstance* pInstance)
+{
+	mnCallCount++;
+	Instance* pFound = Get(pInstance);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+
+	// FMOD lets released instances finish playing, we don't play anything so just stop them
+	SetStopped(*pFound);
+	pFound->pDescription->nInstances--;
+	pFound->pDescription = NULL;
+	pFound->Parameters.clear();
+	mFreeInstances.push_back(pFound);
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::SetPaused(BackendEventInstance* pInstance, bool bPaused)
+{
+	mnCallCount++;
+	Instance* pFound = Get(pInstance);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+
+	pFound->bPaused = bPaused;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::GetPlaybackState(BackendEventInstance* pInstance, FMOD_STUDIO_PLAYBACK_STATE* pState)
+{
+	mnCallCount++;
+	Instance* pFound = Get(pInstance);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+	if (!pState)
+		return FMOD_ERR_INVALID_PARAM;
+
+	*pState = pFound->eState;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::GetTimelinePosition(BackendEventInstance* pInstance, int* pPosition)
+{
+	mnCallCount++;
+	Instance* pFound = Get(pInstance);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+	if (!pPosition)
+		return FMOD_ERR_INVALID_PARAM;
+
+	*pPosition = (int)(pFound->fPosition * 1000.0f);
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::Set3DAttributes(BackendEventInstance* pInstance, const FMOD_3D_ATTRIBUTES& attributes)
+{
+	mnCallCount++;
+	Instance* pFound = Get(pInstance);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+
+	pFound->attributes = attributes;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::GetAudibility(BackendEventInstance* pInstance, float* pAudibility)
+{
+	mnCallCount++;
+	Instance* pFound = Get(pInstance);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+	if (!pAudibility)
+		return FMOD_ERR_INVALID_PARAM;
+
+	if (pFound->eState == FMOD_STUDIO_PLAYBACK_STOPPED || pFound->bPaused)
+	{
+		*pAudibility = 0.0f;
+		return FMOD_OK;
+	}
+
+	const HeadlessEventInfo& info = pFound->pDescription->info;
+	if (!info.b3D)
+	{
+		*pAudibility = 1.0f;
+		return FMOD_OK;
+	}
+
+	// Inverse rolloff from the closest listener, the same as FMOD's default
+	float fDistance = 0.0f;
+	for (int i = 0; i < mnListeners; i++)
+	{
+		float fX = pFound->attributes.position.x - mListeners[i].position.x;
+		float fY = pFound->attributes.position.y - mListeners[i].position.y;
+		float fZ = pFound->attributes.position.z - mListeners[i].position.z;
+		float fListenerDistance = sqrtf(fX * fX + fY * fY + fZ * fZ);
+		if (i == 0 || fListenerDistance < fDistance)
+			fDistance = fListenerDistance;
+	}
+
+	if (fDistance > info.fMaxDistance)
+		*pAudibility = 0.0f;
+	else if (fDistance <= info.fMinDistance)
+		*pAudibility = 1.0f;
+	else
+		*pAudibility = info.fMinDistance / fDistance;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::GetMemoryUsage(BackendEventInstance* pInstance, FMOD_STUDIO_MEMORY_USAGE* pUsage)
+{
+	mnCallCount++;
+	Instance* pFound = Get(pInstance);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+	if (!pUsage)
+		return FMOD_ERR_INVALID_PARAM;
+
+	// The instance itself is alive, so its event's sample data is loaded
+	memset(pUsage, 0, sizeof(FMOD_STUDIO_MEMORY_USAGE));
+	pUsage->sampledata = pFound->pDescription->info.nSampleBytes;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::GetParameterByName(BackendEventInstance* pInstance, const char* strName, float* pValue)
+{
+	mnCallCount++;
+	Instance* pFound = Get(pInstance);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+	if (!pValue)
+		return FMOD_ERR_INVALID_PARAM;
+
+	auto tFoundIt = pFound->Parameters.find(strName);
+	if (tFoundIt == pFound->Parameters.end())
+	{
+		if (!pFound->pDescription->bAnyParameter)
+			return FMOD_ERR_EVENT_NOTFOUND;
+
+		*pValue = 0.0f;
+		return FMOD_OK;
+	}
+
+	*pValue = tFoundIt->second;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::SetParametersByIDs(BackendEventInstance* pInstance, const FMOD_STUDIO_PARAMETER_ID* pIDs, float* pValues, int nCount)
+{
+	mnCallCount++;
+	Instance* pFound = Get(pInstance);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+	if (!pIDs || !pValues)
+		return FMOD_ERR_INVALID_PARAM;
+
+	const Description& description = *pFound->pDescription;
+	for (int i = 0; i < nCount; i++)
+	{
+		if (pIDs[i].data2 != description.nID || pIDs[i].data1 == 0 || pIDs[i].data1 > description.ParameterNames.size())
+			return FMOD_ERR_EVENT_NOTFOUND;
+
+		pFound->Parameters[description.ParameterNames[pIDs[i].data1 - 1]] = pValues[i];
+	}
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::SetParameterByName(BackendEventInstance* pInstance, const char* strName, float fValue)
+{
+	mnCallCount++;
+	Instance* pFound = Get(pInstance);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+
+	auto tFoundIt = pFound->Parameters.find(strName);
+	if (tFoundIt == pFound->Parameters.end())
+	{
+		if (!pFound->pDescription->bAnyParameter)
+			return FMOD_ERR_EVENT_NOTFOUND;
+
+		pFound->Parameters[strName] = fValue;
+		return FMOD_OK;
+	}
+
+	tFoundIt->second = fValue;
+	return FMOD_OK;
+}
+
+
+//////// Sounds and Channels ////////
+
+FMOD_RESULT HeadlessAudioBackend::CreateSound(const char* strFileName, FMOD_MODE mode, BackendSound** ppSound)
+{
+	mnCallCount++;
+
+	std::unique_ptr<Sound> sound(new Sound());
+	sound->strFileName = strFileName;
+	sound->mode = mode;
+	sound->bReleased = false;
+
+	*ppSound = reinterpret_cast<BackendSound*>(sound.get());
+	mSounds.push_back(std::move(sound));
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::ReleaseSound(BackendSound* pSound)
+{
+	mnCallCount++;
+	Sound* pFound = Get(pSound);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+
+	// Anything still playing it stops
+	for (Channel* pChannel : mPlayingChannels)
+	{
+		if (pChannel->pSound == pFound)
+			pChannel->bStopped = true;
+	}
+
+	pFound->bReleased = true;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::PlaySound(BackendSound* pSound, uint32_t nChannelId, bool bPaused, BackendChannel** ppChannel)
+{
+	mnCallCount++;
+	*ppChannel = NULL;
+
+	Sound* pFound = Get(pSound);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+
+	// Same promise as the FMOD backend, ending never allocates
+	size_t nNeeded = mEndedChannels.size() + mPlayingChannels.size() + 1;
+	if (mEndedChannels.capacity() < nNeeded)
+		mEndedChannels.reserve(nNeeded * 2);
+
+	Channel* pChannel;
+	if (!mFreeChannels.empty())
+	{
+		pChannel = mFreeChannels.back();
+		mFreeChannels.pop_back();
+	}
+	else
+	{
+		mChannels.push_back(std::unique_ptr<Channel>(new Channel()));
+		pChannel = mChannels.back().get();
+		mFreeChannels.reserve(mChannels.size());
+	}
+
+	pChannel->pSound = pFound;
+	pChannel->nId = nChannelId;
+	pChannel->bPaused = bPaused;
+	pChannel->bStopped = false;
+	pChannel->fPosition = 0.0f;
+	memset(&pChannel->position, 0, sizeof(pChannel->position));
+	pChannel->fVolume = 1.0f;
+	pChannel->nPlayingIndex = mPlayingChannels.size();
+	mPlayingChannels.push_back(pChannel);
+
+	*ppChannel = reinterpret_cast<BackendChannel*>(pChannel);
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::StopChannel(BackendChannel* pChannel)
+{
+	mnCallCount++;
+	Channel* pFound = Get(pChannel);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+
+	pFound->bStopped = true;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::SetChannelPaused(BackendChannel* pChannel, bool bPaused)
+{
+	mnCallCount++;
+	Channel* pFound = Get(pChannel);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+
+	pFound->bPaused = bPaused;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::SetChannel3DAttributes(BackendChannel* pChannel, const FMOD_VECTOR& position, const FMOD_VECTOR& velocity)
+{
+	mnCallCount++;
+	Channel* pFound = Get(pChannel);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+
+	pFound->position = position;
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::SetChannelVolume(BackendChannel* pChannel, float fVolume)
+{
+	mnCallCount++;
+	Channel* pFound = Get(pChannel);
+	if (!pFound)
+		return FMOD_ERR_INVALID_HANDLE;
+
+	pFound->fVolume = fVolume;
+	return FMOD_OK;
+}
+
+
+//////// Profiling ////////
+
+FMOD_RESULT HeadlessAudioBackend::GetCPUUsage(FMOD_STUDIO_CPU_USAGE* pUsage)
+{
+	if (!pUsage)
+		return FMOD_ERR_INVALID_PARAM;
+
+	*pUsage = FMOD_STUDIO_CPU_USAGE();
+	return FMOD_OK;
+}
+
+FMOD_RESULT HeadlessAudioBackend::GetMemoryUsage(int* pCurrent, int* pMax)
+{
+	if (!pCurrent || !pMax)
+		return FMOD_ERR_INVALID_PARAM;
+
+	*pCurrent = 0;
+	*pMax = 0;
+	return FMOD_OK;
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "AudioBackend.h"
+
+// Standard Library
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+
+/*
+ * What the headless backend pretends an event is like
+ */
+struct HeadlessEventInfo
+{
+	float fLength = 2.0f;       // in seconds, 0 plays until stopped
+	float fFadeOutTime = 0.0f;  // how long an instance stays STOPPING when stopped with a fade out
+	bool b3D = true;
+	float fMinDistance = 1.0f;
+	float fMaxDistance = 20.0f;
+	std::map<std::string, float> Parameters; // names and default values, anything else is FMOD_ERR_EVENT_NOTFOUND
+	std::string strBank = "Master"; // the bank that lists it, by file name without the folder or extension
+	bool bStream = false;
+	int nSampleBytes = 0;   // sample memory reported while the event's sample data is loaded
+	float fToneFrequency = 0.0f; // what it sounds like in a render, 0 picks a note from the order events were added in
+};
+
+/*
+ * An in process stand in for FMOD Studio. Banks, event descriptions and instances are simulated well enough
+ * for the AudioEngine's own bookkeeping to run: loading takes a set number of updates, instances move through
+ * the same playback states as FMOD, parameters and 3D attributes are stored, and audibility is worked out from
+ * the listener with an inverse rolloff. Time only moves forward by a fixed step on each Update, so runs are
+ * deterministic no matter how fast they go.
+ */
+class HeadlessAudioBackend : public AudioBackend
+{
+public:
+	HeadlessAudioBackend();
+	~HeadlessAudioBackend();
+
+	AudioBackendType GetType() const override { return AudioBackendType::Headless; }
+	float GetUpdateStep() const override { return mfUpdateStep; }
+
+	// Setup
+	// Events that are asked for by GUID without being added here get the default info, and accept any parameter
+	void AddEvent(const FMOD_GUID& guid, const HeadlessEventInfo& info);
+	void SetDefaultEventInfo(const HeadlessEventInfo& info) { mDefaultEventInfo = info; }
+	void SetUpdateStep(float fSeconds) { mfUpdateStep = fSeconds; }
+	void SetLoadUpdates(int nUpdates) { mnLoadUpdates = nUpdates; } // how many updates non blocking loads take
+	void SetSoundLength(float fSeconds) { mfSoundLength = fSeconds; } // for every sound that isn't looping
+
+	// Inspection
+	float GetTime() const { return mfTime; }
+	int GetPlayingInstanceCount() const { return (int)mPlaying.size(); }
+	int GetPlayingChannelCount() const { return (int)mPlayingChannels.size(); }
+	int GetNumListeners() const { return mnListeners; }
+	const FMOD_3D_ATTRIBUTES& GetListenerAttributes(int nListener = 0) const { return mListeners[nListener]; }
+	bool GetAttributes(BackendEventInstance* pInstance, FMOD_3D_ATTRIBUTES* pAttributes) const;
+	bool IsPaused(BackendEventInstance* pInstance) const;
+	// Sample data stays loaded while it has been asked for, or while any instance of the event is alive
+	size_t GetResidentSampleBytes() const;
+
+	// Output
+	// While an output file is open, every update mixes one step of audio into it as 16 bit stereo. Each playing event
+	// is a sine tone, attenuated with the same rolloff as GetAudibility, panned and doppler shifted from the first
+	// listener, so renders of a scripted scene can be compared against golden files. An event parameter named Occlusion
+	// runs the tone through a low pass, like the one the engine's occlusion is expected to drive in FMOD Studio.
+	bool OpenOutputFile(const char* strFileName, int nSampleRate = 48000);
+	void CloseOutputFile();
+	size_t GetRenderedFrames() const { return mnRenderedFrames; }
+	int GetSampleRate() const { return mnSampleRate; }
+
+	// System
+	FMOD_RESULT Update() override;
+	FMOD_RESULT UnloadAll() override;
+	FMOD_RESULT SetNumListeners(int nListeners) override;
+	FMOD_RESULT SetListenerAttributes(int nListener, const FMOD_3D_ATTRIBUTES& attributes) override;
+	FMOD_RESULT SetParameterByName(const char* strName, float fValue) override;
+	FMOD_RESULT GetParameterDescriptionByName(const char* strName, FMOD_STUDIO_PARAMETER_DESCRIPTION* pParameter) override;
+	FMOD_RESULT SetParametersByIDs(const FMOD_STUDIO_PARAMETER_ID* pIDs, float* pValues, int nCount) override;
+
+	// Banks
+	FMOD_RESULT LoadBankFile(const char* strFileName, FMOD_STUDIO_LOAD_BANK_FLAGS flags, BackendBank** ppBank) override;
+	FMOD_RESULT GetLoadingState(BackendBank* pBank, FMOD_STUDIO_LOADING_STATE* pState) override;
+	FMOD_RESULT GetEventCount(BackendBank* pBank, int* pCount) override;
+	FMOD_RESULT GetEventList(BackendBank* pBank, BackendEventDescription** ppDescriptions, int nCapacity, int* pCount) override;
+
+	// Event descriptions
+	FMOD_RESULT GetEventByID(const FMOD_GUID* pGUID, BackendEventDescription** ppDescription) override;
+	FMOD_RESULT Is3D(BackendEventDescription* pDescription, bool* pIs3D) override;
+	FMOD_RESULT GetMinimumDistance(BackendEventDescription* pDescription, float* pDistance) override;
+	FMOD_RESULT GetMaximumDistance(BackendEventDescription* pDescription, float* pDistance) override;
+	FMOD_RESULT GetLength(BackendEventDescription* pDescription, int* pLength) override;
+	FMOD_RESULT IsStream(BackendEventDescription* pDescription, bool* pIsStream) override;
+	FMOD_RESULT LoadSampleData(BackendEventDescription* pDescription) override;
+	FMOD_RESULT UnloadSampleData(BackendEventDescription* pDescription) override;
+	FMOD_RESULT GetSampleLoadingState(BackendEventDescription* pDescription, FMOD_STUDIO_LOADING_STATE* pState) override;
+	FMOD_RESULT CreateInstance(BackendEventDescription* pDescription, BackendEventInstance** ppInstance) override;
+	FMOD_RESULT GetParameterDescriptionByName(BackendEventDescription* pDescription, const char* strName, FMOD_STUDIO_PARAMETER_DESCRIPTION* pParameter) override;
+
+	// Event instances
+	FMOD_RESULT Start(BackendEventInstance* pInstance) override;
+	FMOD_RESULT Stop(BackendEventInstance* pInstance, FMOD_STUDIO_STOP_MODE eMode) override;
+	FMOD_RESULT Release(BackendEventInstance* pInstance) override;
+	FMOD_RESULT SetPaused(BackendEventInstance* pInstance, bool bPaused) override;
+	FMOD_RESULT GetPlaybackState(BackendEventInstance* pInstance, FMOD_STUDIO_PLAYBACK_STATE* pState) override;
+	FMOD_RESULT GetTimelinePosition(BackendEventInstance* pInstance, int* pPosition) override;
+	FMOD_RESULT Set3DAttributes(BackendEventInstance* pInstance, const FMOD_3D_ATTRIBUTES& attributes) override;
+	FMOD_RESULT GetAudibility(BackendEventInstance* pInstance, float* pAudibility) override;
+	FMOD_RESULT GetMemoryUsage(BackendEventInstance* pInstance, FMOD_STUDIO_MEMORY_USAGE* pUsage) override;
+	FMOD_RESULT GetParameterByName(BackendEventInstance* pInstance, const char* strName, float* pValue) override;
+	FMOD_RESULT SetParameterByName(BackendEventInstance* pInstance, const char* strName, float fValue) override;
+	FMOD_RESULT SetParametersByIDs(BackendEventInstance* pInstance, const FMOD_STUDIO_PARAMETER_ID* pIDs, float* pValues, int nCount) override;
+
+	// Sounds and channels
+	FMOD_RESULT CreateSound(const char* strFileName, FMOD_MODE mode, BackendSound** ppSound) override;
+	FMOD_RESULT ReleaseSound(BackendSound* pSound) override;
+	FMOD_RESULT PlaySound(BackendSound* pSound, uint32_t nChannelId, bool bPaused, BackendChannel** ppChannel) override;
+	FMOD_RESULT StopChannel(BackendChannel* pChannel) override;
+	FMOD_RESULT SetChannelPaused(BackendChannel* pChannel, bool bPaused) override;
+	FMOD_RESULT SetChannel3DAttributes(BackendChannel* pChannel, const FMOD_VECTOR& position, const FMOD_VECTOR& velocity) override;
+	FMOD_RESULT SetChannelVolume(BackendChannel* pChannel, float fVolume) override;
+	const std::vector<uint32_t>& GetEndedChannels() const override { return mEndedChannels; }
+	void ClearEndedChannels() override { mEndedChannels.clear(); }
+
+	// Profiling
+	// Nothing is mixed or allocated by FMOD, so the CPU and memory usage are always 0
+	size_t GetCallCount() const override { return mnCallCount; }
+	FMOD_RESULT GetCPUUsage(FMOD_STUDIO_CPU_USAGE* pUsage) override;
+	FMOD_RESULT GetMemoryUsage(int* pCurrent, int* pMax) override;
+
+private:
+	struct Bank
+	{
+		std::string strFileName;
+		int nUpdatesLeft; // until it is loaded
+		bool bUnloaded;
+	};
+
+	struct Description
+	{
+		FMOD_GUID guid;
+		HeadlessEventInfo info;
+		bool bAnyParameter;   // made up for an unknown GUID, so we don't know what parameters it has
+		uint32_t nID;         // goes in data2 of its parameter IDs, data1 is the index into ParameterNames + 1
+		std::vector<std::string> ParameterNames;
+		bool bSamplesRequested;
+		int nSampleUpdatesLeft;
+		int nInstances; // created and not released yet
+	};
+
+	struct Instance
+	{
+		Description* pDescription; // NULL once released
+		FMOD_STUDIO_PLAYBACK_STATE eState;
+		bool bPaused;
+		float fPosition;      // seconds into the event
+		float fFadeRemaining; // while STOPPING
+		FMOD_3D_ATTRIBUTES attributes;
+		std::map<std::string, float> Parameters;
+		size_t nPlayingIndex; // in mPlaying, while not STOPPED
+
+		// Rendering, gains ramp from where the last update left them so moving events don't click
+		float fPhase;
+		float fLeftGain;
+		float fRightGain;
+	};
+
+	struct Sound
+	{
+		std::string strFileName;
+		FMOD_MODE mode;
+		bool bReleased;
+	};
+
+	struct Channel
+	{
+		Sound* pSound;   // NULL once it has ended
+		uint32_t nId;
+		bool bPaused;
+		bool bStopped;   // ends on the next update, like FMOD's end callback
+		float fPosition; // seconds into the sound
+		FMOD_VECTOR position;
+		float fVolume;
+		size_t nPlayingIndex; // in mPlayingChannels
+	};
+
+	Bank* Get(BackendBank* pBank) const;
+	Description* Get(BackendEventDescription* pDescription) const;
+	Instance* Get(BackendEventInstance* pInstance) const;
+	Sound* Get(BackendSound* pSound) const;
+	Channel* Get(BackendChannel* pChannel) const;
+	void EndChannel(Channel& channel);
+	void SetStopped(Instance& instance);
+	bool IsAnyBankLoaded() const; // events can only be found while a bank is loaded
+	static bool IsInBank(const Description& description, const Bank& bank);
+	static float GetRolloffGain(const HeadlessEventInfo& info, float fDistance);
+	void Mix();
+	static FMOD_RESULT DescribeParameter(std::vector<std::string>& names, const char* strName, bool bAddMissing, uint32_t nOwnerID,
+		float fDefault, FMOD_STUDIO_PARAMETER_DESCRIPTION* pParameter);
+
+	// Objects are only freed when the backend is, so stale pointers passed in can still be checked
+	std::vector<std::unique_ptr<Bank>> mBanks;
+	std::vector<std::unique_ptr<Description>> mDescriptions;
+	std::vector<std::unique_ptr<Instance>> mInstances;
+	std::vector<Instance*> mFreeInstances;
+	std::vector<Instance*> mPlaying; // everything that isn't STOPPED, so updates only touch those
+	std::vector<std::unique_ptr<Sound>> mSounds;
+	std::vector<std::unique_ptr<Channel>> mChannels;
+	std::vector<Channel*> mFreeChannels;
+	std::vector<Channel*> mPlayingChannels;
+	std::vector<uint32_t> mEndedChannels;
+
+	std::map<std::string, float> mGlobalParameters;
+	std::vector<std::string> mGlobalParameterNames; // global parameter IDs are the index + 1, with data2 left at 0
+	FMOD_3D_ATTRIBUTES mListeners[FMOD_MAX_LISTENERS];
+	int mnListeners;
+	HeadlessEventInfo mDefaultEventInfo;
+	float mfUpdateStep;
+	float mfTime;
+	int mnLoadUpdates;
+	float mfSoundLength;
+	size_t mnCallCount;
+
+	// Output
+	std::ofstream mOutput;
+	int mnSampleRate;
+	float mfFramesOwed; // the part of a frame each step leaves over, so odd steps don't drift
+	size_t mnRenderedFrames;
+	std::vector<float> mMixBuffer;      // interleaved left and right
+	std::vector<char> mOutputBuffer;
+};
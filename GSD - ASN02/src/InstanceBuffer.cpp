@@ -0,0 +1,150 @@
+#include "InstanceBuffer.h"
+#include "Logging.h"
+#include <algorithm>
+
+// Meshes only use the first few vertex buffer bindings, so the instances go on one well past them
+static const GLuint INSTANCE_BINDING = 15;
+// How long to wait on a fence before giving up, in nanoseconds. A region is only ever waited on after two more
+// frames were submitted, so hitting this means something else is very wrong
+static const GLuint64 FENCE_TIMEOUT = 1000000000;
+
+InstanceBuffer::InstanceBuffer(uint32_t capacity) :
+	myRendererID(0),
+	myMapping(nullptr),
+	myCapacity(0),
+	myRegion(0),
+	myCursor(0)
+{
+	for (int ix = 0; ix < REGIONS; ix++)
+		myFences[ix] = nullptr;
+	Create(std::max(capacity, 1u));
+}
+
+InstanceBuffer::~InstanceBuffer() {
+	Destroy();
+}
+
+void InstanceBuffer::Create(uint32_t capacity) {
+	myCapacity = capacity;
+	GLsizeiptr size = (GLsizeiptr)sizeof(Instance) * myCapacity * REGIONS;
+
+	// The mapping stays valid for as long as the buffer exists, and coherent means we never have to flush it
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &myRendererID);
+	glNamedBufferStorage(myRendererID, size, nullptr, flags);
+	myMapping = (Instance*)glMapNamedBufferRange(myRendererID, 0, size, flags);
+}
+
+void InstanceBuffer::Destroy() {
+	for (int ix = 0; ix < REGIONS; ix++) {
+		if (myFences[ix] != nullptr) {
+			glDeleteSync(myFences[ix]);
+			myFences[ix] = nullptr;
+		}
+	}
+	if (myRendererID != 0) {
+		glUnmapNamedBuffer(myRendererID);
+		glDeleteBuffers(1, &myRendererID);
+		myRendererID = 0;
+	}
+	myMapping = nullptr;
+}
+
+void InstanceBuffer::BeginFrame() {
+	myRegion = (myRegion + 1) % REGIONS;
+	myCursor = 0;
+
+	// This region was last written three frames ago, so the GPU is almost always done with it by now
+	if (myFences[myRegion] != nullptr) {
+		GLenum result = glClientWaitSync(myFences[myRegion], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+		if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED)
+			LOG_WARN("Timed out waiting for instance buffer region {}", myRegion);
+		glDeleteSync(myFences[myRegion]);
+		myFences[myRegion] = nullptr;
+	}
+}
+
+void InstanceBuffer::EndFrame() {
+	if (myCursor > 0)
+		myFences[myRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+InstanceBuffer::Instance* InstanceBuffer::Allocate(uint32_t count, uint32_t& baseInstance) {
+	if (myCursor + count > myCapacity) {
+		// Draws already submitted keep reading from the old buffer, GL holds on to it until they are done, so we can
+		// swap in a bigger one straight away without waiting on anything
+		uint32_t capacity = std::max(myCapacity * 2, myCursor + count);
+		LOG_INFO("Growing instance buffer from {} to {} instances per frame", myCapacity, capacity);
+		Destroy();
+		Create(capacity);
+		for (auto it = myMeshes.begin(); it != myMeshes.end();) {
+			if (it->second.Mesh.expired()) {
+				it = myMeshes.erase(it);
+				continue;
+			}
+			if (it->second.IndexCount > 0)
+				Attach(it->second.VertexArray);
+			++it;
+		}
+	}
+
+	baseInstance = myRegion * myCapacity + myCursor;
+	myCursor += count;
+	return myMapping + baseInstance;
+}
+
+void InstanceBuffer::Write(Instance& instance, const glm::mat4& world, const glm::mat3& normalMatrix) {
+	instance.Model = world;
+	instance.NormalMatrix[0] = glm::vec4(normalMatrix[0], 0.0f);
+	instance.NormalMatrix[1] = glm::vec4(normalMatrix[1], 0.0f);
+	instance.NormalMatrix[2] = glm::vec4(normalMatrix[2], 0.0f);
+}
+
+bool InstanceBuffer::CanInstance(const florp::graphics::Mesh::Sptr& mesh) {
+	auto it = myMeshes.find(mesh.get());
+	if (it != myMeshes.end() && it->second.Mesh.lock() == mesh)
+		return it->second.IndexCount > 0;
+
+	// The mesh doesn't tell us how many indices it has, but its vertex array knows which index buffer it uses
+	MeshInfo info;
+	info.Mesh = mesh;
+	info.VertexArray = mesh->GetRenderID();
+	info.IndexCount = 0;
+	GLint indexBuffer = 0;
+	glGetVertexArrayiv(info.VertexArray, GL_ELEMENT_ARRAY_BUFFER_BINDING, &indexBuffer);
+	if (indexBuffer != 0) {
+		GLint size = 0;
+		glGetNamedBufferParameteriv(indexBuffer, GL_BUFFER_SIZE, &size);
+		info.IndexCount = size / (GLint)sizeof(uint32_t);
+		Attach(info.VertexArray);
+	}
+	myMeshes[mesh.get()] = info;
+	return info.IndexCount > 0;
+}
+
+void InstanceBuffer::Attach(GLuint vertexArray) {
+	glVertexArrayVertexBuffer(vertexArray, INSTANCE_BINDING, myRendererID, 0, sizeof(Instance));
+	glVertexArrayBindingDivisor(vertexArray, INSTANCE_BINDING, 1);
+
+	// A mat4 attribute takes up four locations, one for each column
+	for (GLuint ix = 0; ix < 4; ix++) {
+		GLuint location = MODEL_LOCATION + ix;
+		glEnableVertexArrayAttrib(vertexArray, location);
+		glVertexArrayAttribFormat(vertexArray, location, 4, GL_FLOAT, GL_FALSE, offsetof(Instance, Model) + sizeof(glm::vec4) * ix);
+		glVertexArrayAttribBinding(vertexArray, location, INSTANCE_BINDING);
+	}
+	// The normal matrix is a mat3, so only the first three components of each padded column are read
+	for (GLuint ix = 0; ix < 3; ix++) {
+		GLuint location = NORMAL_LOCATION + ix;
+		glEnableVertexArrayAttrib(vertexArray, location);
+		glVertexArrayAttribFormat(vertexArray, location, 3, GL_FLOAT, GL_FALSE, offsetof(Instance, NormalMatrix) + sizeof(glm::vec4) * ix);
+		glVertexArrayAttribBinding(vertexArray, location, INSTANCE_BINDING);
+	}
+}
+
+void InstanceBuffer::Draw(const florp::graphics::Mesh::Sptr& mesh, uint32_t count, uint32_t baseInstance) {
+	const MeshInfo& info = myMeshes[mesh.get()];
+	glBindVertexArray(info.VertexArray);
+	glDrawElementsInstancedBaseInstance(GL_TRIANGLES, info.IndexCount, GL_UNSIGNED_INT, nullptr, count, baseInstance);
+	glBindVertexArray(0);
+}
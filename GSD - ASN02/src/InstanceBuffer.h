@@ -0,0 +1,104 @@
+#pragma once
+#include <glad/glad.h>
+#include <GLM/glm.hpp>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "florp/graphics/Mesh.h"
+
+/*
+ * A persistently mapped buffer of per-instance transforms, for drawing many copies of a mesh with one draw call.
+ * The buffer is split into a region per frame in flight, each guarded by a fence, so writing this frame's
+ * instances never has to wait for the GPU to finish drawing the last frame's.
+ *
+ * Meshes get the instance attributes added to their vertex arrays the first time they are drawn through here,
+ * at the locations lighting_instanced.vs.glsl expects:
+ *    8..11 - the model matrix
+ *   12..14 - the normal matrix
+ */
+class InstanceBuffer {
+public:
+	typedef std::shared_ptr<InstanceBuffer> Sptr;
+
+	// Matches the instance attributes, the normal matrix columns are padded out to vec4s
+	struct Instance {
+		glm::mat4 Model;
+		glm::vec4 NormalMatrix[3];
+	};
+
+	// The attribute locations the instanced shaders read from
+	static const GLuint MODEL_LOCATION = 8;
+	static const GLuint NORMAL_LOCATION = 12;
+
+	/*
+	 * Creates a new instance buffer
+	 * @param capacity The number of instances each frame can hold before the buffer has to grow
+	 */
+	InstanceBuffer(uint32_t capacity = 4096);
+	~InstanceBuffer();
+
+	InstanceBuffer(const InstanceBuffer& other) = delete;
+	InstanceBuffer& operator=(const InstanceBuffer& other) = delete;
+
+	// Moves on to the next region, waiting if the GPU is still reading from it
+	void BeginFrame();
+	// Fences off everything written since BeginFrame
+	void EndFrame();
+
+	/*
+	 * Reserves space for some instances in this frame's region, growing the buffer if it's full
+	 * @param count The number of instances to reserve
+	 * @param baseInstance Receives the index of the first instance, to pass along to Draw
+	 * @returns Where to write the instances, valid until the next call to Allocate
+	 */
+	Instance* Allocate(uint32_t count, uint32_t& baseInstance);
+
+	/*
+	 * Fills in an instance from an object's world transform
+	 * @param instance The instance to write to, usually in the mapped buffer
+	 * @param world The world transform of the object being drawn
+	 * @param normalMatrix The inverse transpose of the world transform
+	 */
+	static void Write(Instance& instance, const glm::mat4& world, const glm::mat3& normalMatrix);
+
+	/*
+	 * Checks whether a mesh can be drawn instanced, and if so attaches the instance attributes to it. Only meshes
+	 * with an index buffer can be, since that's where the number of elements to draw comes from
+	 */
+	bool CanInstance(const florp::graphics::Mesh::Sptr& mesh);
+
+	/*
+	 * Draws a run of instances written by Allocate, the mesh must have passed CanInstance
+	 * @param mesh The mesh to draw
+	 * @param count The number of instances to draw
+	 * @param baseInstance The index of the first instance, from Allocate
+	 */
+	void Draw(const florp::graphics::Mesh::Sptr& mesh, uint32_t count, uint32_t baseInstance);
+
+	// The number of instances each frame's region can hold
+	uint32_t GetCapacity() const { return myCapacity; }
+
+private:
+	// Frames that can be in flight at once, each gets its own region of the buffer
+	static const int REGIONS = 3;
+
+	struct MeshInfo {
+		std::weak_ptr<florp::graphics::Mesh> Mesh; // so a new mesh at the same address isn't mistaken for this one
+		GLuint VertexArray;
+		GLsizei IndexCount;
+	};
+
+	void Create(uint32_t capacity);
+	void Destroy();
+	void Attach(GLuint vertexArray);
+
+	GLuint    myRendererID;
+	Instance* myMapping;
+	uint32_t  myCapacity;
+	int       myRegion;
+	uint32_t  myCursor;  // how many instances have been written to the current region
+	GLsync    myFences[REGIONS];
+
+	std::unordered_map<const void*, MeshInfo> myMeshes;
+};
@@ -0,0 +1,134 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+JobSystem::JobSystem(uint32_t threadCount) :
+	myFunc(nullptr),
+	myGrain(1),
+	myRemaining(0),
+	myGeneration(0),
+	myShutdown(false)
+{
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (uint32_t ix = 0; ix < threadCount; ix++)
+		myQueues.push_back(std::make_unique<Queue>());
+	// Thread 0 is whoever calls ParallelFor, so it doesn't need a worker
+	for (uint32_t ix = 1; ix < threadCount; ix++)
+		myWorkers.emplace_back(&JobSystem::WorkerMain, this, ix);
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(myWakeLock);
+		myShutdown = true;
+	}
+	myWake.notify_all();
+	for (std::thread& worker : myWorkers)
+		worker.join();
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grain, const RangeFunc& func) {
+	if (count == 0)
+		return;
+	grain = std::max(grain, 1u);
+
+	// Nothing worth waking anyone up for, but the chunks still have to line up
+	if (myWorkers.empty() || count <= grain) {
+		for (uint32_t begin = 0; begin < count; begin += grain)
+			func(begin, std::min(begin + grain, count), 0);
+		return;
+	}
+
+	// The whole loop starts on our queue, and gets split up from there as the workers steal from us
+	myFunc = &func;
+	myGrain = grain;
+	myRemaining.store(count, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(myQueues[0]->Lock);
+		myQueues[0]->Ranges.push_back({ 0, count });
+	}
+	{
+		std::lock_guard<std::mutex> lock(myWakeLock);
+		myGeneration++;
+	}
+	myWake.notify_all();
+
+	// Help out until everything has been run, the acquire makes sure we see everything the workers wrote
+	while (myRemaining.load(std::memory_order_acquire) > 0) {
+		if (!RunOne(0))
+			std::this_thread::yield();
+	}
+	myFunc = nullptr;
+}
+
+void JobSystem::WorkerMain(uint32_t thread) {
+	uint32_t generation = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(myWakeLock);
+			myWake.wait(lock, [&]() { return myShutdown || myGeneration != generation; });
+			if (myShutdown)
+				return;
+			generation = myGeneration;
+		}
+
+		// Keep looking for work until the loop is finished, it's short enough that spinning beats sleeping
+		while (myRemaining.load(std::memory_order_acquire) > 0) {
+			if (!RunOne(thread))
+				std::this_thread::yield();
+		}
+	}
+}
+
+bool JobSystem::RunOne(uint32_t thread) {
+	Range range;
+	bool found = false;
+
+	// Our own queue first, newest first since it's the smallest and most likely still in cache
+	{
+		Queue& queue = *myQueues[thread];
+		std::lock_guard<std::mutex> lock(queue.Lock);
+		if (!queue.Ranges.empty()) {
+			range = queue.Ranges.back();
+			queue.Ranges.pop_back();
+			found = true;
+		}
+	}
+
+	// Then steal the oldest (and biggest) range from someone else, starting with our neighbour so the threads don't
+	// all pile onto the same queue
+	uint32_t threadCount = (uint32_t)myQueues.size();
+	for (uint32_t ix = 1; ix < threadCount && !found; ix++) {
+		Queue& queue = *myQueues[(thread + ix) % threadCount];
+		std::lock_guard<std::mutex> lock(queue.Lock);
+		if (!queue.Ranges.empty()) {
+			range = queue.Ranges.front();
+			queue.Ranges.pop_front();
+			found = true;
+		}
+	}
+
+	if (found)
+		Run(thread, range);
+	return found;
+}
+
+void JobSystem::Run(uint32_t thread, Range range) {
+	// Split off the back half for someone else to steal until we're down to a single chunk, splitting on a multiple
+	// of the grain so that the chunks always line up
+	uint32_t chunks = (range.End - range.Begin + myGrain - 1) / myGrain;
+	while (chunks > 1) {
+		uint32_t middle = range.Begin + (chunks / 2) * myGrain;
+		{
+			Queue& queue = *myQueues[thread];
+			std::lock_guard<std::mutex> lock(queue.Lock);
+			queue.Ranges.push_back({ middle, range.End });
+		}
+		range.End = middle;
+		chunks /= 2;
+	}
+
+	(*myFunc)(range.Begin, range.End, thread);
+	myRemaining.fetch_sub(range.End - range.Begin, std::memory_order_release);
+}
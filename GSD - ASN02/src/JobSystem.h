@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * A small work-stealing thread pool for splitting loops over many items across cores. The thread calling
+ * ParallelFor takes part in the work as thread 0, and the pool's workers are threads 1 and up.
+ *
+ * Each thread keeps its own queue of ranges. A thread that takes a range bigger than the grain splits it in half,
+ * keeps the front half and pushes the back half onto its queue, so there is always something to steal. Threads pop
+ * from the back of their own queue (the small, recently split ranges) and steal from the front of everyone else's
+ * (the big ones), which keeps the stealing down to a handful of times per loop.
+ *
+ * Ranges are only ever split on multiples of the grain, so every range handed to the function lines up with a
+ * chunk of exactly grain items (the last one can be shorter). Callers can use begin / grain as a chunk index to
+ * keep per-chunk output in order, no matter which thread ran it.
+ */
+class JobSystem {
+public:
+	typedef std::shared_ptr<JobSystem> Sptr;
+
+	/*
+	 * Handles a range of items in a ParallelFor
+	 * @param begin The first item in the range
+	 * @param end One past the last item in the range
+	 * @param thread The index of the thread running it, from 0 up to GetThreadCount()
+	 */
+	typedef std::function<void(uint32_t begin, uint32_t end, uint32_t thread)> RangeFunc;
+
+	/*
+	 * Creates a new job system and starts its workers
+	 * @param threadCount The number of threads to spread work over, including the one calling ParallelFor. 0 uses
+	 *                    one per hardware thread
+	 */
+	JobSystem(uint32_t threadCount = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem& other) = delete;
+	JobSystem& operator=(const JobSystem& other) = delete;
+
+	/*
+	 * Runs a function over a range of items on all the threads, and waits for it to finish. Only one thread may
+	 * call this at a time, and not from inside the function
+	 * @param count The number of items
+	 * @param grain The most items handed to the function at once
+	 * @param func The function to run over each range of items
+	 */
+	void ParallelFor(uint32_t count, uint32_t grain, const RangeFunc& func);
+
+	// The number of threads work is spread over, including the calling thread
+	uint32_t GetThreadCount() const { return (uint32_t)myQueues.size(); }
+
+private:
+	struct Range {
+		uint32_t Begin;
+		uint32_t End;
+	};
+
+	// Each queue sits on its own cache lines, so threads working on their own queues don't slow each other down
+	struct alignas(64) Queue {
+		std::mutex        Lock;
+		std::deque<Range> Ranges;
+	};
+
+	void WorkerMain(uint32_t thread);
+	// Finds a range to work on, from our own queue or someone else's, and runs it. Returns false if there wasn't one
+	bool RunOne(uint32_t thread);
+	void Run(uint32_t thread, Range range);
+
+	std::vector<std::unique_ptr<Queue>> myQueues;
+	std::vector<std::thread>            myWorkers;
+
+	const RangeFunc*      myFunc;
+	uint32_t              myGrain;
+	std::atomic<uint32_t> myRemaining; // items in the current loop that haven't been run yet
+
+	// Workers sleep here between loops
+	std::mutex              myWakeLock;
+	std::condition_variable myWake;
+	uint32_t                myGeneration; // counts up every loop, so a worker can tell there's a new one
+	bool                    myShutdown;
+};
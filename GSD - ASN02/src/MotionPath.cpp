@@ -0,0 +1,99 @@
+#include "MotionPath.h"
+
+#include <cmath>
+#include <algorithm>
+
+MotionPath::MotionPath()
+{
+	mSamples.push_back(glm::vec3(0.0f));
+	mfTickRate = 60.0f;
+	mfLength = 0.0f;
+}
+
+MotionPath::MotionPath(const std::vector<PathKeyframe>& keyframes, Shape eShape, float fTickRate)
+{
+	mfTickRate = fTickRate > 0.0f ? fTickRate : 60.0f;
+	mfLength = 0.0f;
+	Bake(keyframes, eShape);
+}
+
+void MotionPath::Bake(const std::vector<PathKeyframe>& keyframes, Shape eShape)
+{
+	mSamples.clear();
+	if (keyframes.size() < 2)
+	{
+		mSamples.push_back(keyframes.empty() ? glm::vec3(0.0f) : keyframes[0].vPosition);
+		return;
+	}
+
+	mfLength = keyframes.back().fTime - keyframes.front().fTime;
+	if (mfLength <= 0.0f)
+	{
+		mfLength = 0.0f;
+		mSamples.push_back(keyframes.back().vPosition);
+		return;
+	}
+
+	// The rate is nudged up so the last sample lands exactly on the end of the path
+	size_t nSamples = (size_t)ceilf(mfLength * mfTickRate) + 1;
+	mfTickRate = (nSamples - 1) / mfLength;
+	mSamples.reserve(nSamples);
+
+	// Samples only ever move forward, so the segment is carried over from the last sample instead of searched for
+	size_t nSegment = 0;
+	size_t nLast = keyframes.size() - 1;
+	for (size_t i = 0; i < nSamples; i++)
+	{
+		float fTime = keyframes.front().fTime + std::min((float)i / mfTickRate, mfLength);
+		while (nSegment + 1 < nLast && fTime >= keyframes[nSegment + 1].fTime)
+			nSegment++;
+
+		const PathKeyframe& from = keyframes[nSegment];
+		const PathKeyframe& to = keyframes[nSegment + 1];
+		float fSegmentLength = to.fTime - from.fTime;
+		float u = fSegmentLength > 0.0f ? glm::clamp((fTime - from.fTime) / fSegmentLength, 0.0f, 1.0f) : 1.0f;
+		float t = Easing::Evaluate(from.eCurve, u);
+
+		if (eShape == Shape::Spline)
+		{
+			// The ends are repeated, so the spline still passes through the first and last keyframes
+			const glm::vec3& p0 = keyframes[nSegment > 0 ? nSegment - 1 : 0].vPosition;
+			const glm::vec3& p1 = from.vPosition;
+			const glm::vec3& p2 = to.vPosition;
+			const glm::vec3& p3 = keyframes[std::min(nSegment + 2, nLast)].vPosition;
+			float t2 = t * t;
+			float t3 = t2 * t;
+			mSamples.push_back(0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+				(3.0f * p1 - p0 - 3.0f * p2 + p3) * t3));
+		}
+		else
+		{
+			mSamples.push_back(glm::mix(from.vPosition, to.vPosition, t));
+		}
+	}
+}
+
+glm::vec3 MotionPath::Sample(float fTime, bool bLoop) const
+{
+	if (bLoop && mfLength > 0.0f)
+	{
+		fTime = fmodf(fTime, mfLength);
+		if (fTime < 0.0f)
+			fTime += mfLength;
+	}
+
+	float fSample = glm::clamp(fTime, 0.0f, mfLength) * mfTickRate;
+	size_t nSample = (size_t)fSample;
+	if (nSample + 1 >= mSamples.size())
+		return mSamples.back();
+
+	return glm::mix(mSamples[nSample], mSamples[nSample + 1], fSample - (float)nSample);
+}
+
+void MotionPath::Sample(const float* pTimes, glm::vec3* pPositions, size_t nCount, bool bLoop) const
+{
+	for (size_t i = 0; i < nCount; i++)
+	{
+		pPositions[i] = Sample(pTimes[i], bLoop);
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Easing.h"
+
+// GLM
+#include <glm/glm.hpp>
+
+// Standard Library
+#include <vector>
+
+/*
+ * One point on a MotionPath. The curve is how the path eases from this keyframe to the next one.
+ */
+struct PathKeyframe
+{
+	float fTime; // seconds from the start of the path
+	glm::vec3 vPosition;
+	Easing::Curve eCurve = Easing::Curve::Linear;
+};
+
+/*
+ * A path through a list of keyframes, baked into evenly spaced samples when it is built. Sampling is then an
+ * index and a lerp between two neighbouring samples in one contiguous buffer, whatever the number of keyframes,
+ * so one path can be shared by hundreds of emitters every frame.
+ */
+class MotionPath
+{
+public:
+	enum class Shape
+	{
+		Straight, // straight lines between keyframes
+		Spline    // a Catmull-Rom spline through the keyframes
+	};
+
+	MotionPath();
+	// Keyframes have to be in time order. fTickRate is how many samples are baked per second of path, it is
+	// rounded up a little so the last sample lands on the last keyframe.
+	MotionPath(const std::vector<PathKeyframe>& keyframes, Shape eShape = Shape::Straight, float fTickRate = 60.0f);
+
+	// Where the path is fTime seconds in, held at the ends unless it loops
+	glm::vec3 Sample(float fTime, bool bLoop = false) const;
+	// pPositions[i] is where the path is at pTimes[i]
+	void Sample(const float* pTimes, glm::vec3* pPositions, size_t nCount, bool bLoop = false) const;
+
+	float GetLength() const { return mfLength; }
+	float GetTickRate() const { return mfTickRate; }
+	size_t GetSampleCount() const { return mSamples.size(); }
+
+private:
+	void Bake(const std::vector<PathKeyframe>& keyframes, Shape eShape);
+
+	std::vector<glm::vec3> mSamples;
+	float mfTickRate;
+	float mfLength; // seconds
+};
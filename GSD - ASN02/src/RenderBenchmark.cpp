@@ -0,0 +1,66 @@
+#include "RenderBenchmark.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+RenderBenchmark::RenderBenchmark() :
+	myStep(0),
+	myFrame(0),
+	myTotals()
+{
+	uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	for (uint32_t threads = 1; threads < hardwareThreads; threads *= 2)
+		myThreadCounts.push_back(threads);
+	myThreadCounts.push_back(hardwareThreads);
+}
+
+void RenderBenchmark::AddFrame(int renderables, double build, double record, double replay) {
+	if (!IsRunning())
+		return;
+
+	myFrame++;
+	if (myFrame <= WARMUP_FRAMES)
+		return;
+
+	myTotals.Renderables += renderables;
+	myTotals.Build += build;
+	myTotals.Record += record;
+	myTotals.Replay += replay;
+	if (myFrame < WARMUP_FRAMES + MEASURED_FRAMES)
+		return;
+
+	// Done with this thread count, so store the averages and move on to the next
+	Result result;
+	result.Threads = myThreadCounts[myStep];
+	result.Renderables = myTotals.Renderables / MEASURED_FRAMES;
+	result.Build = myTotals.Build / MEASURED_FRAMES;
+	result.Record = myTotals.Record / MEASURED_FRAMES;
+	result.Replay = myTotals.Replay / MEASURED_FRAMES;
+	myResults.push_back(result);
+
+	myTotals = Result();
+	myFrame = 0;
+	myStep++;
+	if (!IsRunning())
+		Print();
+}
+
+void RenderBenchmark::Print() const {
+	std::cout << "Render Benchmark: CPU time per frame in RenderLayer, averaged over " << MEASURED_FRAMES << " frames" << std::endl;
+	std::cout << "\tthreads  renderables   build(us)  record(us)  replay(us)   total(us)  speedup" << std::endl;
+
+	double baseline = myResults.empty() ? 0.0 : myResults[0].Build + myResults[0].Record + myResults[0].Replay;
+	for (const Result& result : myResults) {
+		double total = result.Build + result.Record + result.Replay;
+		std::cout << std::fixed << std::setprecision(1)
+			<< "\t" << std::setw(7) << result.Threads
+			<< "  " << std::setw(11) << result.Renderables
+			<< "  " << std::setw(10) << result.Build
+			<< "  " << std::setw(10) << result.Record
+			<< "  " << std::setw(10) << result.Replay
+			<< "  " << std::setw(10) << total
+			<< "  " << std::setw(6) << std::setprecision(2) << (total > 0.0 ? baseline / total : 0.0) << "x" << std::endl;
+	}
+	std::cout << std::defaultfloat;
+}
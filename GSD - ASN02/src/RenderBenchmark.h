@@ -0,0 +1,52 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+/*
+ * Measures how long the render layer spends on the CPU at each thread count. This runs inside the application,
+ * started with --render-bench [count], which fills the scene with count monkeys (50000 by default). The render
+ * layer steps through the thread counts one after the other, and the results are printed to the console at the end.
+ */
+class RenderBenchmark {
+public:
+	typedef std::shared_ptr<RenderBenchmark> Sptr;
+
+	// Frames to let things settle after changing the thread count, and then to measure
+	static const int WARMUP_FRAMES = 30;
+	static const int MEASURED_FRAMES = 240;
+
+	// Tests 1, 2, 4... threads up to one per hardware thread
+	RenderBenchmark();
+
+	// Whether there are still thread counts left to measure
+	bool IsRunning() const { return myStep < myThreadCounts.size(); }
+	// The number of threads the render layer should be using this frame
+	uint32_t GetThreadCount() const { return myThreadCounts[myStep]; }
+
+	/*
+	 * Adds the times for a frame, moving on to the next thread count once enough frames have been measured
+	 * @param renderables The number of renderables that went through the render queue this frame
+	 * @param build Microseconds spent packing keys and sorting the render queue
+	 * @param record Microseconds spent recording the draw packets and instances
+	 * @param replay Microseconds spent replaying the packets on the GL thread
+	 */
+	void AddFrame(int renderables, double build, double record, double replay);
+
+private:
+	struct Result {
+		uint32_t Threads;
+		int      Renderables;
+		double   Build;
+		double   Record;
+		double   Replay;
+	};
+
+	void Print() const;
+
+	std::vector<uint32_t> myThreadCounts;
+	size_t myStep;
+	int    myFrame;
+	Result myTotals;
+	std::vector<Result> myResults;
+};
@@ -0,0 +1,228 @@
+#include "RenderQueue.h"
+#include <cstring>
+#include <algorithm>
+
+typedef florp::game::RenderableComponent Renderable;
+
+// Below this many items, an insertion sort beats setting up the radix passes
+static const size_t INSERTION_SORT_LIMIT = 64;
+// An insertion sort is also used while the list is nearly in last frame's order, up to this many shifts per item
+static const size_t NEARLY_SORTED_SHIFTS = 4;
+// Radix digits are 11 bits, so a 64 bit key takes 6 passes and the counts fit comfortably on the stack
+static const int RADIX_BITS = 11;
+static const uint32_t RADIX_MASK = (1u << RADIX_BITS) - 1;
+// How many items each job measures at a time, when the keys are spread over a job system
+static const uint32_t KEY_GRAIN = 1024;
+
+// Positive floats sort the same as their bits, so a depth can go straight into a key. Anything behind the camera
+// (and -0, which has the sign bit set) is clamped to 0
+static inline uint32_t DepthBits(float depth) {
+	depth = depth > 0.0f ? depth : 0.0f;
+	uint32_t bits;
+	memcpy(&bits, &depth, sizeof(bits));
+	return bits;
+}
+
+void RenderQueue::Connect(entt::registry& registry) {
+	myEntries.clear();
+	myEntryIndices.clear();
+	myItems.clear();
+
+	registry.view<Renderable>().each([&](auto entity, Renderable& renderable) {
+		Add(entity);
+	});
+
+	registry.on_construct<Renderable>().connect<&RenderQueue::OnConstruct>(*this);
+	registry.on_destroy<Renderable>().connect<&RenderQueue::OnDestroy>(*this);
+}
+
+void RenderQueue::Disconnect(entt::registry& registry) {
+	registry.on_construct<Renderable>().disconnect<&RenderQueue::OnConstruct>(*this);
+	registry.on_destroy<Renderable>().disconnect<&RenderQueue::OnDestroy>(*this);
+
+	myEntries.clear();
+	myEntryIndices.clear();
+	myItems.clear();
+}
+
+void RenderQueue::OnConstruct(entt::entity entity, entt::registry& registry, const Renderable& renderable) {
+	// The mesh and material usually haven't been set yet, so the key is packed on the next Build
+	Add(entity);
+}
+
+void RenderQueue::OnDestroy(entt::entity entity, entt::registry& registry) {
+	auto it = myEntryIndices.find(entity);
+	if (it == myEntryIndices.end())
+		return;
+
+	// Swap the last entry into the gap, the order doesn't matter until the next sort
+	uint32_t index = it->second;
+	myEntryIndices.erase(it);
+	if (index + 1 < myEntries.size()) {
+		myEntries[index] = myEntries.back();
+		myEntryIndices[myEntries[index].Entity] = index;
+	}
+	myEntries.pop_back();
+}
+
+void RenderQueue::Add(entt::entity entity) {
+	if (myEntryIndices.find(entity) != myEntryIndices.end())
+		return;
+
+	myEntryIndices[entity] = (uint32_t)myEntries.size();
+	myEntries.push_back({ entity, nullptr, 0, false, 0, 0 });
+}
+
+uint16_t RenderQueue::GetId(std::unordered_map<const void*, uint16_t>& ids, const void* object, uint16_t limit) {
+	auto it = ids.find(object);
+	if (it != ids.end())
+		return it->second;
+
+	// Past the limit, everything shares the last id and is only grouped by depth
+	uint16_t id = (uint16_t)std::min(ids.size(), (size_t)limit);
+	ids[object] = id;
+	return id;
+}
+
+void RenderQueue::PackState(Entry& entry, const Renderable& renderable) {
+	entry.Material = renderable.Material.get();
+	entry.Blended = renderable.Material->RasterState.Blending.BlendEnabled;
+
+	uint64_t shader = GetId(myShaderIds, renderable.Material->GetShader().get(), 0x7FFF);
+	uint64_t material = GetId(myMaterialIds, renderable.Material.get(), 0xFFFF);
+	entry.StateKey = entry.Blended ?
+		((1ull << 63) | (shader << 16) | material) :
+		((shader << 48) | (material << 32));
+}
+
+void RenderQueue::Build(entt::registry& registry, const WorldTransforms& transforms, const glm::mat4& view, const std::vector<entt::entity>* visible, JobSystem* jobs) {
+	myBuild++;
+
+	// Last frame's items go first, in the order they were sorted into, so the sort has less to do. Until the keys
+	// are packed, each item's key holds where its entry is
+	size_t count = 0;
+	for (Item& item : myItems) {
+		auto it = myEntryIndices.find(item.Entity);
+		if (it != myEntryIndices.end()) {
+			myEntries[it->second].Listed = myBuild;
+			myItems[count++] = { it->second, item.Entity };
+		}
+	}
+	myItems.resize(count);
+
+	// Anything new this frame, or left out last frame, goes on the end in the order it was added
+	if (myItems.size() < myEntries.size()) {
+		for (size_t i = 0; i < myEntries.size(); i++) {
+			if (myEntries[i].Listed != myBuild)
+				myItems.push_back({ i, myEntries[i].Entity });
+		}
+	}
+
+	if (visible != nullptr) {
+		for (entt::entity entity : *visible) {
+			auto it = myEntryIndices.find(entity);
+			if (it != myEntryIndices.end())
+				myEntries[it->second].Visible = myBuild;
+		}
+	}
+
+	// Measure the depths and pack the keys, each item only touches its own entry so they can be split over threads
+	glm::vec4 depthRow = glm::vec4(view[0][2], view[1][2], view[2][2], view[3][2]);
+	RenderableView renderables = registry.view<Renderable>();
+	myKeyStates.resize(myItems.size());
+	if (jobs != nullptr) {
+		jobs->ParallelFor((uint32_t)myItems.size(), KEY_GRAIN, [&](uint32_t begin, uint32_t end, uint32_t thread) {
+			PackKeys(renderables, transforms, depthRow, visible != nullptr, begin, end);
+		});
+	}
+	else
+		PackKeys(renderables, transforms, depthRow, visible != nullptr, 0, (uint32_t)myItems.size());
+
+	// Then drop everything that won't be drawn, and repack any keys whose material changed
+	count = 0;
+	for (size_t i = 0; i < myItems.size(); i++) {
+		if (myKeyStates[i] == KeySkipped)
+			continue;
+		if (myKeyStates[i] == KeyStale) {
+			Entry& entry = myEntries[myItems[i].SortKey];
+			PackState(entry, renderables.get<Renderable>(entry.Entity));
+			myItems[i].SortKey = PackKey(entry, depthRow, transforms.GetWorld(entry.Entity));
+		}
+		myItems[count++] = myItems[i];
+	}
+	myItems.resize(count);
+
+	Sort();
+}
+
+void RenderQueue::PackKeys(const RenderableView& renderables, const WorldTransforms& transforms, const glm::vec4& depthRow, bool filtered, uint32_t begin, uint32_t end) {
+	for (uint32_t i = begin; i < end; i++) {
+		Entry& entry = myEntries[myItems[i].SortKey];
+		if (filtered && entry.Visible != myBuild) {
+			myKeyStates[i] = KeySkipped;
+			continue;
+		}
+		const Renderable& renderable = renderables.get<Renderable>(entry.Entity);
+		if (renderable.Mesh == nullptr || renderable.Material == nullptr) {
+			entry.Material = nullptr;
+			myKeyStates[i] = KeySkipped;
+			continue;
+		}
+		if (entry.Material != renderable.Material.get()) {
+			myKeyStates[i] = KeyStale;
+			continue;
+		}
+
+		myItems[i].SortKey = PackKey(entry, depthRow, transforms.GetWorld(entry.Entity));
+		myKeyStates[i] = KeyPacked;
+	}
+}
+
+uint64_t RenderQueue::PackKey(const Entry& entry, const glm::vec4& depthRow, const glm::mat4& world) {
+	// The view space z of the object's origin, negated so further away is bigger
+	float depth = -glm::dot(depthRow, world[3]);
+	uint64_t depthBits = DepthBits(depth);
+
+	return entry.Blended ?
+		(entry.StateKey | ((uint64_t)(~(uint32_t)depthBits) << 31)) :
+		(entry.StateKey | depthBits);
+}
+
+void RenderQueue::Sort() {
+	// Try an insertion sort first, which finishes quickly when the order barely changed since last frame
+	size_t shifts = 0;
+	size_t maxShifts = myItems.size() < INSERTION_SORT_LIMIT ? SIZE_MAX : myItems.size() * NEARLY_SORTED_SHIFTS;
+	size_t sorted = 1;
+	for (; sorted < myItems.size() && shifts <= maxShifts; sorted++) {
+		Item item = myItems[sorted];
+		size_t j = sorted;
+		for (; j > 0 && myItems[j - 1].SortKey > item.SortKey; j--) {
+			myItems[j] = myItems[j - 1];
+			shifts++;
+		}
+		myItems[j] = item;
+	}
+	if (sorted >= myItems.size())
+		return;
+
+	// Too much moved, so fall back to an LSD radix sort. Digits every item shares are skipped, which is most of the
+	// shader and material bits in a scene with only a few of each
+	myScratch.resize(myItems.size());
+	for (int shift = 0; shift < 64; shift += RADIX_BITS) {
+		uint32_t counts[RADIX_MASK + 1] = { };
+		for (const Item& item : myItems)
+			counts[(item.SortKey >> shift) & RADIX_MASK]++;
+		if (counts[(myItems[0].SortKey >> shift) & RADIX_MASK] == myItems.size())
+			continue;
+
+		uint32_t offset = 0;
+		for (uint32_t& bucket : counts) {
+			uint32_t next = offset + bucket;
+			bucket = offset;
+			offset = next;
+		}
+		for (const Item& item : myItems)
+			myScratch[counts[(item.SortKey >> shift) & RADIX_MASK]++] = item;
+		myItems.swap(myScratch);
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <utility>
+#include <GLM/glm.hpp>
+#include "florp/game/SceneManager.h"
+#include "florp/game/RenderableComponent.h"
+#include "WorldTransforms.h"
+#include "JobSystem.h"
+
+/*
+ * A persistent, sorted list of the renderables in a scene. Each item gets a 64 bit key packed from its blend state,
+ * shader, material and depth, so sorting the whole list is just sorting integers, and drawing it in order binds each
+ * shader and material as few times as possible.
+ *
+ * Renderables are added and removed as they are constructed and destroyed, without touching the rest of the list.
+ * Sort keys are only repacked for renderables whose material has changed, and the list is sorted once per Build,
+ * starting from the order it was left in last frame.
+ */
+class RenderQueue {
+public:
+	// Key layout for opaque items, front to back inside each material:
+	//   [63] blend (0) | [62..48] shader | [47..32] material | [31..0] view depth
+	// Blended items are drawn back to front over everything opaque, then grouped by state:
+	//   [63] blend (1) | [62..31] inverted view depth | [30..16] shader | [15..0] material
+	struct Item {
+		uint64_t     SortKey;
+		entt::entity Entity;
+	};
+
+	// Starts tracking the renderables in the registry, including the ones that already exist
+	void Connect(entt::registry& registry);
+	// Stops tracking, and forgets everything in the queue
+	void Disconnect(entt::registry& registry);
+
+	/*
+	 * Repacks the keys for the given view and sorts the queue, renderables without a mesh or material are left out
+	 * @param registry The registry that was connected
+	 * @param transforms The world transforms, already updated for this frame
+	 * @param view The view matrix the depths are measured in
+	 * @param visible If given, only these renderables are put in the queue (see VisibilityComponent)
+	 * @param jobs If given, the depths and keys are worked out on its threads
+	 */
+	void Build(entt::registry& registry, const WorldTransforms& transforms, const glm::mat4& view, const std::vector<entt::entity>* visible = nullptr, JobSystem* jobs = nullptr);
+
+	// The renderables to draw, in order, as of the last Build
+	const std::vector<Item>& GetItems() const { return myItems; }
+	// How many renderables are tracked, including ones that can't be drawn yet
+	size_t GetTrackedCount() const { return myEntries.size(); }
+
+private:
+	struct Entry {
+		entt::entity Entity;
+		const void*  Material;   // what StateKey was packed for, so we notice when the material is swapped out
+		uint64_t     StateKey;   // the key without the depth, for opaque items
+		bool         Blended;
+		uint32_t     Listed;     // the last Build this entry was in myItems for
+		uint32_t     Visible;    // the last Build this entry was visible in
+	};
+
+	// What the key pass left for each item, since new state keys can only be packed on the calling thread
+	enum KeyState : uint8_t {
+		KeyPacked,  // the item's key is ready
+		KeySkipped, // the item can't be drawn, or isn't visible
+		KeyStale    // the material changed, so the key still holds the entry index
+	};
+
+	// Looking components up through a view never touches the registry's pools, so it's safe from any thread
+	typedef decltype(std::declval<entt::registry&>().view<florp::game::RenderableComponent>()) RenderableView;
+
+	void OnConstruct(entt::entity entity, entt::registry& registry, const florp::game::RenderableComponent& renderable);
+	void OnDestroy(entt::entity entity, entt::registry& registry);
+	void Add(entt::entity entity);
+	void PackState(Entry& entry, const florp::game::RenderableComponent& renderable);
+	uint16_t GetId(std::unordered_map<const void*, uint16_t>& ids, const void* object, uint16_t limit);
+	// Measures the depths and packs the keys for a range of items, any that need a new state key are marked stale
+	void PackKeys(const RenderableView& renderables, const WorldTransforms& transforms, const glm::vec4& depthRow, bool filtered, uint32_t begin, uint32_t end);
+	static uint64_t PackKey(const Entry& entry, const glm::vec4& depthRow, const glm::mat4& world);
+	void Sort();
+
+	std::vector<Entry> myEntries;
+	std::unordered_map<entt::entity, uint32_t> myEntryIndices; // where each entity is in myEntries
+
+	// Shaders and materials get small ids the first time they are seen, so they fit in the key
+	std::unordered_map<const void*, uint16_t> myShaderIds;
+	std::unordered_map<const void*, uint16_t> myMaterialIds;
+
+	uint32_t myBuild = 0; // counts up every Build, for marking entries
+
+	std::vector<Item> myItems;
+	std::vector<KeyState> myKeyStates; // one per item in myItems, during Build
+	std::vector<Item> myScratch; // the other half of each radix pass
+};
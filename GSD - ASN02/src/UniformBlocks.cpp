@@ -0,0 +1,52 @@
+#include "UniformBlocks.h"
+
+// We can extract the near and far planes by reversing the projection calculation
+static void ExtractClipPlanes(const glm::mat4& projection, float& nearPlane, float& farPlane) {
+	float m22 = projection[2][2];
+	float m32 = projection[3][2];
+	nearPlane = (2.0f * m32) / (2.0f * m22 - 2.0f);
+	farPlane = ((m22 - 1.0f) * nearPlane) / (m22 + 1.0f);
+}
+
+CameraBlock CameraBlock::FromView(const glm::mat4& view, const glm::mat4& projection, const glm::vec2& resolution, float time) {
+	CameraBlock result;
+	result.View = view;
+	result.Projection = projection;
+	result.ViewProjection = projection * view;
+	result.ViewInv = glm::inverse(view);
+	result.ProjectionInv = glm::inverse(projection);
+	// (P * V)^-1 = V^-1 * P^-1, which saves a third general inverse
+	result.ViewProjectionInv = result.ViewInv * result.ProjectionInv;
+
+	result.PrevView = result.View;
+	result.PrevProjection = result.Projection;
+	result.PrevViewProjection = result.ViewProjection;
+	result.PrevProjectionInv = result.ProjectionInv;
+	result.PrevViewProjectionInv = result.ViewProjectionInv;
+
+	result.CameraPos = glm::vec3(result.ViewInv[3]);
+	result.Time = time;
+	ExtractClipPlanes(projection, result.NearPlane, result.FarPlane);
+	result.OutputResolution = resolution;
+	return result;
+}
+
+CameraBlock CameraBlock::FromFrameState(const AppFrameState& state, const glm::vec2& resolution, float time) {
+	CameraBlock result = FromView(state.Current.View, state.Current.Projection, resolution, time);
+
+	result.PrevView = state.Last.View;
+	result.PrevProjection = state.Last.Projection;
+	result.PrevViewProjection = state.Last.ViewProjection;
+	result.PrevProjectionInv = glm::inverse(state.Last.Projection);
+	result.PrevViewProjectionInv = glm::inverse(state.Last.View) * result.PrevProjectionInv;
+	return result;
+}
+
+ObjectBlock ObjectBlock::FromWorld(const glm::mat4& world, const glm::mat3& normalMatrix) {
+	ObjectBlock result;
+	result.Model = world;
+	result.NormalMatrix[0] = glm::vec4(normalMatrix[0], 0.0f);
+	result.NormalMatrix[1] = glm::vec4(normalMatrix[1], 0.0f);
+	result.NormalMatrix[2] = glm::vec4(normalMatrix[2], 0.0f);
+	return result;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <GLM/glm.hpp>
+#include <cstdint>
+#include "FrameState.h"
+
+/*
+ * The uniform blocks shared by our shaders, laid out to match std140. Every shader that uses one declares it with
+ * the same members at the same binding point, so they can be filled in once and bound by range out of a
+ * UniformRing, instead of setting each uniform by name on each shader.
+ */
+enum UniformBinding : uint32_t {
+	CameraBinding = 0,
+	ObjectBinding = 1,
+	LightBinding  = 2
+};
+
+/*
+ * The camera the current pass is drawn from, with all the inverses worked out up front:
+ *
+ * layout(std140, binding = 0) uniform CameraBlock {
+ *     mat4  a_View, a_Projection, a_ViewProjection;
+ *     mat4  a_ViewInv, a_ProjectionInv, a_ViewProjectionInv;
+ *     mat4  a_PrevView, a_PrevProjection, a_PrevViewProjection;
+ *     mat4  a_PrevProjectionInv, a_PrevViewProjectionInv;
+ *     vec3  a_CameraPos;
+ *     float a_Time;
+ *     float a_NearPlane;
+ *     float a_FarPlane;
+ *     vec2  a_OutputResolution;
+ * };
+ */
+struct CameraBlock {
+	glm::mat4 View;
+	glm::mat4 Projection;
+	glm::mat4 ViewProjection;
+	glm::mat4 ViewInv;
+	glm::mat4 ProjectionInv;
+	glm::mat4 ViewProjectionInv;
+	glm::mat4 PrevView;
+	glm::mat4 PrevProjection;
+	glm::mat4 PrevViewProjection;
+	glm::mat4 PrevProjectionInv;
+	glm::mat4 PrevViewProjectionInv;
+	glm::vec3 CameraPos;
+	float     Time;
+	float     NearPlane;
+	float     FarPlane;
+	glm::vec2 OutputResolution;
+
+	/*
+	 * Fills in a block for a single view, with no previous frame to speak of
+	 * @param view The view matrix (world->view)
+	 * @param projection The projection matrix (view->clip)
+	 * @param resolution The size of the target being rendered to
+	 * @param time The game time, for animated shaders
+	 */
+	static CameraBlock FromView(const glm::mat4& view, const glm::mat4& projection, const glm::vec2& resolution, float time);
+	/*
+	 * Fills in a block for the main camera, including last frame's matrices
+	 * @param state The frame state, as left by the render layer
+	 * @param resolution The size of the main camera's output
+	 * @param time The game time, for animated shaders
+	 */
+	static CameraBlock FromFrameState(const AppFrameState& state, const glm::vec2& resolution, float time);
+};
+
+/*
+ * The object being drawn, when it isn't instanced:
+ *
+ * layout(std140, binding = 1) uniform ObjectBlock {
+ *     mat4 a_Model;
+ *     mat3 a_NormalMatrix;
+ * };
+ */
+struct ObjectBlock {
+	glm::mat4 Model;
+	glm::vec4 NormalMatrix[3]; // std140 pads each column of a mat3 out to a vec4
+
+	static ObjectBlock FromWorld(const glm::mat4& world, const glm::mat3& normalMatrix);
+};
+
+/*
+ * The light being composited:
+ *
+ * layout(std140, binding = 2) uniform LightBlock {
+ *     mat4  a_LightView;
+ *     vec3  a_LightPos;
+ *     float a_LightAttenuation;
+ *     vec3  a_LightDir;
+ *     float a_ProjectorIntensity;
+ *     vec3  a_LightColor;
+ *     bool  b_IsProjector;
+ * };
+ */
+struct LightBlock {
+	glm::mat4 LightView;
+	glm::vec3 LightPos;
+	float     LightAttenuation;
+	glm::vec3 LightDir;
+	float     ProjectorIntensity;
+	glm::vec3 LightColor;
+	uint32_t  IsProjector; // bools are 4 bytes in std140
+};
+
+// Any padding the compiler sneaks in would throw the blocks out of line with the shaders
+static_assert(sizeof(CameraBlock) == 736, "CameraBlock must match the std140 layout");
+static_assert(sizeof(ObjectBlock) == 112, "ObjectBlock must match the std140 layout");
+static_assert(sizeof(LightBlock) == 112, "LightBlock must match the std140 layout");
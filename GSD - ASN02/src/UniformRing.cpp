@@ -0,0 +1,75 @@
+#include "UniformRing.h"
+#include "Logging.h"
+#include <cstring>
+
+// How long to wait on a fence before giving up, in nanoseconds
+static const GLuint64 FENCE_TIMEOUT = 1000000000;
+
+UniformRing::UniformRing(uint32_t size) :
+	myRendererID(0),
+	myMapping(nullptr),
+	myCapacity(size),
+	myAlignment(256),
+	myCursor(0),
+	mySegment(0),
+	myFrameCamera()
+{
+	for (int ix = 0; ix < SEGMENTS; ix++)
+		myFences[ix] = nullptr;
+
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment > 0)
+		myAlignment = (uint32_t)alignment;
+
+	// The mapping stays valid for as long as the buffer exists, and coherent means we never have to flush it
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &myRendererID);
+	glNamedBufferStorage(myRendererID, myCapacity, nullptr, flags);
+	myMapping = (uint8_t*)glMapNamedBufferRange(myRendererID, 0, myCapacity, flags);
+}
+
+UniformRing::~UniformRing() {
+	for (int ix = 0; ix < SEGMENTS; ix++) {
+		if (myFences[ix] != nullptr)
+			glDeleteSync(myFences[ix]);
+	}
+	glUnmapNamedBuffer(myRendererID);
+	glDeleteBuffers(1, &myRendererID);
+}
+
+GLintptr UniformRing::Push(const void* data, uint32_t size) {
+	uint32_t segmentSize = myCapacity / SEGMENTS;
+	LOG_ASSERT(size <= segmentSize, "Uniform block is bigger than a segment of the ring!");
+
+	// Line the block up, and go back to the start if it won't fit before the end
+	uint32_t offset = (myCursor + myAlignment - 1) / myAlignment * myAlignment;
+	if (offset + size > myCapacity)
+		offset = 0;
+
+	// Moving on to another segment, so fence off everything that reads from this one, and make sure the GPU is
+	// done with the ones we're about to write over
+	int segment = (int)((offset + size - 1) / segmentSize);
+	if (segment != mySegment || offset < myCursor) {
+		if (myFences[mySegment] == nullptr)
+			myFences[mySegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		do {
+			mySegment = (mySegment + 1) % SEGMENTS;
+			if (myFences[mySegment] != nullptr) {
+				GLenum result = glClientWaitSync(myFences[mySegment], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+				if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED)
+					LOG_WARN("Timed out waiting for uniform ring segment {}", mySegment);
+				glDeleteSync(myFences[mySegment]);
+				myFences[mySegment] = nullptr;
+			}
+		} while (mySegment != segment);
+	}
+
+	memcpy(myMapping + offset, data, size);
+	myCursor = offset + size;
+	return offset;
+}
+
+void UniformRing::BindRange(uint32_t binding, GLintptr offset, uint32_t size) {
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, myRendererID, offset, size);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include "UniformBlocks.h"
+
+/*
+ * A persistently mapped ring of uniform data. Blocks are copied in one after the other and bound by range, so each
+ * draw's uniforms cost a memcpy and a single bind instead of a lookup by name per uniform.
+ *
+ * The ring is split into segments, and a fence is placed whenever writing moves on from one. Coming back around
+ * to a segment waits on its fence, which only blocks if the GPU is a whole ring's worth of draws behind.
+ *
+ * There's one per scene, kept in the registry's context.
+ */
+class UniformRing {
+public:
+	/*
+	 * Creates a new uniform ring
+	 * @param size The size of the ring in bytes, no single block can be bigger than a segment of it
+	 */
+	UniformRing(uint32_t size = 4 * 1024 * 1024);
+	~UniformRing();
+
+	UniformRing(const UniformRing& other) = delete;
+	UniformRing& operator=(const UniformRing& other) = delete;
+
+	/*
+	 * Copies some data into the ring
+	 * @param data The data to copy
+	 * @param size The size of the data in bytes
+	 * @returns The offset the data was copied to
+	 */
+	GLintptr Push(const void* data, uint32_t size);
+
+	// Binds a range of the ring to a uniform buffer binding point
+	void BindRange(uint32_t binding, GLintptr offset, uint32_t size);
+
+	// Copies a block into the ring and binds it, for the draws that follow
+	template <typename T>
+	void Bind(UniformBinding binding, const T& block) {
+		BindRange(binding, Push(&block, sizeof(T)), sizeof(T));
+	}
+
+	// Remembers the main camera's block for this frame, so the passes after rendering don't have to rebuild it
+	void SetFrameCamera(const CameraBlock& camera) { myFrameCamera = camera; }
+	// Binds the main camera's block, as set by the render layer
+	void BindFrameCamera() { Bind(CameraBinding, myFrameCamera); }
+
+private:
+	static const int SEGMENTS = 8;
+
+	GLuint   myRendererID;
+	uint8_t* myMapping;
+	uint32_t myCapacity;
+	uint32_t myAlignment; // blocks have to start on a multiple of this
+	uint32_t myCursor;    // where the next block goes
+	int      mySegment;   // the segment the cursor is in
+	GLsync   myFences[SEGMENTS];
+
+	CameraBlock myFrameCamera;
+};
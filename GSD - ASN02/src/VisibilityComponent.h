@@ -0,0 +1,13 @@
+#pragma once
+#include <vector>
+#include "florp/game/SceneManager.h"
+
+/*
+ * The renderables inside a camera's or shadow light's frustum, worked out by the culling layer before anything is
+ * rendered. The render and lighting layers only draw what is in here.
+ */
+struct VisibilityComponent {
+	std::vector<entt::entity> Visible;
+	// How many renderables were left out of Visible
+	int Culled = 0;
+};
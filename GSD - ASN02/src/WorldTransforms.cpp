@@ -0,0 +1,57 @@
+#include "WorldTransforms.h"
+#include <florp\game\Transform.h>
+#include <cstring>
+#include <algorithm>
+
+// What an entity without a slot gets, rather than reading past the end of the arrays
+static const glm::mat4 IDENTITY = glm::mat4(1.0f);
+static const glm::mat3 IDENTITY_NORMAL = glm::mat3(1.0f);
+
+int WorldTransforms::Update(entt::registry& registry) {
+	using namespace florp::game;
+
+	int recalculated = 0;
+	registry.view<Transform>().each([&](auto entity, Transform& transform) {
+		uint32_t index = Index(entity);
+		if (index >= myEntities.size()) {
+			size_t size = std::max((size_t)index + 1, myEntities.size() * 2);
+			myEntities.resize(size, entt::null);
+			myWorlds.resize(size, IDENTITY);
+			myNormals.resize(size, IDENTITY_NORMAL);
+			myVersions.resize(size, 0);
+		}
+
+		// Florp has already applied any parents, we only have to notice when the result changed
+		const glm::mat4& world = transform.GetWorldTransform();
+		bool dirty = myEntities[index] != entity;
+		dirty |= memcmp(&world, &myWorlds[index], sizeof(glm::mat4)) != 0;
+		if (!dirty)
+			return;
+
+		myEntities[index] = entity;
+		myWorlds[index] = world;
+		// Our normal matrix is the inverse-transpose of the world rotation
+		myNormals[index] = glm::mat3(glm::transpose(glm::inverse(world)));
+		myVersions[index]++;
+		recalculated++;
+	});
+
+	return recalculated;
+}
+
+bool WorldTransforms::Contains(entt::entity entity) const {
+	uint32_t index = Index(entity);
+	return index < myEntities.size() && myEntities[index] == entity;
+}
+
+const glm::mat4& WorldTransforms::GetWorld(entt::entity entity) const {
+	return Contains(entity) ? myWorlds[Index(entity)] : IDENTITY;
+}
+
+const glm::mat3& WorldTransforms::GetNormalMatrix(entt::entity entity) const {
+	return Contains(entity) ? myNormals[Index(entity)] : IDENTITY_NORMAL;
+}
+
+uint32_t WorldTransforms::GetVersion(entt::entity entity) const {
+	return Contains(entity) ? myVersions[Index(entity)] : 0;
+}
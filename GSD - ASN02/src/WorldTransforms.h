@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+#include "florp/game/SceneManager.h"
+
+/*
+ * The world and normal matrices of every entity with a transform, gathered once per frame by the transform layer
+ * and kept in arrays indexed by entity. The render and lighting passes read from here instead of asking each
+ * Transform, so nothing has to invert a matrix per draw.
+ *
+ * The world transforms come straight from florp, parenting included, so this is the same hierarchy everything else
+ * (like the audio layer) sees. Only the entities whose world transform changed get a new normal matrix and version,
+ * so static geometry costs one comparison a frame.
+ */
+class WorldTransforms {
+public:
+	/*
+	 * Brings every entity's matrices up to date
+	 * @param registry The registry to read transforms from
+	 * @returns The number of entities that were recalculated
+	 */
+	int Update(entt::registry& registry);
+
+	// The entity's world transform, as of the last Update
+	const glm::mat4& GetWorld(entt::entity entity) const;
+	// The inverse transpose of the entity's world transform, for transforming normals
+	const glm::mat3& GetNormalMatrix(entt::entity entity) const;
+	// Changes whenever the entity's world transform does, so other systems can tell when to refresh what they cache
+	uint32_t GetVersion(entt::entity entity) const;
+
+	// How many entities the arrays have room for
+	size_t GetCapacity() const { return myEntities.size(); }
+
+private:
+	static uint32_t Index(entt::entity entity) { return (uint32_t)entt::registry::entity(entity); }
+	bool Contains(entt::entity entity) const;
+
+	std::vector<entt::entity> myEntities; // what is in each slot, so a recycled index is noticed
+	std::vector<glm::mat4>    myWorlds;
+	std::vector<glm::mat3>    myNormals;
+	std::vector<uint32_t>     myVersions;
+};
@@ -3,6 +3,16 @@
 #include "florp/app/Application.h"
 #include "florp/app/Window.h"
 #include "florp/app/Timing.h"
+#include "florp/game/SceneManager.h"
+#include "florp/game/Transform.h"
+#include "florp/game/RenderableComponent.h"
+#include "AudioListenerComponent.h"
+#include "AudioEmitterComponent.h"
+#include "Easing.h"
+#include "AudioPathComponent.h"
+#include "AudioOccluderComponent.h"
+#include <imgui.h>
+#include <algorithm>
 
 void AudioLayer::Initialize()
 {
@@ -10,11 +20,24 @@ void AudioLayer::Initialize()
 	AudioEngine& audioEngine = AudioEngine::GetInstance();
 
 	audioEngine.Init(); // getting the singleton.
-	audioEngine.LoadBank("Master");
 
-	audioEngine.LoadEvent(audioEvent);
-	// audioEngine.PlayEvent(audioEvent);
-	AudioEngine::GetInstance().SetEventPosition(audioEvent, startPos);
+	// the bank (and the event's samples) load in the background so we don't hold up the first frame.
+	// the event gets loaded in Update once the bank is ready.
+	bankTicket = audioEngine.LoadBankAsync("Master", { audioEvent });
+
+	// fills the graphs in the profiler window
+	audioEngine.SetProfilingEnabled(true);
+
+	// only a few voices are traced against the scene each frame, the rest catch up over the next few
+	audioEngine.SetOcclusionSettings(8);
+
+	// x is left/right, y is up/down, z is in/out of the screen.
+	// this is assuming that the camera orientation is its default, which it may not be.
+	// the car eases in from just left of the camera, and the ending crash starts 11 seconds in.
+	audioPath = MotionPath({
+		{ 0.0F, glm::vec3(-1.0F, 0.0F, 0.0F), Easing::Curve::EaseIn },
+		{ 11.0F, glm::vec3(15.0F, 0.0F, 0.0F) }
+	});
 }
 
 void AudioLayer::Shutdown()
@@ -28,28 +51,24 @@ void AudioLayer::Shutdown()
 float AudioLayer::Lerp(float a, float b, float u) { return glm::mix(a, b, u); }
 
 // ease in interpolation. The higher the exponent, the greater the ease in and steeper the curve.
-// see the reference for comparisons
+// see the reference for comparisons. the curves themselves are in Easing.h.
 float AudioLayer::EaseInLerp(float a, float b, float u)
 {
-	// y = x^n
-	return glm::mix(a, b, powf(u, 5));
+	// y = x^5
+	return Easing::Lerp(Easing::Curve::EaseIn, a, b, u);
 }
 
 // ease out interpolation
 float AudioLayer::EaseOutLerp(float a, float b, float u)
 {
-	// y = 1 - (1 - x)^n
-	return glm::mix(a, b, 1.0F - powf(1.0F - u, 8));
+	// y = 1 - (1 - x)^8
+	return Easing::Lerp(Easing::Curve::EaseOut, a, b, u);
 }
 
 // ease in and out
 float AudioLayer::EaseInOutLerp(float a, float b, float u)
 {
-	float t = (u < 0.5F) ? 
-		128.0F * (pow(u,8)) :
-		0.5F + (1.0F - powf((2.0F * (1.0F - u)), 8)) / 2.0F;
-
-	return glm::mix(a, b, t);
+	return Easing::Lerp(Easing::Curve::EaseInOut, a, b, u);
 }
 
 void AudioLayer::Update()
@@ -60,47 +79,235 @@ void AudioLayer::Update()
 	float deltaTime = Timing::DeltaTime;
 	AudioEngine& audioEngine = AudioEngine::GetInstance();
 
+	// load the event once the bank has finished loading
+	if (audioEventHandle == INVALID_EVENT_HANDLE && audioEngine.IsLoadComplete(bankTicket))
+	{
+		audioEventHandle = audioEngine.LoadEvent(audioEvent);
+		audioEngine.SetEventPosition(audioEventHandle, audioPath.Sample(0.0F));
+	}
+
 	// key presses
 	{
 		// plays the event
 		if (window->IsKeyDown(Key::P))
 		{
-			audioEngine.PlayEvent(audioEvent);
-			playing = true;
-
-			elapsedTime = 0.0F;
-			u = 0.0F; // time value
-			currPos = glm::vec3();
+			audioVoiceHandle = audioEngine.PlayEvent(audioEventHandle);
+			audioEngine.TrackTimelinePosition(audioVoiceHandle);
 		}
 	}
 
-	// checks to see if the event is still playing
-	// this function doesn't work for some reason.
-	// playing = audioEngine.isEventPlaying(audioEvent);
-	// std::cout << playing << std::endl;
-
-	// if the audio is playing
-	if (playing)
+	// the car follows the event's own timeline, so it always hits the wall when the crash plays.
+	// the path holds at the wall once it gets there.
+	if (audioEngine.isEventPlaying(audioVoiceHandle))
 	{
-		elapsedTime += deltaTime;
-		// startup is 3 seconds (whole effect is 3.5 seconds)
-		// ending crash starts 11 seconds in
+		audioEngine.SetEventPosition(audioVoiceHandle, audioPath.Sample(audioEngine.GetTimelinePosition(audioVoiceHandle)));
+	}
+
+	UpdateListeners();
+	UpdatePaths(deltaTime);
+	UpdateEmitters();
+	UpdateOccluders();
+
+	audioEngine.Update();
+}
+
+void AudioLayer::UpdateListeners()
+{
+	using namespace florp::game;
+
+	// one pass over every listener in the scene. the behaviour layer has already moved them this frame.
+	int count = 0;
+	CurrentRegistry().view<AudioListenerComponent, Transform>().each([&](auto entity, AudioListenerComponent& listener, Transform& transform) {
+		if (listener.Index < 0 || listener.Index >= FMOD_MAX_LISTENERS)
+			return;
+
+		if (listener.Index >= (int)listeners.size())
+			listeners.resize(listener.Index + 1);
+		count = std::max(count, listener.Index + 1);
 
-		// repositing; stops at 11 seconds.
-		// if (elapsedTime < 11000.0F)
-		if (u < 1.0F) // crashed into wall
+		// world space, so listeners parented to something (like a car) are heard from the right place
+		const glm::mat4& world = transform.GetWorldTransform();
+		ListenerAttributes& attributes = listeners[listener.Index];
+		attributes.vPosition = glm::vec3(world * glm::vec4(0, 0, 0, 1));
+		attributes.vForward = glm::normalize(glm::mat3(world) * glm::vec3(0, 0, -1));
+		attributes.vUp = glm::normalize(glm::mat3(world) * glm::vec3(0, 1, 0));
+	});
+
+	if (count > 0)
+		AudioEngine::GetInstance().SetListeners(listeners.data(), count);
+}
+
+void AudioLayer::UpdatePaths(float deltaTime)
+{
+	using namespace florp::game;
+
+	AudioEngine& audioEngine = AudioEngine::GetInstance();
+	CurrentRegistry().view<AudioPathComponent, Transform>().each([&](auto entity, AudioPathComponent& path, Transform& transform) {
+		if (!path.Path)
+			return;
+
+		if (path.SyncEvent != INVALID_EVENT_HANDLE)
 		{
-			// currPos.x = EaseInLerp(startPos.x, endPos.x, u);
-			currPos.x = EaseInLerp(startPos.x, endPos.x, u);
-			u += U_INC * deltaTime;
-			AudioEngine::GetInstance().SetEventPosition(audioEvent, currPos);
+			// only ask the engine to track the timeline when the voice changes, not every frame
+			if (path.TrackedEvent != path.SyncEvent)
+			{
+				audioEngine.TrackTimelinePosition(path.SyncEvent);
+				path.TrackedEvent = path.SyncEvent;
+			}
+			path.Time = audioEngine.GetTimelinePosition(path.SyncEvent) * path.Speed;
 		}
 		else
 		{
-			playing = false;
-			// std::cout << "STOP" << std::endl;
+			path.Time += path.Speed * deltaTime;
 		}
+
+		transform.SetPosition(path.Origin + path.Path->Sample(path.Time, path.Loop));
+	});
+}
+
+void AudioLayer::UpdateEmitters()
+{
+	using namespace florp::game;
+
+	autoVelocityEmitters.clear();
+	fixedVelocityEmitters.clear();
+
+	// one pass over every emitter, the positions end up packed together for the engine
+	CurrentRegistry().view<AudioEmitterComponent, Transform>().each([&](auto entity, AudioEmitterComponent& emitter, Transform& transform) {
+		if (emitter.Event == INVALID_EVENT_HANDLE)
+			return;
+
+		EmitterBatch& batch = emitter.AutoVelocity ? autoVelocityEmitters : fixedVelocityEmitters;
+		batch.events.push_back(emitter.Event);
+		batch.positions.push_back(glm::vec3(transform.GetWorldTransform() * glm::vec4(emitter.Offset, 1.0F)));
+		batch.velocities.push_back(emitter.Velocity);
+		batch.cullingRadii.push_back(emitter.CullingRadius);
+	});
+
+	autoVelocityEmitters.submit(true);
+	fixedVelocityEmitters.submit(false);
+}
+
+void AudioLayer::UpdateOccluders()
+{
+	using namespace florp::game;
+
+	occluders.clear();
+	CurrentRegistry().view<AudioOccluderComponent, RenderableComponent, Transform>().each([&](auto entity, AudioOccluderComponent& occluder,
+		RenderableComponent& renderable, Transform& transform) {
+		if (renderable.Mesh == nullptr)
+			return;
+
+		// the world box around the rotated local box, each axis of the matrix adds its smallest and largest reach
+		const glm::mat4& world = transform.GetWorldTransform();
+		OccluderBox box;
+		box.vMin = box.vMax = glm::vec3(world[3]);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			glm::vec3 a = glm::vec3(world[axis]) * occluder.Min[axis];
+			glm::vec3 b = glm::vec3(world[axis]) * occluder.Max[axis];
+			box.vMin += glm::min(a, b);
+			box.vMax += glm::max(a, b);
+		}
+		box.fStrength = occluder.Strength;
+		occluders.push_back(box);
+	});
+
+	// most frames nothing has moved, so the tree is left alone
+	bool changed = occluders.size() != sentOccluders.size();
+	for (size_t i = 0; i < occluders.size() && !changed; i++)
+	{
+		changed = occluders[i].vMin != sentOccluders[i].vMin || occluders[i].vMax != sentOccluders[i].vMax ||
+			occluders[i].fStrength != sentOccluders[i].fStrength;
 	}
 
-	audioEngine.Update();
+	if (changed)
+	{
+		AudioEngine::GetInstance().SetOcclusionGeometry(occluders.data(), (int)occluders.size());
+		sentOccluders = occluders;
+	}
+}
+
+void AudioLayer::EmitterBatch::clear()
+{
+	events.clear();
+	positions.clear();
+	velocities.clear();
+	cullingRadii.clear();
+}
+
+void AudioLayer::EmitterBatch::submit(bool autoVelocity) const
+{
+	if (events.empty())
+		return;
+
+	AudioEngine::GetInstance().SetEventPositions(events.data(), positions.data(), (int)events.size(),
+		autoVelocity ? nullptr : velocities.data(), cullingRadii.data());
+}
+
+void AudioLayer::RenderGUI()
+{
+	AudioEngine& audioEngine = AudioEngine::GetInstance();
+	audioEngine.GetProfile(profile);
+
+	ImGui::Begin("Audio Profiler");
+
+	bool profiling = audioEngine.IsProfilingEnabled();
+	if (ImGui::Checkbox("Record", &profiling))
+		audioEngine.SetProfilingEnabled(profiling);
+
+	if (profile.nCount == 0)
+	{
+		ImGui::Text("No frames recorded yet");
+		ImGui::End();
+		return;
+	}
+
+	// averages and peaks over the whole window
+	float averageTime = 0.0F;
+	float peakTime = 0.0F;
+	for (int i = 0; i < profile.nCount; i++)
+	{
+		averageTime += profile.Get(i).fUpdateTime;
+		peakTime = std::max(peakTime, profile.Get(i).fUpdateTime);
+	}
+	averageTime /= profile.nCount;
+
+	const AudioFrameStats& latest = profile.Latest();
+	ImGui::Text("Update: %.1fus (average %.1fus, peak %.1fus)", latest.fUpdateTime, averageTime, peakTime);
+	ImGui::Text("Backend calls: %d", latest.nBackendCalls);
+	ImGui::Text("Voices: %d loaded, %d real, %d virtual", latest.nLoadedVoices, latest.nRealVoices, latest.nVirtualVoices);
+	ImGui::Text("Channels: %d", latest.nActiveChannels);
+	ImGui::Text("FMOD CPU: %.1f%% dsp, %.1f%% stream, %.1f%% update, %.1f%% studio",
+		latest.cpuUsage.dspusage, latest.cpuUsage.streamusage, latest.cpuUsage.updateusage, latest.cpuUsage.studiousage);
+	ImGui::Text("FMOD memory: %.2fMB (peak %.2fMB)", latest.nMemoryCurrent / (1024.0F * 1024.0F), latest.nMemoryMax / (1024.0F * 1024.0F));
+	ImGui::Text("Sample data: %.2fMB resident", latest.nResidentSampleBytes / (1024.0F * 1024.0F));
+	ImGui::Text("Occlusion: %d voices traced", latest.nOcclusionRays);
+
+	// the graphs read straight out of the ring, oldest frame on the left
+	ImGui::PlotHistogram("Update (us)", [](void* data, int i) { return ((AudioProfile*)data)->Get(i).fUpdateTime; },
+		&profile, profile.nCount, 0, nullptr, 0.0F, FLT_MAX, ImVec2(0, 60));
+	ImGui::PlotHistogram("Backend calls", [](void* data, int i) { return (float)((AudioProfile*)data)->Get(i).nBackendCalls; },
+		&profile, profile.nCount, 0, nullptr, 0.0F, FLT_MAX, ImVec2(0, 60));
+	ImGui::PlotLines("Real voices", [](void* data, int i) { return (float)((AudioProfile*)data)->Get(i).nRealVoices; },
+		&profile, profile.nCount, 0, nullptr, 0.0F, FLT_MAX, ImVec2(0, 40));
+	ImGui::PlotLines("Virtual voices", [](void* data, int i) { return (float)((AudioProfile*)data)->Get(i).nVirtualVoices; },
+		&profile, profile.nCount, 0, nullptr, 0.0F, FLT_MAX, ImVec2(0, 40));
+	ImGui::PlotLines("FMOD CPU (%)", [](void* data, int i)
+		{
+			const AudioFrameStats& stats = ((AudioProfile*)data)->Get(i);
+			return stats.cpuUsage.dspusage + stats.cpuUsage.streamusage + stats.cpuUsage.updateusage;
+		},
+		&profile, profile.nCount, 0, nullptr, 0.0F, FLT_MAX, ImVec2(0, 40));
+
+	// exports the frames in the window, for tracking regressions offline
+	if (ImGui::Button("Export CSV"))
+		profileExported = audioEngine.ExportProfileCSV(profileFile);
+	if (profileExported)
+	{
+		ImGui::SameLine();
+		ImGui::Text("Saved to %s", profileFile.c_str());
+	}
+
+	ImGui::End();
 }
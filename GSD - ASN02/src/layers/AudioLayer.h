@@ -15,7 +15,10 @@
 
 #include "florp/app/ApplicationLayer.h"
 #include "GLM/vec3.hpp"
+#include "AudioEngine.h"
+#include "MotionPath.h"
 #include <string>
+#include <vector>
 
 class AudioLayer : public florp::app::ApplicationLayer
 {
@@ -38,25 +41,56 @@ public:
 
 	void Update() override;
 
+	// profiler window, with graphs of the engine's update time and voice counts
+	void RenderGUI() override;
+
 private:
+	// sends the world transform of every AudioListenerComponent to the engine in one batch
+	void UpdateListeners();
+
+	// moves every entity with an AudioPathComponent along its path. runs before the emitters are gathered.
+	void UpdatePaths(float deltaTime);
+
+	// sends the world position of every AudioEmitterComponent to the engine, one batch per velocity mode
+	void UpdateEmitters();
+
+	// works out the world bounds of every AudioOccluderComponent, and rebuilds the engine's occlusion geometry if any moved
+	void UpdateOccluders();
+
 	// TODO: add play button for sound.
 	std::string audioEvent = "Car Crash"; // the event for the sound
-	float elapsedTime = 0.0F;
-	bool playing = false;
+	EventHandle audioEventHandle = INVALID_EVENT_HANDLE; // handle returned when the event is loaded
+	EventHandle audioVoiceHandle = INVALID_EVENT_HANDLE; // the voice that was last played
+	AudioLoadTicket bankTicket = INVALID_LOAD_TICKET; // the master bank loads in the background
+
+	// where the event moves while it plays, sampled at the event's timeline position
+	MotionPath audioPath;
+
+	// gathered from the scene every frame, indexed by AudioListenerComponent::Index
+	std::vector<ListenerAttributes> listeners;
 
-	// x is left/right, y is up/down, z is in/out of the screen.
-	// this is assuming that the camera orientation is its default, which it may not be.
+	// emitter positions gathered from the scene every frame, kept around so they don't reallocate
+	struct EmitterBatch
+	{
+		std::vector<EventHandle> events;
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> velocities;
+		std::vector<float> cullingRadii;
 
-	// start, end, and current position
-	glm::vec3 startPos = glm::vec3(-1.0F, 0.0F, 0.0F);
-	glm::vec3 endPos = glm::vec3(15.0F, 0.0F, 0.0F);
-	glm::vec3 currPos = glm::vec3();
+		void clear();
+		void submit(bool autoVelocity) const;
+	};
+	EmitterBatch autoVelocityEmitters;
+	EmitterBatch fixedVelocityEmitters;
 
-	// 'u' value for lerp.
-	float u = 0.0F;
+	// the occluders gathered this frame, and the ones the engine was last given
+	std::vector<OccluderBox> occluders;
+	std::vector<OccluderBox> sentOccluders;
 
-	// incrementer
-	const float U_INC = 0.09F;
+	// copied out of the engine every frame for the profiler window
+	AudioProfile profile;
+	std::string profileFile = "audio_profile.csv"; // where the profile is exported to
+	bool profileExported = false;
 
 protected:
 
@@ -0,0 +1,52 @@
+#include "CullingLayer.h"
+#include <florp\game\SceneManager.h>
+#include "CameraComponent.h"
+#include "ShadowLight.h"
+#include "VisibilityComponent.h"
+#include "WorldTransforms.h"
+#include <imgui.h>
+
+void CullingLayer::OnSceneEnter() {
+	myCuller.Connect(CurrentRegistry());
+}
+
+void CullingLayer::PreRender()
+{
+	auto& ecs = CurrentRegistry();
+
+	const WorldTransforms& transforms = ecs.ctx<WorldTransforms>();
+	myBoundsUpdated = myCuller.UpdateBounds(ecs, transforms);
+	int count = (int)myCuller.GetCount();
+
+	// Cameras and shadow lights both look down their transform, through their own projection
+	ecs.view<CameraComponent>().each([&](auto entity, CameraComponent& cam) {
+		VisibilityComponent& visibility = ecs.get_or_assign<VisibilityComponent>(entity);
+		myCuller.Cull(cam.Projection * glm::inverse(transforms.GetWorld(entity)), visibility.Visible);
+		visibility.Culled = count - (int)visibility.Visible.size();
+	});
+
+	ecs.view<ShadowLight>().each([&](auto entity, ShadowLight& light) {
+		VisibilityComponent& visibility = ecs.get_or_assign<VisibilityComponent>(entity);
+		myCuller.Cull(light.Projection * glm::inverse(transforms.GetWorld(entity)), visibility.Visible);
+		visibility.Culled = count - (int)visibility.Visible.size();
+	});
+}
+
+void CullingLayer::RenderGUI()
+{
+	auto& ecs = CurrentRegistry();
+
+	ImGui::Begin("Culling");
+	ImGui::Text("Renderables: %d (%d bounds updated)", (int)myCuller.GetCount(), myBoundsUpdated);
+
+	ecs.view<CameraComponent, VisibilityComponent>().each([&](auto entity, CameraComponent& cam, VisibilityComponent& visibility) {
+		ImGui::Text("%s camera: %d visible, %d culled", cam.IsMainCamera ? "Main" : "Other", (int)visibility.Visible.size(), visibility.Culled);
+	});
+
+	int lightIndex = 0;
+	ecs.view<ShadowLight, VisibilityComponent>().each([&](auto entity, ShadowLight& light, VisibilityComponent& visibility) {
+		ImGui::Text("Shadow light %d: %d visible, %d culled", lightIndex++, (int)visibility.Visible.size(), visibility.Culled);
+	});
+
+	ImGui::End();
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "florp/app/ApplicationLayer.h"
+#include "FrustumCuller.h"
+
+/*
+ * Works out what every camera and shadow light can see before anything is rendered, and stores it in a
+ * VisibilityComponent on each of them. Needs to be added after the transform layer, and before the render and
+ * lighting layers.
+ */
+class CullingLayer : public florp::app::ApplicationLayer
+{
+public:
+	virtual void OnSceneEnter() override;
+
+	// Updates the bounds of anything that moved, then culls against each camera and light
+	virtual void PreRender() override;
+
+	// Shows how much each view culled
+	virtual void RenderGUI() override;
+
+protected:
+	FrustumCuller myCuller;
+	// How many bounds were recalculated in the last update
+	int myBoundsUpdated = 0;
+};
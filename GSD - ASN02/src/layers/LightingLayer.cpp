@@ -4,9 +4,13 @@
 #include <florp\game\RenderableComponent.h>
 #include <ShadowLight.h>
 #include "florp/app/Application.h"
+#include <florp\app\Timing.h>
 #include "FrameState.h"
 #include <imgui.h>
 #include "PointLightComponent.h"
+#include "VisibilityComponent.h"
+#include "WorldTransforms.h"
+#include "UniformRing.h"
 
 void LightingLayer::OnWindowResize(uint32_t width, uint32_t height) {
 	myAccumulationBuffer->Resize(width, height);
@@ -36,11 +40,14 @@ void LightingLayer::Initialize() {
 	myShadowComposite->LoadPart(ShaderStageType::VertexShader, "shaders/post/post.vs.glsl");
 	myShadowComposite->LoadPart(ShaderStageType::FragmentShader, "shaders/post/shadow_post.fs.glsl");
 	myShadowComposite->Link();
+	myShadowComposite->SetUniform("a_Bias", 0.000001f);
+	myShadowComposite->SetUniform("a_MatShininess", 1.0f); // This should be from the GBuffer
 
 	myPointLightComposite = std::make_shared<Shader>();
 	myPointLightComposite->LoadPart(ShaderStageType::VertexShader, "shaders/post/post.vs.glsl");
 	myPointLightComposite->LoadPart(ShaderStageType::FragmentShader, "shaders/post/blinn-phong-post.fs.glsl");
 	myPointLightComposite->Link();
+	myPointLightComposite->SetUniform("a_MatShininess", 1.0f); // This should be from the GBuffer
 
 	// The final composite shader will handle applying the lighting, and doing our HDR correction for later passes
 	myFinalComposite = std::make_shared<Shader>();
@@ -89,6 +96,8 @@ void LightingLayer::PreRender()
 	using namespace florp::graphics;
 
 	auto& ecs = CurrentRegistry();
+	const WorldTransforms& transforms = ecs.ctx<WorldTransforms>();
+	UniformRing& uniforms = ecs.ctx_or_set<UniformRing>();
 
 	// We'll only handle stuff if we actually have a shadow casting light in the scene
 	auto view = ecs.view<ShadowLight>();
@@ -101,9 +110,6 @@ void LightingLayer::PreRender()
 		// Iterate over all the shadow casting lights
 		Shader::Sptr shader = nullptr;
 		ecs.view<ShadowLight>().each([&](auto entity, ShadowLight& light) {
-			// Get the light's transform
-			const Transform& lightTransform = ecs.get<Transform>(entity);
-
 			// Select which shader to use depending on if the light has a mask or not
 			if (light.Mask == nullptr) {
 				shader = myShader;
@@ -112,9 +118,7 @@ void LightingLayer::PreRender()
 				shader = myMaskedShader;
 				light.Mask->Bind(0);
 			}
-			// Use the shader, and tell it what our output resolution is
 			shader->Use();
-			shader->SetUniform("a_OutputResolution", (glm::vec2)light.ShadowBuffer->GetSize());
 
 			// Bind, viewport, and clear
 			light.ShadowBuffer->Bind();
@@ -122,29 +126,24 @@ void LightingLayer::PreRender()
 			glClear(GL_DEPTH_BUFFER_BIT);
 
 			// Determine the position and matrices for the light
-			glm::vec3 position = lightTransform.GetLocalPosition();
-			glm::mat4 viewMatrix = glm::inverse(lightTransform.GetWorldTransform());
-			glm::mat4 viewProjection = light.Projection * viewMatrix;
+			glm::mat4 viewMatrix = glm::inverse(transforms.GetWorld(entity));
+
+			// The light is the camera for this pass, and the shadow buffer is our output resolution
+			uniforms.Bind(CameraBinding, CameraBlock::FromView(viewMatrix, light.Projection, (glm::vec2)light.ShadowBuffer->GetSize(), florp::app::Timing::GameTime));
 
-			// We're going to iterate over every renderable component
-			auto view = ecs.view<RenderableComponent>();
+			// We're going to iterate over every renderable the culling layer found in the light's frustum
+			const VisibilityComponent& visibility = ecs.get_or_assign<VisibilityComponent>(entity);
 
-			for (const auto& entity : view) {
+			for (entt::entity renderable : visibility.Visible) {
 				// Get our shader
-				const RenderableComponent& renderer = ecs.get<RenderableComponent>(entity);
+				const RenderableComponent& renderer = ecs.get<RenderableComponent>(renderable);
 
 				// Early bail if mesh is invalid (or if if does not cast a shadow)
 				if (renderer.Mesh == nullptr || renderer.Material == nullptr || !renderer.Material->IsShadowCaster)
 					continue;
 								
-				// We'll need some info about the entities position in the world
-				const Transform& transform = ecs.get_or_assign<Transform>(entity);
-
-				// Update the MVP using the item's transform
-				shader->SetUniform(
-					"a_ModelViewProjection",
-					viewProjection *
-					transform.GetWorldTransform());
+				// Upload the item's world transform, from this frame's transform pass
+				uniforms.Bind(ObjectBinding, ObjectBlock::FromWorld(transforms.GetWorld(renderable), transforms.GetNormalMatrix(renderable)));
 
 				// Draw the item
 				renderer.Mesh->Draw(); 
@@ -226,24 +225,10 @@ void LightingLayer::PostProcessShadows() {
 	const AppFrameState& state = ecs.ctx<AppFrameState>();
 	FrameBuffer::Sptr mainBuffer = state.Current.Output;
 
-	// We can extract our near and far plane by reversing the projection calculation
-	float m22 = state.Current.Projection[2][2];
-	float m32 = state.Current.Projection[3][2];
-	float nearPlane = (2.0f * m32) / (2.0f * m22 - 2.0f);
-	float farPlane = ((m22 - 1.0f) * nearPlane) / (m22 + 1.0);
-
-	// We set up all the camera state once, since we use the same shader for compositing all shadow-casting lights
+	// The camera state was worked out once by the render layer, and is shared by every light we composite
+	UniformRing& uniforms = ecs.ctx<UniformRing>();
+	uniforms.BindFrameCamera();
 	myShadowComposite->Use();
-	myShadowComposite->SetUniform("a_View", state.Current.View);
-	glm::mat4 viewInv = glm::inverse(state.Current.View);
-	myShadowComposite->SetUniform("a_ViewInv", viewInv);
-	myShadowComposite->SetUniform("a_CameraPos", glm::vec3(viewInv * glm::vec4(0, 0, 0, 1)));
-	myShadowComposite->SetUniform("a_ProjectionInv", glm::inverse(state.Current.Projection));
-	myShadowComposite->SetUniform("a_ViewProjectionInv", glm::inverse(state.Current.ViewProjection));
-	myShadowComposite->SetUniform("a_NearPlane", nearPlane); 
-	myShadowComposite->SetUniform("a_FarPlane", farPlane);
-	myShadowComposite->SetUniform("a_Bias", 0.000001f);
-	myShadowComposite->SetUniform("a_MatShininess", 1.0f); // This should be from the GBuffer
 
 	// Bind our GBuffer textures (note that we skipped 2, since that's the slot for the shadow sampler)
 	mainBuffer->Bind(0, RenderTargetAttachment::Color0);
@@ -255,24 +240,26 @@ void LightingLayer::PostProcessShadows() {
 	if (view.size() > 0) {
 		view.each([&](auto entity, ShadowLight& light) {
 			// Upload light information to the shader
-			const florp::game::Transform& transform = ecs.get_or_assign<florp::game::Transform>(entity);
-			glm::vec3 pos = glm::vec3(transform.GetWorldTransform() * glm::vec4(0, 0, 0, 1));
+			const glm::mat4& world = ecs.ctx<WorldTransforms>().GetWorld(entity);
+			LightBlock block;
+			block.LightView = light.Projection * glm::inverse(world);
+			block.LightPos = glm::vec3(world * glm::vec4(0, 0, 0, 1));
+			block.LightDir = glm::mat3(world) * glm::vec3(0, 0, -1);
+			block.LightColor = light.Color;
+			block.LightAttenuation = light.Attenuation;
 
 			// If the light has a projector image, we'll treat it as a projector instead
 			if (light.ProjectorImage != nullptr) {
-				myShadowComposite->SetUniform("b_IsProjector", 1);
-				myShadowComposite->SetUniform("a_ProjectorIntensity", light.ProjectorImageIntensity);
+				block.IsProjector = 1;
+				block.ProjectorIntensity = light.ProjectorImageIntensity;
 				light.ProjectorImage->Bind(4);
 			} else { 
-				myShadowComposite->SetUniform("b_IsProjector", 0);
+				block.IsProjector = 0;
+				block.ProjectorIntensity = 0.0f;
 			}
 
 			// Upload the light info to the shader
-			myShadowComposite->SetUniform("a_LightView", light.Projection * glm::inverse(transform.GetWorldTransform()));
-			myShadowComposite->SetUniform("a_LightPos", pos);
-			myShadowComposite->SetUniform("a_LightDir", glm::mat3(transform.GetWorldTransform()) * glm::vec3(0, 0, -1));
-			myShadowComposite->SetUniform("a_LightColor", light.Color);
-			myShadowComposite->SetUniform("a_LightAttenuation", light.Attenuation); 
+			uniforms.Bind(LightBinding, block);
 			
 			// Bind the light's depth and render the quad
 			light.ShadowBuffer->Bind(2, RenderTargetAttachment::Depth);
@@ -290,13 +277,10 @@ void LightingLayer::PostProcessLights() {
 	const AppFrameState& state = ecs.ctx<AppFrameState>();
 	FrameBuffer::Sptr mainBuffer = state.Current.Output;
 	
-	// We set up all the camera state once, since we use the same shader for compositing all shadow-casting lights
+	// The camera state was worked out once by the render layer, and is shared by every light we composite
+	UniformRing& uniforms = ecs.ctx<UniformRing>();
+	uniforms.BindFrameCamera();
 	myPointLightComposite->Use();
-	myPointLightComposite->SetUniform("a_View", state.Current.View);
-	glm::mat4 viewInv = glm::inverse(state.Current.View);
-	myPointLightComposite->SetUniform("a_CameraPos", glm::vec3(viewInv * glm::vec4(0, 0, 0, 1)));
-	myPointLightComposite->SetUniform("a_ViewProjectionInv", glm::inverse(state.Current.ViewProjection));
-	myPointLightComposite->SetUniform("a_MatShininess", 1.0f); // This should be from the GBuffer
 
 	// Bind our G-Buffer to our texture slots
 	mainBuffer->Bind(0, RenderTargetAttachment::Color0); // The color buffer
@@ -308,13 +292,14 @@ void LightingLayer::PostProcessLights() {
 	if (view.size() > 0) {
 		view.each([&](auto entity, PointLightComponent& light) {
 			// Upload light information to the shader
-			const florp::game::Transform& transform = ecs.get_or_assign<florp::game::Transform>(entity);
-			glm::vec3 pos = glm::vec3(transform.GetWorldTransform() * glm::vec4(0, 0, 0, 1));
+			const glm::mat4& world = ecs.ctx<WorldTransforms>().GetWorld(entity);
+			LightBlock block = LightBlock();
+			block.LightPos = glm::vec3(world * glm::vec4(0, 0, 0, 1));
+			block.LightColor = light.Color;
+			block.LightAttenuation = light.Attenuation;
 			
 			// Upload the light info to the shader
-			myPointLightComposite->SetUniform("a_LightPos", pos);
-			myPointLightComposite->SetUniform("a_LightColor", light.Color);
-			myPointLightComposite->SetUniform("a_LightAttenuation", light.Attenuation);
+			uniforms.Bind(LightBinding, block);
 
 			myFullscreenQuad->Draw();
 		});
@@ -2,6 +2,7 @@
 #include "florp/app/Application.h"
 #include "florp/game/SceneManager.h"
 #include "FrameState.h"
+#include "UniformRing.h"
 #include <imgui.h>
 
 PostLayer::PostPass::ShaderParameter PostLayer::__CreateFloatParam(const std::string& name, float defaultValue, float min, float max) {
@@ -124,6 +125,7 @@ void PostLayer::OnWindowResize(uint32_t width, uint32_t height) {
 			(uint32_t)(width * pass->ResolutionMultiplier),
 			(uint32_t)(height * pass->ResolutionMultiplier)
 		);
+		pass->Shader->SetUniform("xScreenRes", glm::ivec2(pass->Output->GetWidth(), pass->Output->GetHeight()));
 	}
 }
 
@@ -165,6 +167,9 @@ void PostLayer::PostRender() {
 	// We'll get the back buffer from the frame state
 	const AppFrameState& state = CurrentRegistry().ctx<AppFrameState>();
 	FrameBuffer::Sptr mainBuffer = state.Current.Output;
+
+	// Expose camera state to shaders, this was worked out once by the render layer and is the same for every pass
+	CurrentRegistry().ctx<UniformRing>().BindFrameCamera();
 	
 	// Unbind the main framebuffer, so that we can read from it
 	//mainBuffer->UnBind();
@@ -173,11 +178,6 @@ void PostLayer::PostRender() {
 	// The last output will start as the output from the rendering
 	FrameBuffer::Sptr lastPass = mainBuffer;
 
-	float m22 = state.Current.Projection[2][2];
-	float m32 = state.Current.Projection[3][2];
-	float nearPlane = (2.0f * m32) / (2.0f * m22 - 2.0f);
-	float farPlane = ((m22 - 1.0f) * nearPlane) / (m22 + 1.0);
-
 	// We'll iterate over all of our render passes
 	for (const PostPass::Sptr& pass : myPasses) {
 		if (pass->Enabled) {
@@ -190,23 +190,6 @@ void PostLayer::PostRender() {
 			// Use the post processing shader to draw the fullscreen quad
 			pass->Shader->Use();
 			lastPass->Bind(0);
-			pass->Shader->SetUniform("xImage", 0); 
-
-			// Expose camera state to shaders
-			pass->Shader->SetUniform("a_View", state.Current.View);
-			pass->Shader->SetUniform("a_Projection", state.Current.Projection); 
-			pass->Shader->SetUniform("a_ProjectionInv", glm::inverse(state.Current.Projection));
-			pass->Shader->SetUniform("a_ViewProjection", state.Current.ViewProjection);
-			pass->Shader->SetUniform("a_ViewProjectionInv", glm::inverse(state.Current.ViewProjection));
-
-			pass->Shader->SetUniform("a_PrevView", state.Last.View); 
-			pass->Shader->SetUniform("a_PrevProjection", state.Last.Projection);
-			pass->Shader->SetUniform("a_PrevProjectionInv", glm::inverse(state.Last.Projection));
-			pass->Shader->SetUniform("a_PrevViewProjection", state.Last.ViewProjection);
-			pass->Shader->SetUniform("a_PrevViewProjectionInv", glm::inverse(state.Last.ViewProjection));
-
-			pass->Shader->SetUniform("a_NearPlane", nearPlane);
-			pass->Shader->SetUniform("a_FarPlane", farPlane);
 
 			// We'll bind all the inputs as textures in the order they were added (starting at index 1)
 			for (size_t ix = 0; ix < pass->Inputs.size(); ix++) {
@@ -223,7 +206,6 @@ void PostLayer::PostRender() {
 					input.Pass->Output->Bind(ix + 1, input.Attachment);
 				}
 			}
-			pass->Shader->SetUniform("xScreenRes", glm::ivec2(pass->Output->GetWidth(), pass->Output->GetHeight()));
 			myFullscreenQuad->Draw();
 
 			// Unbind the output pass so that we can read from it
@@ -279,6 +261,10 @@ PostLayer::PostPass::Sptr PostLayer::__CreatePass(const char* fragmentShader, fl
 	output->AddAttachment(mainColor);
 	output->Validate();
 
+	// These only change when the window does, so there's no need to set them every frame
+	shader->SetUniform("xImage", 0);
+	shader->SetUniform("xScreenRes", glm::ivec2(output->GetWidth(), output->GetHeight()));
+
 	// Return the pass that we just created
 	auto result = std::make_shared<PostPass>();
 	result->Shader = shader;
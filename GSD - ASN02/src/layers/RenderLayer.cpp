@@ -5,33 +5,30 @@
 #include <florp\game\Transform.h>
 #include "CameraComponent.h"
 #include "FrameState.h"
+#include "VisibilityComponent.h"
+#include "WorldTransforms.h"
+#include "UniformRing.h"
+#include <imgui.h>
+#include <chrono>
 
 typedef florp::game::RenderableComponent Renderable;
+typedef std::chrono::high_resolution_clock BenchClock;
 
-void sortRenderers(entt::registry& reg) {
-	// We sort our mesh renderers based on material properties
-	// This will group all of our meshes based on shader first, then material second
-	reg.sort<florp::game::RenderableComponent>([](const florp::game::RenderableComponent& lhs, const florp::game::RenderableComponent& rhs) {
-		if (rhs.Material == nullptr || rhs.Mesh == nullptr)
-			return false;
-		else if (lhs.Material == nullptr || lhs.Mesh == nullptr)
-			return true;
-		else if (lhs.Material->RasterState.Blending.BlendEnabled & !rhs.Material->RasterState.Blending.BlendEnabled)
-			return false;
-		else if ((!lhs.Material->RasterState.Blending.BlendEnabled) & rhs.Material->RasterState.Blending.BlendEnabled)
-			return true;
-		else if (lhs.Material->GetShader() != rhs.Material->GetShader())
-			return lhs.Material->GetShader() < rhs.Material->GetShader();
-		else
-			return lhs.Material < rhs.Material;
-		});
-}
+// How many queue items each job records at a time, and so how many items each command list covers
+static const uint32_t RECORD_GRAIN = 512;
+
+bool RenderLayer::RunBenchmark = false;
 
-void ctorSort(entt::entity, entt::registry& ecs, const Renderable& r) {
-	sortRenderers(ecs);
+// Returns the time between two points in microseconds
+static double ElapsedMicroseconds(BenchClock::time_point start, BenchClock::time_point end) {
+	return std::chrono::duration<double, std::micro>(end - start).count();
 }
-void dtorSort(entt::entity, entt::registry& ecs) {
-	sortRenderers(ecs);
+
+void RenderLayer::Initialize() {
+	myInstances = std::make_shared<InstanceBuffer>();
+	myJobs = std::make_shared<JobSystem>();
+	if (RunBenchmark)
+		myBenchmark = std::make_shared<RenderBenchmark>();
 }
 
 void RenderLayer::OnWindowResize(uint32_t width, uint32_t height)
@@ -47,8 +44,20 @@ void RenderLayer::OnWindowResize(uint32_t width, uint32_t height)
 }
 
 void RenderLayer::OnSceneEnter() {
-	CurrentRegistry().on_construct<Renderable>().connect<&::ctorSort>();
-	CurrentRegistry().on_destroy<Renderable>().connect<&::dtorSort>();
+	// The queue picks up renderables as they are created and destroyed, instead of re-sorting the registry each time
+	myRenderQueue.Connect(CurrentRegistry());
+}
+
+bool RenderLayer::IsInstanced(const florp::graphics::Shader::Sptr& shader) {
+	auto it = myInstancedShaders.find(shader.get());
+	if (it != myInstancedShaders.end())
+		return it->second;
+
+	// Instanced shaders take their model matrix from the instance attributes, anything else gets it as a uniform
+	GLint location = glGetAttribLocation(shader->GetRenderID(), "inModel");
+	bool instanced = location == InstanceBuffer::MODEL_LOCATION;
+	myInstancedShaders[shader.get()] = instanced;
+	return instanced;
 }
 
 void RenderLayer::Render()
@@ -57,17 +66,28 @@ void RenderLayer::Render()
 	using namespace florp::graphics;
 
 	auto& ecs = CurrentRegistry();
+	const WorldTransforms& transforms = ecs.ctx<WorldTransforms>();
+	UniformRing& uniforms = ecs.ctx_or_set<UniformRing>();
 
-	Material::Sptr material = nullptr;
-	Shader::Sptr boundShader = nullptr;
+	myDrawCalls = 0;
+	myInstancedDraws = 0;
+	myInstancesDrawn = 0;
+	myRenderablesDrawn = 0;
+	myBuildTime = 0.0;
+	myRecordTime = 0.0;
+	myReplayTime = 0.0;
+	myInstances->BeginFrame();
+
+	// The benchmark steps through the thread counts, one every few hundred frames
+	bool benchmarking = myBenchmark != nullptr && myBenchmark->IsRunning();
+	if (benchmarking && myJobs->GetThreadCount() != myBenchmark->GetThreadCount())
+		myJobs = std::make_shared<JobSystem>(myBenchmark->GetThreadCount());
 
 	ecs.sort<CameraComponent>([](const CameraComponent& lhs, const CameraComponent& rhs) {
 		return rhs.IsMainCamera;
 	});
 
 	ecs.view<CameraComponent>().each([&](auto entity, CameraComponent& cam) {
-		const Transform& camTransform = ecs.get<florp::game::Transform>(entity);
-		
 		cam.BackBuffer->Bind();
 		glViewport(0, 0, cam.BackBuffer->GetWidth(), cam.BackBuffer->GetHeight());
 		glClearColor(cam.ClearCol.x, cam.ClearCol.y, cam.ClearCol.z, cam.ClearCol.w);
@@ -75,58 +95,35 @@ void RenderLayer::Render()
 		glEnable(GL_DEPTH_TEST);
 		glEnable(GL_CULL_FACE);
 
-		glm::vec3 position = camTransform.GetLocalPosition();
-		glm::mat4 viewMatrix = glm::inverse(camTransform.GetWorldTransform());
+		const glm::mat4& camWorld = transforms.GetWorld(entity);
+		glm::mat4 viewMatrix = glm::inverse(camWorld);
 		glm::mat4 viewProjection = cam.Projection * viewMatrix;
 
-		// A view will let us iterate over all of our entities that have the given component types
-		auto view = ecs.view<Renderable>();
+		// Everything the shaders need to know about the camera goes up once, for every shader drawn from it
+		uniforms.Bind(CameraBinding, CameraBlock::FromView(viewMatrix, cam.Projection, (glm::vec2)cam.BackBuffer->GetSize(), florp::app::Timing::GameTime));
 
-		for (const auto& entity : view) {
+		// Sort everything this camera can see, opaque front to back and grouped by shader and material, then blended back to front.
+		// Renderables without a mesh or material are left out, and so is anything the culling layer found outside the frustum.
+		// The benchmark skips the culling, so that every renderable in the scene goes through the queue
+		BenchClock::time_point start = BenchClock::now();
+		const VisibilityComponent* visibility = ecs.has<VisibilityComponent>(entity) && !benchmarking ? &ecs.get<VisibilityComponent>(entity) : nullptr;
+		myRenderQueue.Build(ecs, transforms, viewMatrix, visibility != nullptr ? &visibility->Visible : nullptr, myJobs.get());
+		BenchClock::time_point built = BenchClock::now();
+		myBuildTime += ElapsedMicroseconds(start, built);
 
-			// Get our shader
-			const Renderable& renderer = ecs.get<Renderable>(entity);
-
-			// Early bail if mesh is invalid
-			if (renderer.Mesh == nullptr || renderer.Material == nullptr)
-				continue;
+		// Every item gets an instance, written alongside its draw packet on the job system's threads
+		uint32_t itemCount = (uint32_t)myRenderQueue.GetItems().size();
+		uint32_t baseInstance = 0;
+		InstanceBuffer::Instance* instances = itemCount > 0 ? myInstances->Allocate(itemCount, baseInstance) : nullptr;
+		uint32_t listCount = Record(ecs, transforms, instances);
+		BenchClock::time_point recorded = BenchClock::now();
+		myRecordTime += ElapsedMicroseconds(built, recorded);
 
-			// If our shader has changed, we need to bind it and update our frame-level uniforms
-			if (renderer.Material->GetShader() != boundShader) {
-				boundShader = renderer.Material->GetShader();
-				boundShader->Use();
-				boundShader->SetUniform("a_CameraPos", position);
-				boundShader->SetUniform("a_Time", florp::app::Timing::GameTime);
-			}
-
-			// If our material has changed, we need to apply it to the shader
-			if (renderer.Material != material) {
-				material = renderer.Material;
-				material->Apply();
-			}
+		// Then the GL thread only has to go through the packets and draw them
+		Replay(transforms, uniforms, baseInstance, listCount);
+		myReplayTime += ElapsedMicroseconds(recorded, BenchClock::now());
+		myRenderablesDrawn += (int)itemCount;
 
-			// We'll need some info about the entities position in the world
-			const Transform& transform = ecs.get_or_assign<Transform>(entity);
-
-			// Our normal matrix is the inverse-transpose of our object's world rotation
-			glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(transform.GetWorldTransform())));
-
-			// Update the MVP using the item's transform
-			boundShader->SetUniform(
-				"a_ModelViewProjection",
-				viewProjection *
-				transform.GetWorldTransform());
-
-			// Update the model matrix to the item's world transform
-			boundShader->SetUniform("a_Model", transform.GetWorldTransform());
-
-			// Update the model matrix to the item's world transform
-			boundShader->SetUniform("a_NormalMatrix", normalMatrix);
-
-			// Draw the item
-			renderer.Mesh->Draw();
-		}
-		
 		cam.BackBuffer->UnBind();
 		
 		// If there's a front buffer, then this camera is double-buffered
@@ -147,6 +144,115 @@ void RenderLayer::Render()
 			state.Current.View = viewMatrix;
 			state.Current.Projection = cam.Projection;
 			state.Current.ViewProjection = viewProjection;
+
+			// The lighting and post passes all draw from the main camera, so its block is worked out once for all of them
+			uniforms.SetFrameCamera(CameraBlock::FromFrameState(state, (glm::vec2)state.Current.Output->GetSize(), florp::app::Timing::GameTime));
 		}
 	});
+
+	myInstances->EndFrame();
+
+	if (benchmarking)
+		myBenchmark->AddFrame(myRenderablesDrawn, myBuildTime, myRecordTime, myReplayTime);
+}
+
+uint32_t RenderLayer::Record(entt::registry& registry, const WorldTransforms& transforms, InstanceBuffer::Instance* instances) {
+	const std::vector<RenderQueue::Item>& items = myRenderQueue.GetItems();
+	uint32_t itemCount = (uint32_t)items.size();
+	uint32_t listCount = (itemCount + RECORD_GRAIN - 1) / RECORD_GRAIN;
+	if (myCommandLists.size() < listCount)
+		myCommandLists.resize(listCount);
+
+	// Nothing in here can touch GL or change the registry, the renderables are looked up through a view since that
+	// never creates pools, and each chunk only writes to its own command list and instances
+	auto renderables = registry.view<Renderable>();
+	myJobs->ParallelFor(itemCount, RECORD_GRAIN, [&](uint32_t begin, uint32_t end, uint32_t thread) {
+		std::vector<DrawPacket>& commands = myCommandLists[begin / RECORD_GRAIN];
+		commands.clear();
+		for (uint32_t ix = begin; ix < end; ix++) {
+			entt::entity entity = items[ix].Entity;
+			const Renderable& renderer = renderables.get<Renderable>(entity);
+			InstanceBuffer::Write(instances[ix], transforms.GetWorld(entity), transforms.GetNormalMatrix(entity));
+
+			// The queue keeps everything with the same mesh and material together, so most items extend the last run
+			if (!commands.empty() && commands.back().Renderer->Mesh == renderer.Mesh && commands.back().Renderer->Material == renderer.Material)
+				commands.back().Count++;
+			else
+				commands.push_back({ &renderer, ix, 1 });
+		}
+	});
+
+	return listCount;
+}
+
+void RenderLayer::Replay(const WorldTransforms& transforms, UniformRing& uniforms, uint32_t baseInstance, uint32_t listCount) {
+	using namespace florp::graphics;
+
+	const std::vector<RenderQueue::Item>& items = myRenderQueue.GetItems();
+
+	// Materials are applied per camera, so everything gets re-bound
+	Material::Sptr material = nullptr;
+	Shader::Sptr boundShader = nullptr;
+	bool instanced = false;
+
+	auto draw = [&](const DrawPacket& run) {
+		const Renderable& renderer = *run.Renderer;
+
+		// If our shader has changed, we need to bind it, the camera block is already shared by all of them
+		if (renderer.Material->GetShader() != boundShader) {
+			boundShader = renderer.Material->GetShader();
+			boundShader->Use();
+			instanced = IsInstanced(boundShader);
+		}
+
+		// If our material has changed, we need to apply it to the shader
+		if (renderer.Material != material) {
+			material = renderer.Material;
+			material->Apply();
+		}
+
+		// The instances were all written by Record, so a run only takes one call
+		if (instanced && myInstances->CanInstance(renderer.Mesh)) {
+			myInstances->Draw(renderer.Mesh, run.Count, baseInstance + run.First);
+			myDrawCalls++;
+			myInstancedDraws++;
+			myInstancesDrawn += run.Count;
+			return;
+		}
+
+		// Otherwise each item is drawn on its own, the world and normal matrices go up as one block
+		for (uint32_t ix = run.First; ix < run.First + run.Count; ix++) {
+			entt::entity entity = items[ix].Entity;
+			uniforms.Bind(ObjectBinding, ObjectBlock::FromWorld(transforms.GetWorld(entity), transforms.GetNormalMatrix(entity)));
+			renderer.Mesh->Draw();
+			myDrawCalls++;
+		}
+	};
+
+	// A run that was split over the end of a chunk carries on at the start of the next one, and its instances are
+	// still next to each other, so the two halves go back together before drawing
+	DrawPacket run = { nullptr, 0, 0 };
+	for (uint32_t list = 0; list < listCount; list++) {
+		for (const DrawPacket& packet : myCommandLists[list]) {
+			if (run.Count > 0 && run.Renderer->Mesh == packet.Renderer->Mesh && run.Renderer->Material == packet.Renderer->Material) {
+				run.Count += packet.Count;
+				continue;
+			}
+			if (run.Count > 0)
+				draw(run);
+			run = packet;
+		}
+	}
+	if (run.Count > 0)
+		draw(run);
+}
+
+void RenderLayer::RenderGUI()
+{
+	ImGui::Begin("Render Stats");
+	ImGui::Text("Draw calls: %d", myDrawCalls);
+	ImGui::Text("Instanced: %d draws, %d instances", myInstancedDraws, myInstancesDrawn);
+	ImGui::Text("Renderables: %d", myRenderablesDrawn);
+	ImGui::Text("CPU: %.0fus build, %.0fus record, %.0fus replay on %d threads", myBuildTime, myRecordTime, myReplayTime, (int)myJobs->GetThreadCount());
+	ImGui::End();
 }
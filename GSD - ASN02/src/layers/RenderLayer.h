@@ -1,14 +1,85 @@
 #pragma once
 #include "florp/app/ApplicationLayer.h"
+#include "florp/graphics/Shader.h"
 #include "FrameBuffer.h"
+#include "RenderQueue.h"
+#include "InstanceBuffer.h"
+#include "UniformRing.h"
+#include "JobSystem.h"
+#include "RenderBenchmark.h"
+#include "WorldTransforms.h"
+#include <unordered_map>
 
 class RenderLayer : public florp::app::ApplicationLayer
 {
 public:
+	// Set from the command line to time the layer at each thread count, see RenderBenchmark
+	static bool RunBenchmark;
+
+	// Sets up the instance buffer and the job system
+	virtual void Initialize() override;
+
 	virtual void OnWindowResize(uint32_t width, uint32_t height) override;
 	
 	virtual void OnSceneEnter() override;
 	
 	// Render will be where we actually perform our rendering
 	virtual void Render() override;
+
+	// Shows how many draw calls the last frame took
+	virtual void RenderGUI() override;
+
+protected:
+	// A run of items next to each other in the render queue that share a mesh and material
+	struct DrawPacket {
+		const florp::game::RenderableComponent* Renderer; // the first renderable in the run, for the mesh and material
+		uint32_t First; // the index of the first item in the queue, which is also the index of its instance
+		uint32_t Count;
+	};
+
+	// Keeps the renderables sorted by state and depth, rebuilt for each camera
+	RenderQueue myRenderQueue;
+	// Holds the transforms for instanced draws
+	InstanceBuffer::Sptr myInstances;
+	// Whether each shader reads its transforms from instance attributes (like lighting_instanced.vs.glsl) instead of uniforms
+	std::unordered_map<const void*, bool> myInstancedShaders;
+
+	// Spreads the key packing and recording over the cores
+	JobSystem::Sptr myJobs;
+	// The draw packets for each chunk of the render queue, recorded by whichever thread ran that chunk. Keeping a
+	// list per chunk instead of per thread means they replay in queue order without having to be merged
+	std::vector<std::vector<DrawPacket>> myCommandLists;
+	// Only set when RunBenchmark is
+	RenderBenchmark::Sptr myBenchmark;
+
+	// Counters for the last frame, across every camera
+	int myDrawCalls = 0;
+	int myInstancedDraws = 0;
+	int myInstancesDrawn = 0;
+	int myRenderablesDrawn = 0;
+	// Microseconds spent on the CPU last frame, in each part of the layer
+	double myBuildTime = 0.0;
+	double myRecordTime = 0.0;
+	double myReplayTime = 0.0;
+
+	bool IsInstanced(const florp::graphics::Shader::Sptr& shader);
+
+	/*
+	 * Writes an instance for every item in the render queue, and records the runs of items to draw together. The
+	 * queue is split into chunks spread over the job system, with a command list for each
+	 * @param registry The registry the queue was built from
+	 * @param transforms The world transforms for this frame
+	 * @param instances Where to write the instances, one per item in the queue
+	 * @returns The number of command lists that were recorded
+	 */
+	uint32_t Record(entt::registry& registry, const WorldTransforms& transforms, InstanceBuffer::Instance* instances);
+	/*
+	 * Draws the packets in the command lists, merging runs that were split between chunks. This is the only part
+	 * that makes GL calls, so it runs on the main thread
+	 * @param transforms The world transforms for this frame, for the items that can't be instanced
+	 * @param uniforms The ring to upload the per-object blocks to
+	 * @param baseInstance Where the instances written by Record start
+	 * @param listCount The number of command lists that were recorded
+	 */
+	void Replay(const WorldTransforms& transforms, UniformRing& uniforms, uint32_t baseInstance, uint32_t listCount);
 };
@@ -13,10 +13,23 @@
 #include <ControlBehaviour.h>
 #include <ShadowLight.h>
 #include "PointLightComponent.h"
+#include "BoundsComponent.h"
 
-// Audio Behaviours
-#include "AudioMovementBehaviour.h"
-#include "ListenerBehaviour.h"
+// Audio Components
+#include "AudioListenerComponent.h"
+#include "AudioOccluderComponent.h"
+
+int SceneBuilder::StressTestCount = 0;
+
+// The bounds of monkey.obj, shared by culling and audio occlusion
+static const glm::vec3 MONKEY_MIN = glm::vec3(-0.852f, -1.368f, -0.008f);
+static const glm::vec3 MONKEY_MAX = glm::vec3(0.852f, 1.368f, 0.985f);
+
+// The floor is one big flat cube just below the origin
+static const glm::vec3 FLOOR_CENTER = glm::vec3(0.0f, -1.0f, 0.0f);
+static const glm::vec3 FLOOR_SIZE = glm::vec3(100.0f, 0.1f, 100.0f);
+static const glm::vec3 FLOOR_MIN = FLOOR_CENTER - FLOOR_SIZE * 0.5f;
+static const glm::vec3 FLOOR_MAX = FLOOR_CENTER + FLOOR_SIZE * 0.5f;
 
 /*
  * Helper function for creating a shadow casting light
@@ -81,7 +94,8 @@ void SceneBuilder::Initialize()
 	MeshData data = ObjLoader::LoadObj("monkey.obj", glm::vec4(1.0f));
 
 	Shader::Sptr shader = std::make_shared<Shader>();
-	shader->LoadPart(ShaderStageType::VertexShader, "shaders/lighting.vs.glsl");
+	// The instanced variant, so copies of the same mesh and material are drawn together
+	shader->LoadPart(ShaderStageType::VertexShader, "shaders/lighting_instanced.vs.glsl");
 	shader->LoadPart(ShaderStageType::FragmentShader, "shaders/forward.fs.glsl"); 
 	shader->Link();
 
@@ -93,18 +107,45 @@ void SceneBuilder::Initialize()
 	mat2->Set("s_Albedo", Texture2D::LoadFromFile("polka.png", false, true, true));
 
 
+	// Every monkey shares the same mesh
+	Mesh::Sptr monkeyMesh = MeshBuilder::Bake(data);
+
 	// The central monkey
 	{
 		entt::entity eMonkey = scene->CreateEntity();
 		RenderableComponent& renderable = scene->Registry().assign<RenderableComponent>(eMonkey);
-		renderable.Mesh = MeshBuilder::Bake(data);
+		renderable.Mesh = monkeyMesh;
 		renderable.Material = mat;
 		Transform& t = scene->Registry().get<Transform>(eMonkey);
 		t.SetPosition(glm::vec3(0, 0, -10));
+
+		// Its bounds, for culling
+		BoundsComponent& bounds = scene->Registry().assign<BoundsComponent>(eMonkey);
+		bounds.Min = MONKEY_MIN;
+		bounds.Max = MONKEY_MAX;
 		
-		// no audio movement (TODO: add it back in?)
-		// Make our monkeys spin around the center
-		// scene->AddBehaviour<AudioMovementBehaviour>(eMonkey);
+		// It also muffles anything behind it
+		AudioOccluderComponent& occluder = scene->Registry().assign<AudioOccluderComponent>(eMonkey);
+		occluder.Min = MONKEY_MIN;
+		occluder.Max = MONKEY_MAX;
+	}
+
+	// The stress test, a square grid of monkeys behind the central one in alternating materials
+	if (StressTestCount > 0) {
+		int side = (int)glm::ceil(glm::sqrt((float)StressTestCount));
+		for (int ix = 0; ix < StressTestCount; ix++) {
+			int row = ix / side;
+			int column = ix % side;
+			entt::entity entity = scene->CreateEntity();
+			RenderableComponent& renderable = scene->Registry().assign<RenderableComponent>(entity);
+			renderable.Mesh = monkeyMesh;
+			renderable.Material = (row + column) % 2 == 0 ? mat : mat2;
+			BoundsComponent& bounds = scene->Registry().assign<BoundsComponent>(entity);
+			bounds.Min = MONKEY_MIN;
+			bounds.Max = MONKEY_MAX;
+			Transform& t = scene->Registry().get<Transform>(entity);
+			t.SetPosition(glm::vec3((column - side / 2) * 3.0f, 0.0f, -15.0f - row * 3.0f));
+		}
 	}
 	
 	
@@ -146,7 +187,8 @@ void SceneBuilder::Initialize()
 
 		// We'll add our control behaviour so that we can fly the camera around
 		scene->AddBehaviour<ControlBehaviour>(camera, glm::vec3(5.0f));
-		scene->AddBehaviour<ListenerBehaviour>(camera);
+		// The audio is heard from the camera
+		scene->Registry().assign<AudioListenerComponent>(camera);
 
 
 	}
@@ -157,7 +199,7 @@ void SceneBuilder::Initialize()
 	{
 		// Building the mesh
 		MeshData data = MeshBuilder::Begin();
-		MeshBuilder::AddAlignedCube(data, glm::vec3(0.0f, -1.0f, 0.0), glm::vec3(100.0f, 0.1f, 100.0f));
+		MeshBuilder::AddAlignedCube(data, FLOOR_CENTER, FLOOR_SIZE);
 		Mesh::Sptr mesh = MeshBuilder::Bake(data);
 
 		// Creating the entity and attaching the renderable
@@ -165,5 +207,14 @@ void SceneBuilder::Initialize()
 		RenderableComponent& renderable = scene->Registry().assign<RenderableComponent>(entity);
 		renderable.Mesh = MeshBuilder::Bake(data);
 		renderable.Material = mat;
+
+		BoundsComponent& bounds = scene->Registry().assign<BoundsComponent>(entity);
+		bounds.Min = FLOOR_MIN;
+		bounds.Max = FLOOR_MAX;
+
+		// Sound from under the floor is blocked by the same cube
+		AudioOccluderComponent& occluder = scene->Registry().assign<AudioOccluderComponent>(entity);
+		occluder.Min = FLOOR_MIN;
+		occluder.Max = FLOOR_MAX;
 	}
 }
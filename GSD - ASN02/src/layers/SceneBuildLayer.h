@@ -4,4 +4,7 @@
 class SceneBuilder : public florp::app::ApplicationLayer {
 public:
 	void Initialize() override;
+
+	// How many extra monkeys to fill the scene with, for stress testing the renderer (set with --stress on the command line)
+	static int StressTestCount;
 };
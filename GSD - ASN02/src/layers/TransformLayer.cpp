@@ -0,0 +1,17 @@
+#include "TransformLayer.h"
+#include <florp\game\SceneManager.h>
+#include "WorldTransforms.h"
+#include <imgui.h>
+
+void TransformLayer::PreRender()
+{
+	auto& ecs = CurrentRegistry();
+	myRecalculated = ecs.ctx_or_set<WorldTransforms>().Update(ecs);
+}
+
+void TransformLayer::RenderGUI()
+{
+	ImGui::Begin("Render Stats");
+	ImGui::Text("Transforms: %d recalculated", myRecalculated);
+	ImGui::End();
+}
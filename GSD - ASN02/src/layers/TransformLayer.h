@@ -0,0 +1,18 @@
+#pragma once
+#include "florp/app/ApplicationLayer.h"
+
+/*
+ * Works out the world and normal matrices of everything in the scene once per frame, after the behaviours have
+ * moved things and before anything is culled or rendered. The results are kept in the registry's WorldTransforms.
+ */
+class TransformLayer : public florp::app::ApplicationLayer
+{
+public:
+	virtual void PreRender() override;
+
+	// Shows how many transforms were recalculated
+	virtual void RenderGUI() override;
+
+protected:
+	int myRecalculated = 0;
+};
@@ -2,14 +2,46 @@
 #include "florp/game/BehaviourLayer.h"
 #include "florp/game/ImGuiLayer.h"
 #include "layers/SceneBuildLayer.h"
+#include "layers/TransformLayer.h"
+#include "layers/CullingLayer.h"
 #include "layers/RenderLayer.h"
 #include "layers/PostLayer.h"
 #include "layers/AudioLayer.h"
 #include "layers/LightingLayer.h"
 #include "florp/graphics/TextureCube.h"
+#include "AudioBenchmarks.h"
+#include <cstring>
+#include <cstdlib>
 
-int main()
+int main(int argc, char** argv)
 {
+	// Run the audio benchmarks instead of the application if requested
+	if (argc > 1 && strcmp(argv[1], "--audio-bench") == 0)
+	{
+		AudioBenchmarks::RunAll(argc > 2 && strcmp(argv[2], "--headless") == 0);
+		return 0;
+	}
+
+	// Or render the car crash offline, for checking the output against a known good one
+	if (argc > 1 && strcmp(argv[1], "--audio-render") == 0)
+	{
+		AudioBenchmarks::CarCrashRender(argc > 2 && strcmp(argv[2], "--headless") == 0);
+		return 0;
+	}
+
+	// Fill the scene with extra monkeys, to see how the renderer holds up
+	if (argc > 1 && strcmp(argv[1], "--stress") == 0)
+	{
+		SceneBuilder::StressTestCount = argc > 2 ? atoi(argv[2]) : 10000;
+	}
+
+	// Or time the render layer at each thread count, with every renderable in the queue
+	if (argc > 1 && strcmp(argv[1], "--render-bench") == 0)
+	{
+		SceneBuilder::StressTestCount = argc > 2 ? atoi(argv[2]) : 50000;
+		RenderLayer::RunBenchmark = true;
+	}
+
 	{
 		// Create our application
 		florp::app::Application* app = new florp::app::Application();
@@ -19,6 +51,8 @@ int main()
 		app->AddLayer<florp::game::ImGuiLayer>();
 		app->AddLayer<AudioLayer>();
 		app->AddLayer<SceneBuilder>();
+		app->AddLayer<TransformLayer>();
+		app->AddLayer<CullingLayer>();
 		app->AddLayer<RenderLayer>();
 		app->AddLayer<LightingLayer>();
 		app->AddLayer<PostLayer>();